@@ -8,7 +8,11 @@
 #include <nlohmann/json.hpp>
 #include "../../common/include/logging.hpp"
 #include "../../common/include/persistence.hpp"
+#include "../../common/include/write_behind.hpp"
+#include "../../common/include/versioned_state.hpp"
 #include "../../common/include/someip_shim.hpp"
+#include "../../common/include/heartbeat.hpp"
+#include "../../common/include/lifecycle.hpp"
 
 using json = nlohmann::json;
 using namespace common;
@@ -20,86 +24,86 @@ int main()
     const int rpc_port = 5003;
     std::atomic_bool running{false};
     std::thread server_thread;
-    std::mutex state_mtx;
 
-    // persistent state
-    json state;
+    // persistent state; handlers publish new versions, readers never wait on them
+    VersionedState<json> state(json::object());
     const std::string persist_file = "climate_state.json";
-    load_json(persist_file, state);
-    if (state.empty()) {
-        state["temperature"] = 22;
-        state["fan_speed"] = 3;
-        state["mode"] = "auto";
-        state["ac_enabled"] = true;
+    // Handlers only mark the state dirty; it is written behind them, once per burst,
+    // through the persistency daemon when it runs
+    WriteBehind::Options persist_opts;
+    persist_opts.persistency_service = "climate";
+    WriteBehind persist(persist_file, [&]() {
+        return *state.read();
+    }, persist_opts);
+    state.store(persist.load());
+    if (state.read()->empty()) {
+        state.store(json{{"temperature", 22}, {"fan_speed", 3}, {"mode", "auto"}, {"ac_enabled", true}});
     }
 
+    // Publish `value` under `key` if it differs; persists only real changes
+    auto setValue = [&](const std::string &key, const json &value, json &resp) {
+        bool changed = false;
+        state.update([&](json &s) {
+            changed = s[key] != value;
+            if (changed) s[key] = value;
+            resp["state"] = s;
+            return changed;
+        });
+        if (changed) persist.markDirty();
+    };
+
     // register with Service Manager
     json reg;
     reg["type"] = "register";
     reg["service"] = "climate";
     reg["host"] = "127.0.0.1";
     reg["port"] = rpc_port;
+    reg["service_type"] = "Climate";
     json ignored_reply;
     send_message("127.0.0.1", 4000, reg, ignored_reply);
     log_info("Registered with Service Manager");
 
+    // heartbeat over the Service Manager's binary datagram channel
+    heartbeat::HeartbeatSender heartbeats("127.0.0.1");
+    heartbeats.add("climate");
+    heartbeats.start(std::chrono::milliseconds(100));
+
     // RPC handler
     auto handler = [&](const json &req, const std::string &peer){
         json resp;
         try {
             std::string method = req.value("method", "");
             if (method == "set_temperature") {
-                int temp = req.at("params").value("temperature", state.value("temperature", 22));
+                int temp = req.at("params").value("temperature", state.read()->value("temperature", 22));
                 // Clamp temperature between 16 and 32 Celsius
                 temp = std::max(16, std::min(32, temp));
-                {
-                    std::lock_guard<std::mutex> lk(state_mtx);
-                    state["temperature"] = temp;
-                    save_json(persist_file, state);
-                }
+                setValue("temperature", temp, resp);
                 resp["result"] = "ok";
-                resp["state"] = state;
                 log_info("Temperature set to " + std::to_string(temp) + "°C");
             } else if (method == "set_fan_speed") {
-                int fan = req.at("params").value("fan_speed", state.value("fan_speed", 3));
+                int fan = req.at("params").value("fan_speed", state.read()->value("fan_speed", 3));
                 // Clamp fan speed between 0 (off) and 5 (max)
                 fan = std::max(0, std::min(5, fan));
-                {
-                    std::lock_guard<std::mutex> lk(state_mtx);
-                    state["fan_speed"] = fan;
-                    save_json(persist_file, state);
-                }
+                setValue("fan_speed", fan, resp);
                 resp["result"] = "ok";
-                resp["state"] = state;
                 log_info("Fan speed set to " + std::to_string(fan));
             } else if (method == "set_mode") {
-                std::string mode = req.at("params").value("mode", state.value("mode", std::string("auto")));
+                std::string mode = req.at("params").value("mode", state.read()->value("mode", std::string("auto")));
                 // Validate mode
                 if (mode != "auto" && mode != "cool" && mode != "heat" && mode != "dry") {
                     resp["error"] = "invalid_mode";
                     return;
                 }
-                {
-                    std::lock_guard<std::mutex> lk(state_mtx);
-                    state["mode"] = mode;
-                    save_json(persist_file, state);
-                }
+                setValue("mode", mode, resp);
                 resp["result"] = "ok";
-                resp["state"] = state;
                 log_info("Mode set to " + mode);
             } else if (method == "set_ac") {
-                bool ac_on = req.at("params").value("ac_enabled", state.value("ac_enabled", true));
-                {
-                    std::lock_guard<std::mutex> lk(state_mtx);
-                    state["ac_enabled"] = ac_on;
-                    save_json(persist_file, state);
-                }
+                bool ac_on = req.at("params").value("ac_enabled", state.read()->value("ac_enabled", true));
+                setValue("ac_enabled", ac_on, resp);
                 resp["result"] = "ok";
-                resp["state"] = state;
                 log_info(std::string("AC ") + (ac_on ? "enabled" : "disabled"));
             } else if (method == "get_state") {
-                std::lock_guard<std::mutex> lk(state_mtx);
-                resp["state"] = state;
+                resp["state"] = *state.read();
             } else {
                 resp["error"] = "unknown_method";
             }
@@ -110,12 +114,18 @@ int main()
         std::cout << "Handled RPC (peer=" << peer << "): req=" << req.dump() << ", resp=" << resp.dump() << std::endl;
     };
 
-    if (!start_server(rpc_port, handler, server_thread, running)) {
-        log_error("Failed to start climate RPC server");
-        return 1;
-    }
+    // The shim has no RPC transport yet; like media_service, keep a placeholder
+    // server thread until send_message delivers requests to `handler`
+    (void)handler;
     running = true;
+    server_thread = std::thread([&]() {
+        log_info("Climate RPC server thread started");
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
     log_info("Climate Service RPC listening on port " + std::to_string(rpc_port));
+    lifecycle::notifyReady();
 
     // Sensor simulation / temperature monitoring thread
     std::thread sensor_thread([&](){
@@ -126,36 +136,43 @@ int main()
             json ev;
             bool should_send = false;
             {
-                std::lock_guard<std::mutex> lk(state_mtx);
                 // Simulate ambient temperature change
                 ambient_temp += (std::rand() % 3) - 1; // +1, 0, or -1
                 ambient_temp = std::max(15, std::min(35, ambient_temp));
-                
-                // Simulate temperature adjustment based on AC mode
-                int current_temp = state.value("temperature", 22);
-                if (state.value("ac_enabled", true)) {
-                    if (state.value("mode", std::string("auto")) == "cool" && current_temp > ambient_temp - 2) {
-                        current_temp--;
-                    } else if (state.value("mode", std::string("auto")) == "heat" && current_temp < ambient_temp + 2) {
-                        current_temp++;
+
+                // Simulate temperature adjustment based on AC mode; persist only
+                // when the simulated temperature actually moved
+                bool moved = false;
+                state.update([&](json &s) {
+                    int current_temp = s.value("temperature", 22);
+                    if (s.value("ac_enabled", true)) {
+                        if (s.value("mode", std::string("auto")) == "cool" && current_temp > ambient_temp - 2) {
+                            current_temp--;
+                        } else if (s.value("mode", std::string("auto")) == "heat" && current_temp < ambient_temp + 2) {
+                            current_temp++;
+                        }
                     }
-                }
-                state["temperature"] = current_temp;
-                save_json(persist_file, state);
-                
+                    moved = current_temp != s.value("temperature", 22);
+                    if (moved) s["temperature"] = current_temp;
+                    return moved;
+                });
+                if (moved) persist.markDirty();
+
+                auto snap = state.read();
                 ev["type"] = "event";
                 ev["service"] = "climate";
                 ev["event"] = "temperature_update";
-                ev["current_temperature"] = state["temperature"];
+                ev["current_temperature"] = snap->value("temperature", 22);
                 ev["ambient_temperature"] = ambient_temp;
-                ev["mode"] = state["mode"];
-                ev["fan_speed"] = state["fan_speed"];
+                ev["mode"] = snap->value("mode", std::string("auto"));
+                ev["fan_speed"] = snap->value("fan_speed", 3);
                 should_send = true;
             }
             if (should_send) {
                 json r;
-                if (!send_message("127.0.0.1", 4000, ev, r)) {
-                    log_warn("Failed to send climate event to service manager");
+                send_message("127.0.0.1", 4000, ev, r);
+                if (r.contains("error")) {
+                    log_warning("Failed to send climate event to service manager");
                 } else {
                     log_info("Sent temperature update event");
                 }
@@ -163,15 +180,18 @@ int main()
         }
     });
 
+    // Launched by the Service Manager: no terminal, run until terminated
+    const bool managed = lifecycle::isManaged();
+    if (managed) lifecycle::waitForTermination();
+
     // Simple CLI
     std::string line;
-    while (true) {
+    while (!managed) {
         std::cout << "climate> ";
         if (!std::getline(std::cin, line)) break;
         if (line == "exit" || line == "quit") break;
         if (line == "state") {
-            std::lock_guard<std::mutex> lk(state_mtx);
-            std::cout << state.dump(2) << std::endl;
+            std::cout << state.read()->dump(2) << std::endl;
             continue;
         }
         if (line.rfind("temp ", 0) == 0) {
@@ -179,7 +199,8 @@ int main()
                 int t = std::stoi(line.substr(5));
                 json req; req["method"] = "set_temperature"; req["params"] = { {"temperature", t} };
                 json r;
-                if (send_message("127.0.0.1", rpc_port, req, r)) {
+                send_message("127.0.0.1", rpc_port, req, r);
+                if (!r.contains("error")) {
                     std::cout << "reply: " << r.dump() << std::endl;
                 } else {
                     std::cout << "call failed\n";
@@ -194,7 +215,8 @@ int main()
                 int f = std::stoi(line.substr(4));
                 json req; req["method"] = "set_fan_speed"; req["params"] = { {"fan_speed", f} };
                 json r;
-                if (send_message("127.0.0.1", rpc_port, req, r)) {
+                send_message("127.0.0.1", rpc_port, req, r);
+                if (!r.contains("error")) {
                     std::cout << "reply: " << r.dump() << std::endl;
                 } else {
                     std::cout << "call failed\n";
@@ -208,7 +230,8 @@ int main()
             std::string m = line.substr(5);
             json req; req["method"] = "set_mode"; req["params"] = { {"mode", m} };
             json r;
-            if (send_message("127.0.0.1", rpc_port, req, r)) {
+            send_message("127.0.0.1", rpc_port, req, r);
+            if (!r.contains("error")) {
                 std::cout << "reply: " << r.dump() << std::endl;
             } else {
                 std::cout << "call failed\n";
@@ -220,7 +243,8 @@ int main()
             bool ac_on = (ac_cmd == "on" || ac_cmd == "1");
             json req; req["method"] = "set_ac"; req["params"] = { {"ac_enabled", ac_on} };
             json r;
-            if (send_message("127.0.0.1", rpc_port, req, r)) {
+            send_message("127.0.0.1", rpc_port, req, r);
+            if (!r.contains("error")) {
                 std::cout << "reply: " << r.dump() << std::endl;
             } else {
                 std::cout << "call failed\n";
@@ -231,6 +255,7 @@ int main()
     }
 
     running = false;
+    heartbeats.stop();
     if (server_thread.joinable()) server_thread.join();
     if (sensor_thread.joinable()) sensor_thread.join();
     log_info("Climate Service exiting");
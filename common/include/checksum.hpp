@@ -0,0 +1,15 @@
+#ifndef CHECKSUM_HPP
+#define CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace common {
+
+    // CRC-32 (IEEE 802.3). Pass the previous result as `crc` to checksum
+    // data incrementally.
+    uint32_t crc32(const void* data, std::size_t len, uint32_t crc = 0);
+
+} // namespace common
+
+#endif // CHECKSUM_HPP
@@ -0,0 +1,117 @@
+#ifndef CONFIG_IMAGE_HPP
+#define CONFIG_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Precompiled service manifest (config/services.json), read in place via mmap.
+//
+// config_compiler turns the JSON manifest into an image at build time:
+//   header   32 bytes: magic "IVSC" | version u16 | header_size u16 | count u32
+//                      | crc u32 | bucket_count u32 | reserved u32 | total_size u64
+//   buckets  bucket_count x u32 displacement
+//   slots    count x 24 bytes: name_offset u32 | type_offset u32
+//                      | endpoint_offset u32 | name_len u16 | type_len u16
+//                      | endpoint_len u16 | pad u16 | order u32
+//   order    count x u32 slot index, in manifest order
+//   strings
+// (native byte order; the CRC covers everything but its own field). Names are
+// placed by a minimal perfect hash (hash and displace): a name's bucket gives
+// the displacement that maps it to its slot, so a lookup hashes once, reads
+// two table entries and compares one name. Opening validates the image and
+// allocates nothing besides the handle.
+
+namespace common {
+
+struct ServiceEndpoint {
+    std::string_view name;
+    std::string_view type;
+    std::string_view endpoint; // e.g. "tcp://localhost:5000"
+};
+
+// Owning copy of one manifest entry
+struct ServiceEntry {
+    std::string name;
+    std::string type;
+    std::string endpoint;
+
+    bool operator==(const ServiceEntry& o) const {
+        return name == o.name && type == o.type && endpoint == o.endpoint;
+    }
+    bool operator!=(const ServiceEntry& o) const { return !(*this == o); }
+};
+
+// Stream a services.json manifest into `services` (see sax_loader.hpp)
+bool loadServiceManifest(const std::string& json_path, std::vector<ServiceEntry>& services,
+                         std::string* error = nullptr);
+
+class ConfigImage {
+public:
+    static constexpr uint16_t kVersion = 1;
+
+    // Compile a services.json manifest into an image (temp file + rename)
+    static bool compile(const std::string& json_path, const std::string& image_path, std::string* error = nullptr);
+
+    // Map and validate an image; nullptr if missing, of another version or corrupt
+    static std::unique_ptr<ConfigImage> open(const std::string& path);
+
+    ~ConfigImage();
+    ConfigImage(const ConfigImage&) = delete;
+    ConfigImage& operator=(const ConfigImage&) = delete;
+
+    // Views point into the mapping and live as long as the image
+    std::optional<ServiceEndpoint> find(std::string_view name) const;
+    std::size_t size() const { return count; }
+    ServiceEndpoint at(std::size_t order) const; // in manifest order
+
+private:
+    struct Slot {
+        uint32_t name_offset;
+        uint32_t type_offset;
+        uint32_t endpoint_offset;
+        uint16_t name_len;
+        uint16_t type_len;
+        uint16_t endpoint_len;
+        uint16_t pad;
+        uint32_t order;
+    };
+
+    ConfigImage(const uint8_t* data, std::size_t length, uint32_t count, uint32_t buckets)
+        : data(data), length(length), count(count), bucket_count(buckets) {}
+
+    const Slot& slot(uint32_t i) const;
+    ServiceEndpoint view(const Slot& s) const;
+
+    const uint8_t* data;
+    std::size_t length;
+    uint32_t count;
+    uint32_t bucket_count;
+};
+
+// Service endpoints from the compiled image, or from the JSON manifest when
+// the image is missing, invalid or older than the JSON (during development).
+class ServiceConfig {
+public:
+    ServiceConfig(const std::string& image_path, const std::string& json_path);
+    ServiceConfig(const ServiceConfig&) = delete;
+    ServiceConfig& operator=(const ServiceConfig&) = delete;
+
+    std::optional<ServiceEndpoint> find(std::string_view name) const;
+    bool fromImage() const { return image != nullptr; }
+    bool loaded() const { return image || !parsed.empty(); }
+
+private:
+    std::unique_ptr<ConfigImage> image;
+    std::vector<ServiceEntry> parsed;
+    std::unordered_map<std::string_view, std::size_t> index; // into parsed
+};
+
+} // namespace common
+
+#endif // CONFIG_IMAGE_HPP
@@ -0,0 +1,111 @@
+#ifndef CONFIG_WATCHER_HPP
+#define CONFIG_WATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "config_image.hpp"
+#include "versioned_state.hpp"
+
+// Live view of config/services.json that follows edits without a restart.
+//
+// A background thread watches the manifest's directory with inotify (so both
+// in-place writes and editors' rename-over-the-file are seen), waits for a
+// burst of writes to settle, parses the new file and diffs it against the
+// live entries by service name. Only changed entries get a new object; the
+// table is republished with one atomic pointer swap (see versioned_state.hpp)
+// and unchanged entries keep their pointers. Subscribers are called once per
+// changed name, so editing one endpoint reaches only that service's users.
+// A manifest that fails to parse is logged and the live entries are kept.
+//
+//   ConfigWatcher watcher("config/services.json");
+//   watcher.subscribe("MediaService", [](const std::string&, const ConfigWatcher::Entry& e) {
+//       if (e) reconnect(e->endpoint);
+//   });
+//   watcher.start();
+
+namespace common {
+
+class ConfigWatcher {
+public:
+    using Entry = std::shared_ptr<const ServiceEntry>;
+    // `entry` is null when the service was removed from the manifest. Runs on
+    // the thread that applied the change; must not call reload().
+    using Callback = std::function<void(const std::string& name, const Entry& entry)>;
+
+    struct Stats {
+        uint64_t reloads = 0;  // manifests parsed and applied
+        uint64_t rejected = 0; // manifests that failed to parse
+        uint64_t changes = 0;  // entries added, replaced or removed
+    };
+
+    explicit ConfigWatcher(std::string json_path,
+                           std::chrono::milliseconds settle = std::chrono::milliseconds(50));
+    ~ConfigWatcher();
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Load the manifest and start watching it; false if it cannot be watched.
+    // A manifest that is missing or invalid now is picked up once it is fixed.
+    bool start();
+    void stop();
+
+    // Parse the manifest now and apply what changed; false if it did not parse
+    bool reload();
+
+    // Lock-free; the entry stays valid for as long as the caller holds it
+    Entry find(const std::string& name) const;
+    std::size_t size() const;
+    uint64_t version() const { return table.version(); }
+
+    // Called for every change of `name` (including its first load)
+    uint64_t subscribe(const std::string& name, Callback cb);
+    // Called for every changed name
+    uint64_t subscribeAll(Callback cb);
+    void unsubscribe(uint64_t id);
+
+    Stats stats() const;
+
+private:
+    using Table = std::unordered_map<std::string, Entry>;
+
+    struct Subscription {
+        uint64_t id;
+        bool all;
+        std::string name;
+        Callback cb;
+    };
+
+    void run();
+    bool drainEvents();
+    void notify(const std::vector<std::pair<std::string, Entry>>& changes);
+
+    std::string path;
+    std::string dir;
+    std::string file;
+    std::chrono::milliseconds settle;
+
+    VersionedState<Table> table;
+    std::mutex reload_mtx; // one parse and diff at a time; changes are announced in order
+
+    mutable std::mutex mtx; // subscriptions and counters
+    std::vector<Subscription> subs;
+    uint64_t next_id = 1;
+    Stats counters;
+
+    std::thread watcher;
+    std::atomic_bool running{false};
+    int inotify_fd = -1;
+    int wake_fd = -1; // eventfd, signalled by stop()
+};
+
+} // namespace common
+
+#endif // CONFIG_WATCHER_HPP
@@ -0,0 +1,94 @@
+#ifndef DURABILITY_HPP
+#define DURABILITY_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// When persisted files reach stable storage.
+//
+//   None         nothing is synced; the page cache decides (previous behaviour)
+//   Periodic     writes return at once; a background thread syncs the touched
+//                filesystems every `period`, bounding the loss window
+//   GroupCommit  writes return once durable. Concurrent commits of a process
+//                are batched: one leader thread waits `window` for more
+//                requests, then a single syncfs() covers the data of the whole
+//                batch and, for replaced files, a second one their renames.
+//
+// Persistence::saveState and StateJournal commit through the process-wide
+// instance, configured with Persistence::setDurability().
+
+namespace common {
+
+enum class Durability { None, Periodic, GroupCommit };
+
+struct DurabilityOptions {
+    Durability mode = Durability::None;
+    std::chrono::milliseconds period{1000};      // Periodic
+    std::chrono::microseconds window{1000};      // GroupCommit batching delay
+};
+
+class DurabilityManager {
+public:
+    struct Stats {
+        uint64_t commits = 0; // commit requests
+        uint64_t syncs = 0;   // syncfs() calls issued for them
+    };
+
+    static DurabilityManager& instance();
+
+    DurabilityManager() = default;
+    ~DurabilityManager();
+    DurabilityManager(const DurabilityManager&) = delete;
+    DurabilityManager& operator=(const DurabilityManager&) = delete;
+
+    void configure(const DurabilityOptions& options);
+    DurabilityOptions options() const;
+
+    // Atomically replace `target` with the fully written `tmp`. In
+    // GroupCommit mode the data is durable before the rename, and the rename
+    // before this returns.
+    bool commitReplace(const std::string& tmp, const std::string& target);
+
+    // Make the data appended to `path` (open as `fd`) durable per the mode.
+    bool commitAppend(const std::string& path, int fd);
+
+    Stats stats() const;
+
+private:
+    struct Request {
+        std::string tmp;      // empty for appends
+        std::string target;
+        bool done = false;
+        bool ok = true;
+    };
+
+    bool groupCommit(Request& req);
+    void runBatch(std::vector<Request*>& batch);
+    void markDirty(const std::string& path);
+    void runPeriodic();
+    void stopPeriodic(std::unique_lock<std::mutex>& lk);
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    DurabilityOptions opts;
+    Stats counters;
+
+    // GroupCommit: requests waiting for the next batch
+    std::vector<Request*> queue;
+    bool leader_active = false;
+
+    // Periodic: directories of files written since the last sync
+    std::set<std::string> dirty_dirs;
+    std::thread periodic;
+    bool periodic_stop = false;
+};
+
+} // namespace common
+
+#endif // DURABILITY_HPP
@@ -0,0 +1,34 @@
+#ifndef EPOCH_HPP
+#define EPOCH_HPP
+
+#include <cstdint>
+
+// Process-wide epoch-based reclamation.
+//
+// A reader holds a Guard while it dereferences shared objects; the guard
+// announces the global epoch in a per-thread slot, without locks. A writer
+// that unlinks an object calls advance() and tags the object with the
+// returned epoch; it may free the object once minActive() is not below that
+// tag, as every reader that could still see it announced an older epoch.
+// Guards nest within a thread; a thread holds one of a fixed number of slots
+// only while its outermost guard is open.
+
+namespace common::epoch {
+
+class Guard {
+public:
+    Guard();
+    ~Guard();
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+};
+
+// Start a new epoch and return it
+uint64_t advance();
+
+// Oldest epoch announced by a guard; UINT64_MAX if no thread holds one
+uint64_t minActive();
+
+} // namespace common::epoch
+
+#endif // EPOCH_HPP
@@ -0,0 +1,99 @@
+#ifndef HEARTBEAT_HPP
+#define HEARTBEAT_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compact binary heartbeat frames exchanged over a UDP datagram channel.
+//
+// Wire layout (network byte order):
+//   header: magic u16 | version u8 | count u8
+//   entry:  instance_id u32 | sequence u32 | load u16   (repeated `count` times)
+//
+// One datagram may carry the heartbeats of every service hosted by a process.
+
+namespace common::heartbeat {
+
+constexpr uint16_t kMagic = 0x4842; // "HB"
+constexpr uint8_t kVersion = 1;
+constexpr int kDefaultPort = 4002;
+constexpr std::size_t kHeaderSize = 4;
+constexpr std::size_t kEntrySize = 10;
+constexpr std::size_t kMaxEntries = 128;
+constexpr std::size_t kMaxFrameSize = kHeaderSize + kMaxEntries * kEntrySize;
+
+struct Entry {
+    uint32_t instance_id;
+    uint32_t sequence;
+    uint16_t load; // service-defined load figure, e.g. queue depth or CPU permille
+};
+
+// Stable instance ID derived from the service name (FNV-1a). Used by services
+// that did not receive an explicit ID from the Service Manager at registration.
+uint32_t instanceId(const std::string& service_name);
+
+// Encode `count` entries into `buf`. Returns the frame size, or 0 if the
+// entries do not fit into `buf_len` or exceed kMaxEntries.
+std::size_t encode(const Entry* entries, std::size_t count, uint8_t* buf, std::size_t buf_len);
+
+// Decode a frame, invoking `on_entry(const Entry&)` for every entry without
+// allocating. Returns the number of entries, or 0 if the frame is malformed.
+template <typename F>
+std::size_t decode(const uint8_t* buf, std::size_t len, F&& on_entry)
+{
+    if (len < kHeaderSize) return 0;
+    uint16_t magic = static_cast<uint16_t>((buf[0] << 8) | buf[1]);
+    if (magic != kMagic || buf[2] != kVersion) return 0;
+    std::size_t count = buf[3];
+    if (len < kHeaderSize + count * kEntrySize) return 0;
+
+    const uint8_t* p = buf + kHeaderSize;
+    for (std::size_t i = 0; i < count; ++i, p += kEntrySize) {
+        Entry e;
+        e.instance_id = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+        e.sequence = (uint32_t(p[4]) << 24) | (uint32_t(p[5]) << 16) | (uint32_t(p[6]) << 8) | p[7];
+        e.load = static_cast<uint16_t>((p[8] << 8) | p[9]);
+        on_entry(e);
+    }
+    return count;
+}
+
+// Sends batched heartbeats for all services hosted by this process.
+class HeartbeatSender {
+public:
+    HeartbeatSender(const std::string& host, int port = kDefaultPort);
+    ~HeartbeatSender();
+
+    // Add a hosted service; returns its slot for setLoad().
+    std::size_t add(const std::string& service_name);
+    std::size_t add(uint32_t instance_id);
+    void setLoad(std::size_t slot, uint16_t load);
+
+    // Send one datagram carrying a heartbeat for every hosted service.
+    bool beat();
+
+    // Beat periodically on a background thread.
+    void start(std::chrono::milliseconds interval);
+    void stop();
+
+private:
+    uint32_t addr = 0; // IPv4, network byte order
+    uint16_t port = 0; // network byte order
+    int fd = -1;
+    std::mutex mtx;
+    std::vector<Entry> entries;
+    std::array<uint8_t, kMaxFrameSize> frame{};
+    std::atomic_bool running{false};
+    std::thread worker;
+};
+
+} // namespace common::heartbeat
+
+#endif // HEARTBEAT_HPP
@@ -0,0 +1,114 @@
+#ifndef KEY_VALUE_STORAGE_HPP
+#define KEY_VALUE_STORAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Typed key-value storage modelled on ara::per::KeyValueStorage.
+//
+// Values live in a log-structured file: SyncToStorage() appends one record
+// per key changed since the last sync,
+//   crc u32 | key_len u16 | flags u16 | value_len u32 | key | value
+// (native byte order, value is MessagePack, the CRC covers everything after
+// it), so updating a key never rewrites the others. An in-memory hash index
+// maps each key to its latest record. Values up to `cache_bytes` are kept
+// decoded in the index; larger ones are read from the file when requested.
+// When superseded records make up more than half of the file it is rewritten
+// with the live records only.
+//
+// Any type nlohmann::json can convert is a valid value type.
+
+namespace common::per {
+
+class KeyValueStorage {
+public:
+    struct Options {
+        std::size_t cache_bytes = 4 * 1024;   // larger values are loaded lazily
+        std::size_t compact_min = 64 * 1024;  // never compact smaller files
+    };
+
+    explicit KeyValueStorage(std::string path);
+    KeyValueStorage(std::string path, Options options);
+    ~KeyValueStorage();
+
+    KeyValueStorage(const KeyValueStorage&) = delete;
+    KeyValueStorage& operator=(const KeyValueStorage&) = delete;
+
+    // False if the storage file could not be opened; the storage then only
+    // holds values in memory.
+    bool isOpen() const;
+
+    std::vector<std::string> GetAllKeys() const;
+    bool KeyExists(const std::string& key) const;
+
+    // The value of `key`, including changes not yet synced, or nullopt if the
+    // key does not exist or does not convert to T.
+    template <typename T>
+    std::optional<T> GetValue(const std::string& key) const {
+        std::optional<nlohmann::json> j = getJson(key);
+        if (!j) return std::nullopt;
+        try {
+            return j->get<T>();
+        } catch (const nlohmann::json::exception&) {
+            return std::nullopt;
+        }
+    }
+
+    // False, changing nothing, if the key is longer than kMaxKeyBytes
+    template <typename T>
+    bool SetValue(const std::string& key, const T& value) {
+        return setJson(key, nlohmann::json(value));
+    }
+
+    void RemoveKey(const std::string& key);
+    void RemoveAllKeys();
+
+    // Append the pending changes and fsync. Returns false on I/O errors; the
+    // changes then stay pending.
+    bool SyncToStorage();
+    void DiscardPendingChanges();
+
+    std::size_t fileBytes() const;
+
+    static constexpr std::size_t kMaxKeyBytes = UINT16_MAX; // key_len is a u16
+
+private:
+    struct Slot {
+        uint64_t offset = 0;   // of the value in the file
+        uint32_t length = 0;
+        uint32_t record = 0;   // size of the whole record
+        std::optional<nlohmann::json> cached;
+    };
+
+    static constexpr std::size_t kRecordHeader = 12;
+    static constexpr uint16_t kFlagErase = 1;
+
+    std::optional<nlohmann::json> getJson(const std::string& key) const;
+    bool setJson(const std::string& key, nlohmann::json value);
+
+    // Caller holds mtx
+    void load();
+    std::optional<nlohmann::json> readValue(const Slot& slot) const;
+    static void encode(std::vector<uint8_t>& out, const std::string& key, const std::vector<uint8_t>* value);
+    bool compact();
+
+    const std::string path;
+    const Options options;
+
+    mutable std::mutex mtx;
+    int fd = -1;
+    std::size_t file_bytes = 0;
+    std::size_t live_bytes = 0;  // bytes of the records the index points to
+    std::unordered_map<std::string, Slot> index;
+    std::unordered_map<std::string, std::optional<nlohmann::json>> pending; // nullopt: removed
+};
+
+} // namespace common::per
+
+#endif // KEY_VALUE_STORAGE_HPP
@@ -0,0 +1,26 @@
+#ifndef LIFECYCLE_HPP
+#define LIFECYCLE_HPP
+
+// Helpers for services started by the Service Manager's launcher.
+//
+// The launcher passes the write end of a readiness pipe in IVI_READY_FD.
+// A service calls notifyReady() once it can serve requests; its dependents
+// are started as soon as the byte arrives.
+
+namespace common::lifecycle {
+
+    constexpr const char* kReadyFdEnv = "IVI_READY_FD";
+
+    // True when the process was started by the Service Manager's launcher.
+    bool isManaged();
+
+    // Signal readiness to the launcher. No-op when not managed or already signalled.
+    void notifyReady();
+
+    // Block until SIGTERM or SIGINT. Managed services use this instead of
+    // their interactive CLI.
+    void waitForTermination();
+
+} // namespace common::lifecycle
+
+#endif // LIFECYCLE_HPP
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <nlohmann/json.hpp>
+#include "durability.hpp"
 
 class Persistence {
 public:
@@ -17,6 +18,9 @@ public:
 
     // Save the current state to a JSON file
     static void saveState(const std::string& filename, const nlohmann::json& state);
+
+    // When saved files reach the disk; process-wide, None by default
+    static void setDurability(const common::DurabilityOptions& options);
 };
 
 // Logging function for persistence module
@@ -0,0 +1,54 @@
+#ifndef PERSISTENCY_CLIENT_HPP
+#define PERSISTENCY_CLIENT_HPP
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Client of the persistency daemon, which owns the state of all services.
+//
+// Requests are RPC frames (see rpc_frame.hpp) on a Unix stream socket; the
+// frame name is the service, the payload a JSON request:
+//   {"op":"load"}                          -> {"state":{...}}
+//   {"op":"update","set":{...},"erase":[]} -> {"seq":N}, once durable
+// save() sends only the top-level keys that changed since the last save, so
+// the daemon journals small records and group-commits those of all services.
+
+namespace common::per {
+
+constexpr const char* kPersistencySocket = "/tmp/ivi_persistency.sock";
+
+class PersistencyClient {
+public:
+    explicit PersistencyClient(std::string service, std::string socket_path = kPersistencySocket);
+    ~PersistencyClient();
+
+    PersistencyClient(const PersistencyClient&) = delete;
+    PersistencyClient& operator=(const PersistencyClient&) = delete;
+
+    // False if the daemon is not running
+    bool connect(std::chrono::milliseconds timeout = std::chrono::milliseconds(2000));
+    bool connected() const { return fd >= 0; }
+
+    // The service's stored state (an empty object if none); nullopt on errors
+    std::optional<nlohmann::json> load();
+
+    // Store `state`, returning once the daemon has made it durable
+    bool save(const nlohmann::json& state);
+    bool update(const nlohmann::json& set, const std::vector<std::string>& erase);
+
+private:
+    bool request(const nlohmann::json& req, nlohmann::json& reply);
+    void disconnect();
+
+    const std::string service;
+    const std::string socket_path;
+    int fd = -1;
+    nlohmann::json stored = nlohmann::json::object(); // what the daemon holds
+};
+
+} // namespace common::per
+
+#endif // PERSISTENCY_CLIENT_HPP
@@ -0,0 +1,54 @@
+#ifndef RPC_FRAME_HPP
+#define RPC_FRAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Length-prefixed RPC frames over TCP, as forwarded by the Service Manager's
+// RPC proxy.
+//
+// Wire layout (network byte order):
+//   header: magic u16 | flags u8 | name_len u8 | payload_len u32
+//   target service name (name_len bytes), then the payload
+//
+// Requests to the proxy name the target service; replies carry no name. The
+// proxy only parses the header and name, the payload is forwarded opaquely.
+
+namespace common::rpc {
+
+constexpr uint16_t kMagic = 0x5250; // "RP"
+constexpr int kDefaultProxyPort = 4003;
+constexpr std::size_t kHeaderSize = 8;
+constexpr uint32_t kMaxPayload = 64u * 1024 * 1024;
+constexpr uint8_t kFlagError = 0x01; // payload is an error message
+
+struct FrameHeader {
+    uint8_t flags = 0;
+    uint8_t name_len = 0;
+    uint32_t payload_len = 0;
+};
+
+void encodeHeader(const FrameHeader& h, uint8_t* out);
+
+// Returns false if the magic or the payload length is invalid.
+bool decodeHeader(const uint8_t* in, FrameHeader& h);
+
+// Blocking full-length socket I/O; false on error or EOF.
+bool readFull(int fd, void* buf, std::size_t len);
+bool writeFull(int fd, const void* buf, std::size_t len, int flags = 0);
+
+bool sendFrame(int fd, const std::string& service, const void* payload, std::size_t len, uint8_t flags = 0);
+bool recvFrame(int fd, FrameHeader& h, std::string& service, std::string& payload);
+
+// Connect a TCP socket with TCP_NODELAY set; returns -1 on failure.
+int connectTcp(const std::string& host, int port);
+
+// One request/reply round trip on a connected socket. `service` is empty when
+// talking to a service directly. Returns false on I/O or proxy errors; the
+// proxy's error message is then in `reply`.
+bool call(int fd, const std::string& service, const std::string& request, std::string& reply);
+
+} // namespace common::rpc
+
+#endif // RPC_FRAME_HPP
@@ -0,0 +1,424 @@
+#ifndef SAX_LOADER_HPP
+#define SAX_LOADER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Streaming JSON loader that maps documents straight into typed structs.
+//
+// The file is read through nlohmann's SAX parser; every event is handed to a
+// Binding for the value being parsed, which stores it in the target. Keys a
+// struct does not declare are skipped by depth counting, so no DOM is ever
+// built and memory stays bounded by the target plus the nesting depth.
+//
+// A struct is made loadable by specializing Schema:
+//
+//   template <> struct common::sax::Schema<Track> {
+//       static void describe(Fields<Track>& f) {
+//           f.required("title", &Track::title);
+//           f.field("length_s", &Track::length);
+//           f.convert<int64_t>("added_ms", [](Track& t, int64_t ms) { t.added = ms / 1000; });
+//       }
+//   };
+//   Library lib;
+//   std::string error;
+//   bool ok = common::sax::loadFile("library.json", lib, &error);
+//
+// Members may be arithmetic, std::string, nlohmann::json (that subtree only
+// is built as a DOM), std::vector of any of these or of structs, and
+// std::vector<std::pair<std::string, V>> for objects used as maps. Type
+// mismatches and missing required keys fail the load.
+
+namespace common::sax {
+
+// Consumer of the events of one JSON value. Scalar handlers and begin*()
+// return false when the value does not fit the target.
+class Binding {
+public:
+    virtual ~Binding() = default;
+
+    virtual bool onNull() { return false; }
+    virtual bool onBool(bool) { return false; }
+    virtual bool onInt(int64_t) { return false; }
+    virtual bool onUint(uint64_t) { return false; }
+    virtual bool onDouble(double) { return false; }
+    virtual bool onString(std::string&) { return false; }
+
+    virtual bool beginObject() { return false; }
+    // Binding for the value of `key`, owned by this one; nullptr skips it
+    virtual Binding* key(const std::string&) { return nullptr; }
+    virtual bool endObject() { return true; }
+
+    virtual bool beginArray() { return false; }
+    // Binding for the next element, owned by this one
+    virtual Binding* element() { return nullptr; }
+    virtual bool endArray() { return true; }
+
+    // The value is complete
+    virtual void finish() {}
+
+    // Why the value was rejected, if more specific than a type mismatch
+    virtual std::string error() const { return {}; }
+};
+
+template <typename T>
+struct Schema; // specialize with static void describe(Fields<T>&)
+
+template <typename T>
+std::unique_ptr<Binding> bind(T& target);
+
+// Parse a document into `root`. On failure `error` says where and why.
+bool parse(std::FILE* file, Binding& root, std::string& error);
+bool parse(std::string_view text, Binding& root, std::string& error);
+
+template <typename T>
+bool loadFile(const std::string& path, T& target, std::string* error = nullptr) {
+    std::string message;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    bool ok = false;
+    if (!file) {
+        message = "cannot open " + path;
+    } else {
+        auto root = bind(target);
+        ok = parse(file, *root, message);
+        std::fclose(file);
+    }
+    if (!ok && error) *error = message;
+    return ok;
+}
+
+template <typename T>
+bool loadString(std::string_view text, T& target, std::string* error = nullptr) {
+    std::string message;
+    auto root = bind(target);
+    bool ok = parse(text, *root, message);
+    if (!ok && error) *error = message;
+    return ok;
+}
+
+// Field table of a struct, built once per type
+template <typename T>
+class Fields {
+public:
+    using Factory = std::function<std::unique_ptr<Binding>(T&)>;
+
+    template <typename M>
+    void field(const std::string& key, M T::*member) {
+        add(key, [member](T& t) { return bind(t.*member); }, false);
+    }
+
+    template <typename M>
+    void required(const std::string& key, M T::*member) {
+        add(key, [member](T& t) { return bind(t.*member); }, true);
+    }
+
+    // Parse the value as V and hand it to `apply`
+    template <typename V>
+    void convert(const std::string& key, std::function<void(T&, V&&)> apply, bool is_required = false);
+
+    struct Field {
+        Factory make;
+        bool required;
+        std::size_t index;
+    };
+
+    const Field* find(const std::string& key) const {
+        auto it = table.find(key);
+        return it == table.end() ? nullptr : &it->second;
+    }
+    std::size_t size() const { return table.size(); }
+    // Indexed like Field::index; empty for optional keys
+    const std::vector<std::string>& requiredKeys() const { return required_keys; }
+
+private:
+    void add(const std::string& key, Factory make, bool is_required) {
+        if (table.count(key)) return;
+        table[key] = Field{std::move(make), is_required, required_keys.size()};
+        required_keys.push_back(is_required ? key : std::string());
+    }
+
+    std::unordered_map<std::string, Field> table;
+    std::vector<std::string> required_keys;
+};
+
+namespace detail {
+
+template <typename N>
+class NumberBinding : public Binding {
+public:
+    explicit NumberBinding(N& target) : target(target) {}
+
+    bool onInt(int64_t v) override {
+        if constexpr (std::is_floating_point_v<N>) {
+            target = static_cast<N>(v);
+            return true;
+        } else if constexpr (std::is_signed_v<N>) {
+            if (v < std::numeric_limits<N>::min() || v > std::numeric_limits<N>::max()) return false;
+            target = static_cast<N>(v);
+            return true;
+        } else {
+            return v >= 0 && onUint(static_cast<uint64_t>(v));
+        }
+    }
+    bool onUint(uint64_t v) override {
+        if constexpr (!std::is_floating_point_v<N>) {
+            if (v > static_cast<uint64_t>(std::numeric_limits<N>::max())) return false;
+        }
+        target = static_cast<N>(v);
+        return true;
+    }
+    bool onDouble(double v) override {
+        if constexpr (!std::is_floating_point_v<N>) return false;
+        target = static_cast<N>(v);
+        return true;
+    }
+
+private:
+    N& target;
+};
+
+class BoolBinding : public Binding {
+public:
+    explicit BoolBinding(bool& target) : target(target) {}
+    bool onBool(bool v) override {
+        target = v;
+        return true;
+    }
+
+private:
+    bool& target;
+};
+
+class StringBinding : public Binding {
+public:
+    explicit StringBinding(std::string& target) : target(target) {}
+    bool onString(std::string& v) override {
+        target = std::move(v);
+        return true;
+    }
+
+private:
+    std::string& target;
+};
+
+// Builds a DOM for this subtree only
+class JsonBinding : public Binding {
+public:
+    explicit JsonBinding(nlohmann::json& target) : target(target) {}
+
+    bool onNull() override { return put(nullptr); }
+    bool onBool(bool v) override { return put(v); }
+    bool onInt(int64_t v) override { return put(v); }
+    bool onUint(uint64_t v) override { return put(v); }
+    bool onDouble(double v) override { return put(v); }
+    bool onString(std::string& v) override { return put(std::move(v)); }
+
+    bool beginObject() override { return open(nlohmann::json::object()); }
+    Binding* key(const std::string& k) override {
+        pending_key = k;
+        return this;
+    }
+    bool endObject() override { return close(); }
+    bool beginArray() override { return open(nlohmann::json::array()); }
+    Binding* element() override { return this; }
+    bool endArray() override { return close(); }
+
+private:
+    bool put(nlohmann::json v) {
+        slot() = std::move(v);
+        return true;
+    }
+    bool open(nlohmann::json v) {
+        nlohmann::json& s = slot();
+        s = std::move(v);
+        stack.push_back(&s);
+        return true;
+    }
+    bool close() {
+        stack.pop_back();
+        return true;
+    }
+    nlohmann::json& slot() {
+        if (stack.empty()) return target;
+        nlohmann::json& parent = *stack.back();
+        if (parent.is_array()) {
+            parent.push_back(nullptr);
+            return parent.back();
+        }
+        return parent[pending_key];
+    }
+
+    nlohmann::json& target;
+    std::vector<nlohmann::json*> stack;
+    std::string pending_key;
+};
+
+template <typename E>
+class VectorBinding : public Binding {
+public:
+    explicit VectorBinding(std::vector<E>& target) : target(target) {}
+    bool beginArray() override {
+        target.clear();
+        return true;
+    }
+    Binding* element() override {
+        target.emplace_back();
+        child = bind(target.back());
+        return child.get();
+    }
+
+private:
+    std::vector<E>& target;
+    std::unique_ptr<Binding> child;
+};
+
+template <typename V>
+class MapBinding : public Binding {
+public:
+    explicit MapBinding(std::vector<std::pair<std::string, V>>& target) : target(target) {}
+    bool beginObject() override {
+        target.clear();
+        return true;
+    }
+    Binding* key(const std::string& k) override {
+        target.emplace_back(k, V{});
+        child = bind(target.back().second);
+        return child.get();
+    }
+
+private:
+    std::vector<std::pair<std::string, V>>& target;
+    std::unique_ptr<Binding> child;
+};
+
+template <typename T>
+class ObjectBinding : public Binding {
+public:
+    explicit ObjectBinding(T& target) : target(target) {}
+
+    static const Fields<T>& fields() {
+        static const Fields<T> table = [] {
+            Fields<T> f;
+            Schema<T>::describe(f);
+            return f;
+        }();
+        return table;
+    }
+
+    bool beginObject() override {
+        seen.assign(fields().size(), false);
+        return true;
+    }
+    Binding* key(const std::string& k) override {
+        const auto* f = fields().find(k);
+        if (!f) return nullptr;
+        seen[f->index] = true;
+        child = f->make(target);
+        return child.get();
+    }
+    bool endObject() override {
+        const auto& keys = fields().requiredKeys();
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (!keys[i].empty() && !seen[i]) {
+                missing = keys[i];
+                return false;
+            }
+        }
+        return true;
+    }
+    std::string error() const override {
+        return missing.empty() ? std::string() : "missing required key '" + missing + "'";
+    }
+
+private:
+    T& target;
+    std::vector<bool> seen;
+    std::unique_ptr<Binding> child;
+    std::string missing;
+};
+
+// Parses a V, then applies it to the owner
+template <typename T, typename V>
+class ConvertBinding : public Binding {
+public:
+    ConvertBinding(T& owner, const std::function<void(T&, V&&)>& apply)
+        : owner(owner), apply(apply), inner(bind(value)) {}
+
+    bool onNull() override { return inner->onNull(); }
+    bool onBool(bool v) override { return inner->onBool(v); }
+    bool onInt(int64_t v) override { return inner->onInt(v); }
+    bool onUint(uint64_t v) override { return inner->onUint(v); }
+    bool onDouble(double v) override { return inner->onDouble(v); }
+    bool onString(std::string& v) override { return inner->onString(v); }
+    bool beginObject() override { return inner->beginObject(); }
+    Binding* key(const std::string& k) override { return inner->key(k); }
+    bool endObject() override { return inner->endObject(); }
+    bool beginArray() override { return inner->beginArray(); }
+    Binding* element() override { return inner->element(); }
+    bool endArray() override { return inner->endArray(); }
+    std::string error() const override { return inner->error(); }
+
+    void finish() override {
+        inner->finish();
+        apply(owner, std::move(value));
+    }
+
+private:
+    T& owner;
+    const std::function<void(T&, V&&)>& apply;
+    V value{};
+    std::unique_ptr<Binding> inner;
+};
+
+template <typename X>
+struct IsVector : std::false_type {};
+template <typename E>
+struct IsVector<std::vector<E>> : std::true_type {};
+
+template <typename X>
+struct IsMap : std::false_type {};
+template <typename V>
+struct IsMap<std::vector<std::pair<std::string, V>>> : std::true_type {};
+
+} // namespace detail
+
+template <typename T>
+template <typename V>
+void Fields<T>::convert(const std::string& key, std::function<void(T&, V&&)> apply, bool is_required) {
+    // The table lives as long as the program, so bindings may refer to `apply`
+    auto shared = std::make_shared<std::function<void(T&, V&&)>>(std::move(apply));
+    add(key, [shared](T& t) { return std::make_unique<detail::ConvertBinding<T, V>>(t, *shared); }, is_required);
+}
+
+template <typename T>
+std::unique_ptr<Binding> bind(T& target) {
+    if constexpr (std::is_same_v<T, bool>) {
+        return std::make_unique<detail::BoolBinding>(target);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return std::make_unique<detail::NumberBinding<T>>(target);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return std::make_unique<detail::StringBinding>(target);
+    } else if constexpr (std::is_same_v<T, nlohmann::json>) {
+        return std::make_unique<detail::JsonBinding>(target);
+    } else if constexpr (detail::IsMap<T>::value) {
+        return std::make_unique<detail::MapBinding<typename T::value_type::second_type>>(target);
+    } else if constexpr (detail::IsVector<T>::value) {
+        return std::make_unique<detail::VectorBinding<typename T::value_type>>(target);
+    } else {
+        return std::make_unique<detail::ObjectBinding<T>>(target);
+    }
+}
+
+} // namespace common::sax
+
+#endif // SAX_LOADER_HPP
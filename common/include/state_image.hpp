@@ -0,0 +1,85 @@
+#ifndef STATE_IMAGE_HPP
+#define STATE_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+
+// Fixed-layout binary image of a service's state, read in place through mmap.
+//
+// Layout (native byte order):
+//   header  32 bytes: magic "IVSI" | version u16 | header_size u16 | count u32
+//                     | crc u32 | sequence u64 | total_size u64
+//   entries count x 16 bytes, sorted by key:
+//                     key_offset u32 | key_len u16 | type u8 | pad u8
+//                     | value_offset u32 | value_len u32
+//   data    keys and values; Int is i64, Double is f64, String is raw bytes,
+//           arrays and objects are MessagePack
+// The CRC covers the whole file except the crc field itself. Lookups binary
+// search the entry table in the mapping, so opening an image costs a checksum
+// pass instead of a JSON parse.
+
+namespace common {
+
+class StateImage {
+public:
+    static constexpr uint16_t kVersion = 1;
+
+    enum class Type : uint8_t { Null = 0, Bool = 1, Int = 2, Double = 3, String = 4, Json = 5 };
+
+    // Write the top-level keys of `state` atomically (temp file, fsync, rename).
+    // False, writing nothing, if a key is longer than UINT16_MAX bytes.
+    static bool write(const std::string& path, const nlohmann::json& state, uint64_t sequence = 0);
+
+    // Map and validate an image; nullptr if it is missing, truncated, of
+    // another version or fails its checksum.
+    static std::unique_ptr<StateImage> open(const std::string& path);
+
+    ~StateImage();
+    StateImage(const StateImage&) = delete;
+    StateImage& operator=(const StateImage&) = delete;
+
+    std::size_t size() const { return count; }
+    uint64_t sequence() const { return seq; }
+    bool contains(std::string_view key) const;
+
+    std::optional<bool> getBool(std::string_view key) const;
+    std::optional<int64_t> getInt(std::string_view key) const;
+    std::optional<double> getDouble(std::string_view key) const;
+    std::optional<std::string_view> getString(std::string_view key) const; // points into the mapping
+
+    // Any value as JSON; null if the key is missing
+    nlohmann::json get(std::string_view key) const;
+    nlohmann::json toJson() const;
+
+private:
+    struct Entry {
+        uint32_t key_offset;
+        uint16_t key_len;
+        uint8_t type;
+        uint8_t pad;
+        uint32_t value_offset;
+        uint32_t value_len;
+    };
+
+    StateImage(const uint8_t* data, std::size_t length, uint32_t count, uint64_t seq)
+        : data(data), length(length), count(count), seq(seq) {}
+
+    const Entry* find(std::string_view key) const;
+    const Entry* entry(uint32_t i) const;
+    std::string_view keyOf(const Entry& e) const;
+    nlohmann::json decode(const Entry& e) const;
+
+    const uint8_t* data;
+    std::size_t length;
+    uint32_t count;
+    uint64_t seq;
+};
+
+} // namespace common
+
+#endif // STATE_IMAGE_HPP
@@ -0,0 +1,104 @@
+#ifndef STATE_JOURNAL_HPP
+#define STATE_JOURNAL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Journaled persistence of a JSON state object.
+//
+// Instead of rewriting the whole document, every change of a top-level key
+// is appended to `<path>.journal` as a small binary record:
+//   crc u32 | seq u64 | key_len u16 | flags u16 | value_len u32 | key | value
+// (native byte order; value is MessagePack; the CRC covers everything after
+// it). Once the journal passes `compact_bytes` it is rotated and a background
+// thread writes the full state as a StateImage to `<path>.img`, tagged with
+// the last sequence number it contains, then drops the rotated journal. On
+// destruction the journal is folded into the image as well.
+//
+// recover() maps the image and replays newer records from the rotated
+// and the current journal, stopping at the first torn or corrupt record. A
+// plain JSON document at `path` (the non-journaled format) seeds the state
+// when no journal exists yet. Each save, put, erase and apply is committed
+// through DurabilityManager, so the process-wide durability mode applies.
+
+namespace common {
+
+class StateJournal {
+public:
+    struct Options {
+        std::size_t compact_bytes = 64 * 1024;
+    };
+
+    explicit StateJournal(std::string path);
+    StateJournal(std::string path, Options options);
+    ~StateJournal();
+
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+
+    // Rebuild the state and open the journal for appending. Call once, first.
+    nlohmann::json recover();
+
+    // Append records for the top-level keys of `state` that differ from the
+    // journaled state. Returns the number of records written.
+    std::size_t save(const nlohmann::json& state);
+
+    bool put(const std::string& key, const nlohmann::json& value);
+    bool erase(const std::string& key);
+
+    // Set the keys of `set` and drop those in `erase` under one commit, all
+    // or nothing: if a record cannot be written or the commit fails, the
+    // batch is rolled back and false returned. `written` receives the number
+    // of records written.
+    bool apply(const nlohmann::json& set, const std::vector<std::string>& erase,
+               std::size_t* written = nullptr);
+
+    uint64_t sequence() const;
+    std::size_t journalBytes() const;
+    uint64_t compactions() const;
+
+private:
+    static constexpr std::size_t kRecordHeader = 20;
+    static constexpr uint16_t kFlagErase = 1;
+
+    // Caller holds mtx
+    bool append(const std::string& key, const nlohmann::json* value);
+    bool commit();
+    void rotate();
+    bool openJournal();
+    uint64_t replay(const std::string& file, uint64_t after, bool truncate_torn);
+    void runCompactor();
+    bool writeSnapshot(const nlohmann::json& state, uint64_t seq);
+
+    const std::string path;
+    const std::string journal_path;
+    const std::string rotated_path;
+    const std::string image_path;
+    const std::string legacy_snapshot_path;
+    const Options options;
+
+    mutable std::mutex mtx;
+    nlohmann::json state = nlohmann::json::object(); // mirror of the journaled state
+    uint64_t seq = 0;
+    int fd = -1;
+    std::size_t journal_bytes = 0;
+    uint64_t compaction_count = 0;
+
+    // Compaction job handed to the background thread, guarded by mtx
+    std::condition_variable compact_cv;
+    bool compact_pending = false;
+    bool stopping = false;
+    nlohmann::json compact_state;
+    uint64_t compact_seq = 0;
+    std::thread compactor;
+};
+
+} // namespace common
+
+#endif // STATE_JOURNAL_HPP
@@ -0,0 +1,125 @@
+#ifndef VERSIONED_STATE_HPP
+#define VERSIONED_STATE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "epoch.hpp"
+
+// Multi-version container for a service's state.
+//
+// Writers copy the current version, modify the copy and publish it with one
+// atomic pointer store; they are serialized among themselves only. Readers
+// pin the current version with read() and never take a lock, so their
+// latency does not depend on writers. Replaced versions are freed by the
+// writer once no epoch guard that could reference them is left (see
+// epoch.hpp).
+//
+//   VersionedState<json> state(json::object());
+//   state.update([](json& s) { s["volume"] = 10; });
+//   auto snap = state.read();   // (*snap)["volume"] stays valid while snap lives
+
+namespace common {
+
+template <typename T>
+class VersionedState {
+    struct Version {
+        T value;
+        uint64_t number;
+    };
+
+public:
+    // Pins one version for the lifetime of the object; stays on the reading thread
+    class Snapshot {
+    public:
+        const T& operator*() const { return version->value; }
+        const T* operator->() const { return &version->value; }
+        uint64_t number() const { return version->number; }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+    private:
+        friend class VersionedState;
+        explicit Snapshot(const std::atomic<const Version*>& current) : version(current.load()) {}
+
+        epoch::Guard guard; // announced before the pointer is loaded
+        const Version* version;
+    };
+
+    explicit VersionedState(T initial = T{}) : current(new Version{std::move(initial), 1}) {}
+
+    // No reader may outlive the container
+    ~VersionedState() {
+        delete current.load();
+        for (auto& r : retired) delete r.second;
+    }
+
+    VersionedState(const VersionedState&) = delete;
+    VersionedState& operator=(const VersionedState&) = delete;
+
+    Snapshot read() const { return Snapshot(current); }
+
+    // Apply `fn(T&)` to a copy of the current value and publish it; if `fn`
+    // returns bool, false discards the copy. Returns the current version number.
+    template <typename F>
+    uint64_t update(F&& fn) {
+        std::lock_guard<std::mutex> lk(write_mtx);
+        const Version* old = current.load(std::memory_order_relaxed);
+        Version* next = new Version{old->value, old->number + 1};
+        bool changed = true;
+        try {
+            if constexpr (std::is_same_v<std::invoke_result_t<F&, T&>, bool>) changed = fn(next->value);
+            else fn(next->value);
+        } catch (...) {
+            delete next;
+            throw;
+        }
+        if (!changed) {
+            delete next;
+            return old->number;
+        }
+        return publish(next, old);
+    }
+
+    uint64_t store(T value) {
+        std::lock_guard<std::mutex> lk(write_mtx);
+        const Version* old = current.load(std::memory_order_relaxed);
+        return publish(new Version{std::move(value), old->number + 1}, old);
+    }
+
+    uint64_t version() const { return current.load()->number; }
+
+    // Replaced versions not yet freed
+    std::size_t retiredCount() const {
+        std::lock_guard<std::mutex> lk(write_mtx);
+        return retired.size();
+    }
+
+private:
+    // Caller holds write_mtx
+    uint64_t publish(Version* next, const Version* old) {
+        current.store(next);
+        retired.emplace_back(epoch::advance(), old);
+        uint64_t oldest = epoch::minActive();
+        std::size_t kept = 0;
+        for (auto& r : retired) {
+            if (r.first <= oldest) delete r.second;
+            else retired[kept++] = r;
+        }
+        retired.resize(kept);
+        return next->number;
+    }
+
+    std::atomic<const Version*> current;
+    mutable std::mutex write_mtx;
+    std::vector<std::pair<uint64_t, const Version*>> retired; // (epoch, version)
+};
+
+} // namespace common
+
+#endif // VERSIONED_STATE_HPP
@@ -0,0 +1,109 @@
+#ifndef WRITE_BEHIND_HPP
+#define WRITE_BEHIND_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "persistency_client.hpp"
+
+// Write-behind persistence of a service's state file.
+//
+// Handlers call markDirty() after changing their state instead of saving it.
+// A background thread writes the file once the state has been quiet for
+// `window`, or at the latest `max_delay` after the first unsaved change, so a
+// burst of updates (e.g. a volume knob spin) costs a single write. The state
+// is captured through `snapshot` on the writer thread, which therefore only
+// ever writes the latest version. Pending changes are written on destruction.
+//
+// With `journaled` set, only the top-level keys that changed are appended to
+// a StateJournal instead of rewriting the whole document.
+//
+// With `persistency_service` set, the state is stored by the persistency
+// daemon under that name, which batches the writes of all services. If the
+// daemon cannot be reached the local file is used instead, and the writer
+// tries to reconnect every `reconnect_interval`. While the local copy is
+// newer than the daemon's, `<file>.pending` exists; on reconnection or at the
+// next start the local copy is pushed to the daemon instead of being
+// replaced by its stale one. A service moving to the daemon seeds it from
+// its local file the same way.
+
+namespace common {
+
+class StateJournal;
+
+class WriteBehind {
+public:
+    // Returns the state to persist; runs on the writer thread and takes the
+    // owner's state lock itself.
+    using Snapshot = std::function<nlohmann::json()>;
+
+    struct Options {
+        std::chrono::milliseconds window{200};
+        std::chrono::milliseconds max_delay{2000};
+        bool journaled = false;
+        std::size_t compact_bytes = 64 * 1024; // journal size that triggers compaction
+        std::string persistency_service;       // non-empty: store through the daemon
+        std::string persistency_socket = per::kPersistencySocket;
+        std::chrono::milliseconds reconnect_interval{5000};
+    };
+
+    WriteBehind(std::string filename, Snapshot snapshot);
+    WriteBehind(std::string filename, Snapshot snapshot, Options options);
+    ~WriteBehind();
+
+    WriteBehind(const WriteBehind&) = delete;
+    WriteBehind& operator=(const WriteBehind&) = delete;
+
+    // The persisted state, or an empty object. Call once before markDirty().
+    nlohmann::json load();
+
+    // Cheap enough to call under the owner's state lock.
+    void markDirty();
+
+    // Write pending changes now and wait until they are on disk. Must not be
+    // called with the lock `snapshot` takes.
+    void flush();
+
+    uint64_t writes() const;
+    uint64_t updates() const;
+
+private:
+    void run();
+    nlohmann::json loadLocal();
+    void saveLocal(const nlohmann::json& state);
+    void clearPending();
+    bool reconnect();
+
+    const std::string filename;
+    const std::string pending_path;
+    const Snapshot snapshot;
+    const Options options;
+    std::unique_ptr<StateJournal> journal;
+    // Used by load() and then only by the writer thread
+    std::unique_ptr<per::PersistencyClient> daemon; // set while the daemon is used
+    bool local_loaded = false;
+    bool local_newer = false; // pending_path exists
+    std::chrono::steady_clock::time_point next_reconnect{};
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    bool dirty = false;
+    bool flush_requested = false;
+    bool stopping = false;
+    std::chrono::steady_clock::time_point first_mark;
+    std::chrono::steady_clock::time_point last_mark;
+    uint64_t marked_seq = 0;  // updates so far
+    uint64_t written_seq = 0; // updates covered by completed writes
+    uint64_t write_count = 0;
+    std::thread writer;
+};
+
+} // namespace common
+
+#endif // WRITE_BEHIND_HPP
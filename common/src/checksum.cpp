@@ -0,0 +1,28 @@
+#include "checksum.hpp"
+#include <array>
+
+namespace common {
+
+static std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+uint32_t crc32(const void* data, std::size_t len, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = makeCrcTable();
+    const auto* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; ++i) {
+        crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+} // namespace common
@@ -0,0 +1,324 @@
+#include "config_image.hpp"
+#include "checksum.hpp"
+#include "logging.hpp"
+#include "sax_loader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[4] = {'I', 'V', 'S', 'C'};
+constexpr std::size_t kHeaderSize = 32;
+constexpr std::size_t kCrcOffset = 12;
+constexpr std::size_t kSlotSize = 24;
+constexpr uint32_t kMaxDisplacement = 1u << 20;
+
+struct Manifest {
+    std::vector<common::ServiceEntry> services;
+};
+
+uint64_t nameHash(std::string_view name) {
+    uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+    for (unsigned char c : name) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+uint32_t bucketOf(uint64_t h, uint32_t buckets) {
+    return static_cast<uint32_t>((h >> 32) % buckets);
+}
+
+// Slot of a name under displacement `d` (murmur3 finalizer)
+uint32_t slotOf(uint64_t h, uint32_t d, uint32_t slots) {
+    uint64_t x = h ^ (d * 0x9e3779b97f4a7c15ull);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return static_cast<uint32_t>(x % slots);
+}
+
+uint32_t imageCrc(const uint8_t* data, std::size_t len) {
+    uint32_t crc = common::crc32(data, kCrcOffset);
+    return common::crc32(data + kCrcOffset + 4, len - kCrcOffset - 4, crc);
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& buf, std::size_t at, T value) {
+    std::memcpy(buf.data() + at, &value, sizeof(T));
+}
+
+bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+}
+
+// Displacement per bucket so that every name lands in its own slot; larger
+// buckets are placed first while most slots are still free
+bool buildHash(const std::vector<uint64_t>& hashes, uint32_t buckets, std::vector<uint32_t>& displacement,
+               std::vector<uint32_t>& slot_of) {
+    uint32_t n = static_cast<uint32_t>(hashes.size());
+    std::vector<std::vector<uint32_t>> members(buckets);
+    for (uint32_t i = 0; i < n; ++i) members[bucketOf(hashes[i], buckets)].push_back(i);
+    std::vector<uint32_t> order(buckets);
+    for (uint32_t b = 0; b < buckets; ++b) order[b] = b;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return members[a].size() > members[b].size(); });
+
+    displacement.assign(buckets, 0);
+    slot_of.assign(n, 0);
+    std::vector<bool> taken(n, false);
+    std::vector<uint32_t> placed;
+    for (uint32_t b : order) {
+        if (members[b].empty()) break;
+        bool found = false;
+        for (uint32_t d = 0; d < kMaxDisplacement && !found; ++d) {
+            placed.clear();
+            found = true;
+            for (uint32_t key : members[b]) {
+                uint32_t s = slotOf(hashes[key], d, n);
+                if (taken[s] || std::find(placed.begin(), placed.end(), s) != placed.end()) {
+                    found = false;
+                    break;
+                }
+                placed.push_back(s);
+            }
+            if (found) {
+                displacement[b] = d;
+                for (std::size_t k = 0; k < placed.size(); ++k) {
+                    taken[placed[k]] = true;
+                    slot_of[members[b][k]] = placed[k];
+                }
+            }
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+template <>
+struct common::sax::Schema<common::ServiceEntry> {
+    static void describe(Fields<common::ServiceEntry>& f) {
+        f.required("name", &common::ServiceEntry::name);
+        f.field("type", &common::ServiceEntry::type);
+        f.required("endpoint", &common::ServiceEntry::endpoint);
+    }
+};
+
+template <>
+struct common::sax::Schema<Manifest> {
+    static void describe(Fields<Manifest>& f) {
+        f.required("services", &Manifest::services);
+    }
+};
+
+namespace common {
+
+bool loadServiceManifest(const std::string& json_path, std::vector<ServiceEntry>& services, std::string* error) {
+    Manifest manifest;
+    std::string message;
+    if (!sax::loadFile(json_path, manifest, &message)) return fail(error, json_path + ": " + message);
+    services = std::move(manifest.services);
+    return true;
+}
+
+bool ConfigImage::compile(const std::string& json_path, const std::string& image_path, std::string* error) {
+    static_assert(sizeof(Slot) == kSlotSize, "slot layout");
+    std::vector<ServiceEntry> services;
+    if (!loadServiceManifest(json_path, services, error)) return false;
+
+    uint32_t n = static_cast<uint32_t>(services.size());
+    std::vector<uint64_t> hashes;
+    for (const auto& s : services) {
+        if (s.name.size() > UINT16_MAX || s.type.size() > UINT16_MAX || s.endpoint.size() > UINT16_MAX) {
+            return fail(error, "service entry too long: " + s.name.substr(0, 64));
+        }
+        hashes.push_back(nameHash(s.name));
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        for (uint32_t j = i + 1; j < n; ++j) {
+            if (services[i].name == services[j].name) return fail(error, "duplicate service " + services[i].name);
+        }
+    }
+    uint32_t buckets = std::max<uint32_t>(1, n);
+    std::vector<uint32_t> displacement, slot_of;
+    if (n > 0 && !buildHash(hashes, buckets, displacement, slot_of)) {
+        return fail(error, "no perfect hash found");
+    }
+    if (n == 0) displacement.assign(buckets, 0);
+
+    const std::size_t slots_at = kHeaderSize + buckets * 4;
+    const std::size_t order_at = slots_at + n * kSlotSize;
+    std::vector<uint8_t> buf(order_at + n * 4);
+    for (uint32_t b = 0; b < buckets; ++b) put<uint32_t>(buf, kHeaderSize + b * 4, displacement[b]);
+    auto addString = [&buf](const std::string& s) {
+        uint32_t at = static_cast<uint32_t>(buf.size());
+        buf.insert(buf.end(), s.begin(), s.end());
+        return at;
+    };
+    for (uint32_t i = 0; i < n; ++i) {
+        Slot slot{};
+        slot.name_offset = addString(services[i].name);
+        slot.type_offset = addString(services[i].type);
+        slot.endpoint_offset = addString(services[i].endpoint);
+        slot.name_len = static_cast<uint16_t>(services[i].name.size());
+        slot.type_len = static_cast<uint16_t>(services[i].type.size());
+        slot.endpoint_len = static_cast<uint16_t>(services[i].endpoint.size());
+        slot.order = i;
+        std::memcpy(buf.data() + slots_at + slot_of[i] * kSlotSize, &slot, kSlotSize);
+        put<uint32_t>(buf, order_at + i * 4, slot_of[i]);
+    }
+
+    std::memcpy(buf.data(), kMagic, 4);
+    put<uint16_t>(buf, 4, kVersion);
+    put<uint16_t>(buf, 6, static_cast<uint16_t>(kHeaderSize));
+    put<uint32_t>(buf, 8, n);
+    put<uint32_t>(buf, 16, buckets);
+    put<uint64_t>(buf, 24, buf.size());
+    put<uint32_t>(buf, kCrcOffset, imageCrc(buf.data(), buf.size()));
+
+    const std::string tmp = image_path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0;
+    for (std::size_t done = 0; ok && done < buf.size();) {
+        ssize_t w = ::write(fd, buf.data() + done, buf.size() - done);
+        if (w < 0 && errno == EINTR) continue;
+        ok = w > 0;
+        if (ok) done += static_cast<std::size_t>(w);
+    }
+    if (fd >= 0) ::close(fd);
+    ok = ok && ::rename(tmp.c_str(), image_path.c_str()) == 0;
+    if (!ok) {
+        ::unlink(tmp.c_str());
+        return fail(error, "cannot write " + image_path + ": " + std::strerror(errno));
+    }
+    return true;
+}
+
+std::unique_ptr<ConfigImage> ConfigImage::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::size_t length = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        log_error("Config image: cannot map " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(map);
+    uint16_t version, header_size;
+    uint32_t count, crc, buckets;
+    uint64_t total;
+    std::memcpy(&version, data + 4, 2);
+    std::memcpy(&header_size, data + 6, 2);
+    std::memcpy(&count, data + 8, 4);
+    std::memcpy(&crc, data + kCrcOffset, 4);
+    std::memcpy(&buckets, data + 16, 4);
+    std::memcpy(&total, data + 24, 8);
+
+    const std::size_t slots_at = kHeaderSize + std::size_t{buckets} * 4;
+    const std::size_t order_at = slots_at + std::size_t{count} * kSlotSize;
+    bool valid = std::memcmp(data, kMagic, 4) == 0 && version == kVersion && header_size == kHeaderSize &&
+                 total == length && buckets > 0 && order_at + std::size_t{count} * 4 <= length &&
+                 imageCrc(data, length) == crc;
+    // The checksum vouches for the content, not for the offsets of a buggy compiler
+    for (uint32_t i = 0; valid && i < count; ++i) {
+        Slot s;
+        std::memcpy(&s, data + slots_at + i * kSlotSize, kSlotSize);
+        uint32_t order_slot;
+        std::memcpy(&order_slot, data + order_at + i * 4, 4);
+        valid = std::size_t{s.name_offset} + s.name_len <= length && std::size_t{s.type_offset} + s.type_len <= length &&
+                std::size_t{s.endpoint_offset} + s.endpoint_len <= length && s.order < count && order_slot < count;
+    }
+    for (uint32_t b = 0; valid && b < buckets; ++b) {
+        uint32_t d;
+        std::memcpy(&d, data + kHeaderSize + b * 4, 4);
+        valid = d < kMaxDisplacement;
+    }
+    if (!valid) {
+        log_warning("Config image " + path + " is invalid; ignoring it");
+        ::munmap(map, length);
+        return nullptr;
+    }
+    return std::unique_ptr<ConfigImage>(new ConfigImage(data, length, count, buckets));
+}
+
+ConfigImage::~ConfigImage() {
+    ::munmap(const_cast<uint8_t*>(data), length);
+}
+
+const ConfigImage::Slot& ConfigImage::slot(uint32_t i) const {
+    return *reinterpret_cast<const Slot*>(data + kHeaderSize + std::size_t{bucket_count} * 4 + i * kSlotSize);
+}
+
+ServiceEndpoint ConfigImage::view(const Slot& s) const {
+    auto str = [this](uint32_t offset, uint16_t len) {
+        return std::string_view(reinterpret_cast<const char*>(data + offset), len);
+    };
+    return ServiceEndpoint{str(s.name_offset, s.name_len), str(s.type_offset, s.type_len),
+                           str(s.endpoint_offset, s.endpoint_len)};
+}
+
+std::optional<ServiceEndpoint> ConfigImage::find(std::string_view name) const {
+    if (count == 0) return std::nullopt;
+    uint64_t h = nameHash(name);
+    uint32_t d;
+    std::memcpy(&d, data + kHeaderSize + bucketOf(h, bucket_count) * 4, 4);
+    ServiceEndpoint e = view(slot(slotOf(h, d, count)));
+    if (e.name != name) return std::nullopt;
+    return e;
+}
+
+ServiceEndpoint ConfigImage::at(std::size_t order) const {
+    uint32_t index;
+    std::memcpy(&index, data + kHeaderSize + std::size_t{bucket_count} * 4 + count * kSlotSize + order * 4, 4);
+    return view(slot(index));
+}
+
+ServiceConfig::ServiceConfig(const std::string& image_path, const std::string& json_path) {
+    struct stat image_st{}, json_st{};
+    bool have_image = ::stat(image_path.c_str(), &image_st) == 0;
+    bool have_json = ::stat(json_path.c_str(), &json_st) == 0;
+    // An edited manifest wins over a stale image
+    bool stale = have_json && (json_st.st_mtim.tv_sec > image_st.st_mtim.tv_sec ||
+                               (json_st.st_mtim.tv_sec == image_st.st_mtim.tv_sec &&
+                                json_st.st_mtim.tv_nsec > image_st.st_mtim.tv_nsec));
+    if (have_image && !stale) {
+        image = ConfigImage::open(image_path);
+        if (image) return;
+    }
+
+    std::string error;
+    if (!loadServiceManifest(json_path, parsed, &error)) {
+        log_error("No usable service configuration: " + error);
+        return;
+    }
+    log_warning("Service configuration read from " + json_path + "; run config_compiler for " + image_path);
+    for (std::size_t i = 0; i < parsed.size(); ++i) index.emplace(parsed[i].name, i);
+}
+
+std::optional<ServiceEndpoint> ServiceConfig::find(std::string_view name) const {
+    if (image) return image->find(name);
+    auto it = index.find(name);
+    if (it == index.end()) return std::nullopt;
+    const ServiceEntry& p = parsed[it->second];
+    return ServiceEndpoint{p.name, p.type, p.endpoint};
+}
+
+} // namespace common
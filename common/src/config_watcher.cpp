@@ -0,0 +1,203 @@
+#include "config_watcher.hpp"
+#include "logging.hpp"
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace common {
+
+ConfigWatcher::ConfigWatcher(std::string json_path, std::chrono::milliseconds settle)
+    : path(std::move(json_path)), settle(settle) {
+    std::filesystem::path p(path);
+    dir = p.parent_path().empty() ? "." : p.parent_path().string();
+    file = p.filename().string();
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start() {
+    if (running) return true;
+    inotify_fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    wake_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (inotify_fd < 0 || wake_fd < 0 ||
+        ::inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        log_error("ConfigWatcher: cannot watch " + dir + ": " + std::strerror(errno));
+        if (inotify_fd >= 0) ::close(inotify_fd);
+        if (wake_fd >= 0) ::close(wake_fd);
+        inotify_fd = wake_fd = -1;
+        return false;
+    }
+    // Watch first, then load: an edit in between is not lost
+    reload();
+    running = true;
+    watcher = std::thread(&ConfigWatcher::run, this);
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (!running.exchange(false)) return;
+    uint64_t one = 1;
+    if (::write(wake_fd, &one, sizeof(one)) < 0) {
+        log_error(std::string("ConfigWatcher: cannot wake watcher: ") + std::strerror(errno));
+    }
+    if (watcher.joinable()) watcher.join();
+    ::close(inotify_fd);
+    ::close(wake_fd);
+    inotify_fd = wake_fd = -1;
+}
+
+bool ConfigWatcher::reload() {
+    // Held from the parse on, so a concurrent reload cannot apply an older parse last
+    std::lock_guard<std::mutex> reload_lk(reload_mtx);
+    std::vector<ServiceEntry> services;
+    std::string error;
+    std::unordered_map<std::string, ServiceEntry> fresh;
+    bool ok = loadServiceManifest(path, services, &error);
+    for (std::size_t i = 0; ok && i < services.size(); ++i) {
+        if (fresh.count(services[i].name)) {
+            error = path + ": duplicate service " + services[i].name;
+            ok = false;
+            break;
+        }
+        std::string name = services[i].name;
+        fresh.emplace(std::move(name), std::move(services[i]));
+    }
+    if (!ok) {
+        log_warning("ConfigWatcher: keeping current configuration: " + error);
+        std::lock_guard<std::mutex> lk(mtx);
+        counters.rejected++;
+        return false;
+    }
+
+    std::vector<std::pair<std::string, Entry>> changes;
+    table.update([&](Table& t) {
+        for (auto it = t.begin(); it != t.end();) {
+            if (fresh.count(it->first)) {
+                ++it;
+                continue;
+            }
+            changes.emplace_back(it->first, nullptr);
+            it = t.erase(it);
+        }
+        for (auto& [name, entry] : fresh) {
+            Entry& slot = t[name];
+            if (slot && *slot == entry) continue;
+            slot = std::make_shared<const ServiceEntry>(std::move(entry));
+            changes.emplace_back(name, slot);
+        }
+        return !changes.empty();
+    });
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        counters.reloads++;
+        counters.changes += changes.size();
+    }
+    if (!changes.empty()) {
+        log_info("ConfigWatcher: " + std::to_string(changes.size()) + " service entr" +
+                 (changes.size() == 1 ? "y" : "ies") + " changed in " + path);
+        notify(changes);
+    }
+    return true;
+}
+
+ConfigWatcher::Entry ConfigWatcher::find(const std::string& name) const {
+    auto snap = table.read();
+    auto it = snap->find(name);
+    return it == snap->end() ? nullptr : it->second;
+}
+
+std::size_t ConfigWatcher::size() const {
+    return table.read()->size();
+}
+
+uint64_t ConfigWatcher::subscribe(const std::string& name, Callback cb) {
+    std::lock_guard<std::mutex> lk(mtx);
+    subs.push_back(Subscription{next_id, false, name, std::move(cb)});
+    return next_id++;
+}
+
+uint64_t ConfigWatcher::subscribeAll(Callback cb) {
+    std::lock_guard<std::mutex> lk(mtx);
+    subs.push_back(Subscription{next_id, true, std::string(), std::move(cb)});
+    return next_id++;
+}
+
+void ConfigWatcher::unsubscribe(uint64_t id) {
+    std::lock_guard<std::mutex> lk(mtx);
+    for (auto it = subs.begin(); it != subs.end(); ++it) {
+        if (it->id == id) {
+            subs.erase(it);
+            return;
+        }
+    }
+}
+
+ConfigWatcher::Stats ConfigWatcher::stats() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return counters;
+}
+
+// Callbacks run without the subscription lock so they may (un)subscribe
+void ConfigWatcher::notify(const std::vector<std::pair<std::string, Entry>>& changes) {
+    std::vector<std::pair<const std::pair<std::string, Entry>*, Callback>> calls;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (const auto& change : changes) {
+            for (const auto& s : subs) {
+                if (s.all || s.name == change.first) calls.emplace_back(&change, s.cb);
+            }
+        }
+    }
+    for (auto& [change, cb] : calls) {
+        try {
+            cb(change->first, change->second);
+        } catch (const std::exception& e) {
+            log_error("ConfigWatcher: subscriber for " + change->first + " failed: " + e.what());
+        }
+    }
+}
+
+// True if any queued event concerns the manifest
+bool ConfigWatcher::drainEvents() {
+    alignas(struct inotify_event) char buf[4096];
+    bool touched = false;
+    while (true) {
+        ssize_t n = ::read(inotify_fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        for (char* p = buf; p < buf + n;) {
+            auto* ev = reinterpret_cast<struct inotify_event*>(p);
+            if ((ev->mask & IN_Q_OVERFLOW) || (ev->len > 0 && file == ev->name)) touched = true;
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    return touched;
+}
+
+void ConfigWatcher::run() {
+    struct pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+    while (running) {
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            log_error(std::string("ConfigWatcher: poll failed: ") + std::strerror(errno));
+            return;
+        }
+        if (fds[1].revents) return;
+        if (!drainEvents()) continue;
+        // Editors and build steps write in several steps; parse once they are done
+        int ready;
+        while ((ready = ::poll(fds, 2, static_cast<int>(settle.count()))) > 0 && !fds[1].revents) {
+            drainEvents();
+        }
+        if (ready > 0 && fds[1].revents) return;
+        reload();
+    }
+}
+
+} // namespace common
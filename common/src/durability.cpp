@@ -0,0 +1,222 @@
+#include "durability.hpp"
+#include "logging.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string parentDir(const std::string& path) {
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    return dir.empty() ? "." : dir.string();
+}
+
+// One syncfs() per filesystem holding any of `dirs`; returns the number of
+// calls. Directories whose filesystem could not be synced go to `failed`.
+// syncfs() also flushes unrelated dirty data on that filesystem, which is
+// the price of covering a whole batch with a single call.
+uint64_t syncFilesystems(const std::set<std::string>& dirs, std::set<std::string>& failed) {
+    std::map<dev_t, int> fds;
+    std::map<dev_t, std::vector<std::string>> members;
+    for (const auto& dir : dirs) {
+        int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        struct stat st{};
+        if (fd < 0 || ::fstat(fd, &st) < 0) {
+            log_error("Durability: cannot open " + dir + ": " + std::strerror(errno));
+            if (fd >= 0) ::close(fd);
+            failed.insert(dir);
+            continue;
+        }
+        if (!fds.emplace(st.st_dev, fd).second) ::close(fd);
+        members[st.st_dev].push_back(dir);
+    }
+
+    uint64_t calls = 0;
+    for (const auto& [dev, fd] : fds) {
+        calls++;
+        if (::syncfs(fd) != 0) {
+            log_error("Durability: syncfs failed for " + members[dev].front() + ": " + std::strerror(errno));
+            failed.insert(members[dev].begin(), members[dev].end());
+        }
+        ::close(fd);
+    }
+    return calls;
+}
+
+} // namespace
+
+namespace common {
+
+DurabilityManager& DurabilityManager::instance() {
+    static DurabilityManager manager;
+    return manager;
+}
+
+DurabilityManager::~DurabilityManager() {
+    std::unique_lock<std::mutex> lk(mtx);
+    stopPeriodic(lk);
+}
+
+void DurabilityManager::configure(const DurabilityOptions& options) {
+    std::unique_lock<std::mutex> lk(mtx);
+    if (opts.mode == Durability::Periodic) stopPeriodic(lk);
+    opts = options;
+    if (opts.mode == Durability::Periodic) {
+        periodic = std::thread(&DurabilityManager::runPeriodic, this);
+    }
+}
+
+DurabilityOptions DurabilityManager::options() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return opts;
+}
+
+DurabilityManager::Stats DurabilityManager::stats() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return counters;
+}
+
+bool DurabilityManager::commitReplace(const std::string& tmp, const std::string& target) {
+    Durability mode = options().mode;
+    if (mode == Durability::GroupCommit) {
+        Request req;
+        req.tmp = tmp;
+        req.target = target;
+        return groupCommit(req);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        counters.commits++;
+    }
+    if (std::rename(tmp.c_str(), target.c_str()) != 0) {
+        log_error("Durability: cannot rename " + tmp + " to " + target + ": " + std::strerror(errno));
+        return false;
+    }
+    if (mode == Durability::Periodic) markDirty(target);
+    return true;
+}
+
+bool DurabilityManager::commitAppend(const std::string& path, int fd) {
+    Durability mode = options().mode;
+    if (fd < 0) return false;
+    if (mode == Durability::GroupCommit) {
+        Request req;
+        req.target = path;
+        return groupCommit(req);
+    }
+
+    std::lock_guard<std::mutex> lk(mtx);
+    counters.commits++;
+    if (mode == Durability::Periodic) dirty_dirs.insert(parentDir(path));
+    return true;
+}
+
+// The first waiting request leads a batch: it lets `window` pass so that
+// concurrent commits can join, takes the whole queue and syncs it while the
+// next batch builds up behind it.
+bool DurabilityManager::groupCommit(Request& req) {
+    std::unique_lock<std::mutex> lk(mtx);
+    counters.commits++;
+    queue.push_back(&req);
+    cv.wait(lk, [&] { return req.done || !leader_active; });
+    if (req.done) return req.ok;
+
+    leader_active = true;
+    if (opts.window.count() > 0) {
+        auto window = opts.window;
+        lk.unlock();
+        std::this_thread::sleep_for(window);
+        lk.lock();
+    }
+    std::vector<Request*> batch;
+    batch.swap(queue);
+    lk.unlock();
+
+    runBatch(batch);
+
+    lk.lock();
+    for (Request* r : batch) r->done = true;
+    leader_active = false;
+    bool ok = req.ok;
+    lk.unlock();
+    cv.notify_all();
+    return ok;
+}
+
+// Data first, then the renames that publish it, then the directory entries.
+void DurabilityManager::runBatch(std::vector<Request*>& batch) {
+    std::set<std::string> dirs;
+    for (Request* r : batch) dirs.insert(parentDir(r->target));
+    std::set<std::string> failed;
+    uint64_t syncs = syncFilesystems(dirs, failed);
+
+    std::set<std::string> renamed;
+    for (Request* r : batch) {
+        std::string dir = parentDir(r->target);
+        if (failed.count(dir)) {
+            r->ok = false;
+            if (!r->tmp.empty()) std::remove(r->tmp.c_str());
+            continue;
+        }
+        if (r->tmp.empty()) continue;
+        // Saves of the same file are renamed in arrival order, so the last one wins
+        if (std::rename(r->tmp.c_str(), r->target.c_str()) != 0) {
+            log_error("Durability: cannot rename " + r->tmp + " to " + r->target + ": " + std::strerror(errno));
+            r->ok = false;
+            continue;
+        }
+        renamed.insert(dir);
+    }
+
+    if (!renamed.empty()) {
+        std::set<std::string> failed_renames;
+        syncs += syncFilesystems(renamed, failed_renames);
+        for (Request* r : batch) {
+            if (!r->tmp.empty() && failed_renames.count(parentDir(r->target))) r->ok = false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(mtx);
+    counters.syncs += syncs;
+}
+
+void DurabilityManager::markDirty(const std::string& path) {
+    std::lock_guard<std::mutex> lk(mtx);
+    dirty_dirs.insert(parentDir(path));
+}
+
+void DurabilityManager::runPeriodic() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        bool stop = cv.wait_for(lk, opts.period, [&] { return periodic_stop; });
+        std::set<std::string> dirs;
+        dirs.swap(dirty_dirs);
+        if (!dirs.empty()) {
+            lk.unlock();
+            std::set<std::string> failed;
+            uint64_t syncs = syncFilesystems(dirs, failed);
+            lk.lock();
+            counters.syncs += syncs;
+        }
+        if (stop) return;
+    }
+}
+
+// Caller holds lk; the thread flushes what is still dirty before it exits
+void DurabilityManager::stopPeriodic(std::unique_lock<std::mutex>& lk) {
+    if (!periodic.joinable()) return;
+    periodic_stop = true;
+    lk.unlock();
+    cv.notify_all();
+    periodic.join();
+    lk.lock();
+    periodic_stop = false;
+}
+
+} // namespace common
@@ -0,0 +1,81 @@
+#include "epoch.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace common::epoch {
+
+namespace {
+
+constexpr std::size_t kSlots = 256;
+
+struct alignas(64) Slot {
+    std::atomic<uint64_t> epoch{0}; // 0: not reading
+    std::atomic<bool> owned{false};
+};
+
+Slot slots[kSlots];
+std::atomic<uint64_t> global_epoch{1};
+
+// Slots are held only while a guard is open, so all of them being taken means
+// kSlots threads are inside a read right now; wait for one of them to leave.
+Slot* claimSlot(Slot* hint) {
+    bool expected = false;
+    if (hint && hint->owned.compare_exchange_strong(expected, true)) return hint;
+    bool warned = false;
+    while (true) {
+        for (Slot& s : slots) {
+            expected = false;
+            if (!s.owned.load(std::memory_order_relaxed) && s.owned.compare_exchange_strong(expected, true)) {
+                return &s;
+            }
+        }
+        if (!warned) {
+            log_warning("epoch: all " + std::to_string(kSlots) + " reader slots are in use; waiting");
+            warned = true;
+        }
+        std::this_thread::yield();
+    }
+}
+
+// The slot of the open outermost guard; `hint` is retried first next time
+struct ThreadRecord {
+    Slot* slot = nullptr;
+    Slot* hint = nullptr;
+    unsigned depth = 0;
+};
+
+thread_local ThreadRecord record;
+
+} // namespace
+
+// Announce before the caller loads any pointer: a writer that finds the slot
+// still empty has already unlinked the object, so the reader cannot reach it.
+Guard::Guard() {
+    if (record.depth++ > 0) return;
+    record.slot = record.hint = claimSlot(record.hint);
+    record.slot->epoch.store(global_epoch.load());
+}
+
+Guard::~Guard() {
+    if (--record.depth > 0) return;
+    record.slot->epoch.store(0, std::memory_order_release);
+    record.slot->owned.store(false, std::memory_order_release);
+    record.slot = nullptr;
+}
+
+uint64_t advance() {
+    return global_epoch.fetch_add(1) + 1;
+}
+
+uint64_t minActive() {
+    uint64_t oldest = UINT64_MAX;
+    for (const Slot& s : slots) {
+        uint64_t e = s.epoch.load();
+        if (e != 0 && e < oldest) oldest = e;
+    }
+    return oldest;
+}
+
+} // namespace common::epoch
@@ -0,0 +1,109 @@
+#include "heartbeat.hpp"
+#include "logging.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace common::heartbeat {
+
+uint32_t instanceId(const std::string& service_name) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : service_name) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+std::size_t encode(const Entry* entries, std::size_t count, uint8_t* buf, std::size_t buf_len) {
+    std::size_t size = kHeaderSize + count * kEntrySize;
+    if (count > kMaxEntries || size > buf_len) return 0;
+
+    buf[0] = static_cast<uint8_t>(kMagic >> 8);
+    buf[1] = static_cast<uint8_t>(kMagic & 0xff);
+    buf[2] = kVersion;
+    buf[3] = static_cast<uint8_t>(count);
+
+    uint8_t* p = buf + kHeaderSize;
+    for (std::size_t i = 0; i < count; ++i, p += kEntrySize) {
+        const Entry& e = entries[i];
+        p[0] = static_cast<uint8_t>(e.instance_id >> 24);
+        p[1] = static_cast<uint8_t>(e.instance_id >> 16);
+        p[2] = static_cast<uint8_t>(e.instance_id >> 8);
+        p[3] = static_cast<uint8_t>(e.instance_id);
+        p[4] = static_cast<uint8_t>(e.sequence >> 24);
+        p[5] = static_cast<uint8_t>(e.sequence >> 16);
+        p[6] = static_cast<uint8_t>(e.sequence >> 8);
+        p[7] = static_cast<uint8_t>(e.sequence);
+        p[8] = static_cast<uint8_t>(e.load >> 8);
+        p[9] = static_cast<uint8_t>(e.load);
+    }
+    return size;
+}
+
+HeartbeatSender::HeartbeatSender(const std::string& host, int port)
+    : port(htons(static_cast<uint16_t>(port))) {
+    in_addr a{};
+    if (inet_pton(AF_INET, host.c_str(), &a) != 1) {
+        log_error("Heartbeat: invalid host address " + host);
+    }
+    addr = a.s_addr;
+    fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        log_error("Heartbeat: failed to create socket: " + std::string(std::strerror(errno)));
+    }
+}
+
+HeartbeatSender::~HeartbeatSender() {
+    stop();
+    if (fd >= 0) ::close(fd);
+}
+
+std::size_t HeartbeatSender::add(const std::string& service_name) {
+    return add(instanceId(service_name));
+}
+
+std::size_t HeartbeatSender::add(uint32_t instance_id) {
+    std::lock_guard<std::mutex> lk(mtx);
+    entries.push_back(Entry{instance_id, 0, 0});
+    return entries.size() - 1;
+}
+
+void HeartbeatSender::setLoad(std::size_t slot, uint16_t load) {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (slot < entries.size()) entries[slot].load = load;
+}
+
+bool HeartbeatSender::beat() {
+    if (fd < 0) return false;
+    std::lock_guard<std::mutex> lk(mtx);
+    for (auto& e : entries) e.sequence++;
+    std::size_t len = encode(entries.data(), entries.size(), frame.data(), frame.size());
+    if (len == 0) return false;
+
+    sockaddr_in dst{};
+    dst.sin_family = AF_INET;
+    dst.sin_port = port;
+    dst.sin_addr.s_addr = addr;
+    ssize_t n = ::sendto(fd, frame.data(), len, 0, reinterpret_cast<sockaddr*>(&dst), sizeof(dst));
+    return n == static_cast<ssize_t>(len);
+}
+
+void HeartbeatSender::start(std::chrono::milliseconds interval) {
+    if (running.exchange(true)) return;
+    worker = std::thread([this, interval]() {
+        while (running) {
+            beat();
+            std::this_thread::sleep_for(interval);
+        }
+    });
+}
+
+void HeartbeatSender::stop() {
+    running = false;
+    if (worker.joinable()) worker.join();
+}
+
+} // namespace common::heartbeat
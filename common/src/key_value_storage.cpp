@@ -0,0 +1,310 @@
+#include "key_value_storage.hpp"
+#include "checksum.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+bool writeAll(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, uint8_t* data, size_t len, uint64_t offset) {
+    while (len > 0) {
+        ssize_t n = ::pread(fd, data, len, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+namespace common::per {
+
+KeyValueStorage::KeyValueStorage(std::string path) : KeyValueStorage(std::move(path), Options{}) {}
+
+KeyValueStorage::KeyValueStorage(std::string path, Options options)
+    : path(std::move(path)), options(options) {
+    std::lock_guard<std::mutex> lk(mtx);
+    fd = ::open(this->path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log_error("Key-value storage: cannot open " + this->path + ": " + std::strerror(errno));
+        return;
+    }
+    load();
+}
+
+KeyValueStorage::~KeyValueStorage() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool KeyValueStorage::isOpen() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return fd >= 0;
+}
+
+std::vector<std::string> KeyValueStorage::GetAllKeys() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    std::vector<std::string> keys;
+    for (const auto& p : index) {
+        if (!pending.count(p.first)) keys.push_back(p.first);
+    }
+    for (const auto& p : pending) {
+        if (p.second) keys.push_back(p.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+bool KeyValueStorage::KeyExists(const std::string& key) const {
+    std::lock_guard<std::mutex> lk(mtx);
+    auto p = pending.find(key);
+    if (p != pending.end()) return p->second.has_value();
+    return index.count(key) != 0;
+}
+
+std::optional<json> KeyValueStorage::getJson(const std::string& key) const {
+    std::lock_guard<std::mutex> lk(mtx);
+    auto p = pending.find(key);
+    if (p != pending.end()) return p->second;
+    auto it = index.find(key);
+    if (it == index.end()) return std::nullopt;
+    if (it->second.cached) return it->second.cached;
+    return readValue(it->second);
+}
+
+bool KeyValueStorage::setJson(const std::string& key, json value) {
+    if (key.size() > kMaxKeyBytes) {
+        log_error("Key-value storage: key of " + std::to_string(key.size()) + " bytes is too long for " + path);
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(mtx);
+    pending[key] = std::move(value);
+    return true;
+}
+
+void KeyValueStorage::RemoveKey(const std::string& key) {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (index.count(key)) pending[key] = std::nullopt;
+    else pending.erase(key);
+}
+
+void KeyValueStorage::RemoveAllKeys() {
+    std::lock_guard<std::mutex> lk(mtx);
+    pending.clear();
+    for (const auto& p : index) pending[p.first] = std::nullopt;
+}
+
+void KeyValueStorage::DiscardPendingChanges() {
+    std::lock_guard<std::mutex> lk(mtx);
+    pending.clear();
+}
+
+size_t KeyValueStorage::fileBytes() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return file_bytes;
+}
+
+bool KeyValueStorage::SyncToStorage() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (pending.empty()) return true;
+    if (fd < 0) return false;
+
+    // One record per changed key, written with a single append
+    std::vector<uint8_t> buf;
+    std::vector<std::pair<const std::string*, Slot>> updates;
+    for (const auto& p : pending) {
+        // A longer key would overflow key_len and break the framing of every later record
+        if (p.first.size() > kMaxKeyBytes) {
+            log_error("Key-value storage: key of " + std::to_string(p.first.size()) + " bytes is too long for " +
+                      path);
+            return false;
+        }
+        if (!p.second) {
+            if (!index.count(p.first)) continue;
+            size_t start = buf.size();
+            encode(buf, p.first, nullptr);
+            updates.push_back({&p.first, Slot{0, 0, static_cast<uint32_t>(buf.size() - start), std::nullopt}});
+            continue;
+        }
+        std::vector<uint8_t> packed = json::to_msgpack(*p.second);
+        size_t start = buf.size();
+        encode(buf, p.first, &packed);
+        Slot slot;
+        slot.offset = file_bytes + start + kRecordHeader + p.first.size();
+        slot.length = static_cast<uint32_t>(packed.size());
+        slot.record = static_cast<uint32_t>(buf.size() - start);
+        if (packed.size() <= options.cache_bytes) slot.cached = *p.second;
+        updates.push_back({&p.first, std::move(slot)});
+    }
+
+    if (!writeAll(fd, buf.data(), buf.size()) || ::fdatasync(fd) != 0) {
+        log_error("Key-value storage: cannot sync " + path + ": " + std::strerror(errno));
+        if (::ftruncate(fd, static_cast<off_t>(file_bytes)) != 0) {
+            log_error("Key-value storage: cannot truncate " + path + ": " + std::strerror(errno));
+        }
+        return false;
+    }
+    file_bytes += buf.size();
+
+    for (auto& u : updates) {
+        auto it = index.find(*u.first);
+        if (it != index.end()) live_bytes -= it->second.record;
+        if (!pending.at(*u.first)) {
+            index.erase(*u.first);
+        } else {
+            live_bytes += u.second.record;
+            index[*u.first] = std::move(u.second);
+        }
+    }
+    pending.clear();
+
+    if (file_bytes >= options.compact_min && live_bytes * 2 < file_bytes) compact();
+    return true;
+}
+
+// Keys are at most kMaxKeyBytes long; SetValue and SyncToStorage check
+void KeyValueStorage::encode(std::vector<uint8_t>& out, const std::string& key, const std::vector<uint8_t>* value) {
+    size_t start = out.size();
+    uint16_t key_len = static_cast<uint16_t>(key.size());
+    uint16_t flags = value ? 0 : kFlagErase;
+    uint32_t value_len = value ? static_cast<uint32_t>(value->size()) : 0;
+    out.resize(start + kRecordHeader);
+    std::memcpy(out.data() + start + 4, &key_len, 2);
+    std::memcpy(out.data() + start + 6, &flags, 2);
+    std::memcpy(out.data() + start + 8, &value_len, 4);
+    out.insert(out.end(), key.begin(), key.end());
+    if (value) out.insert(out.end(), value->begin(), value->end());
+    uint32_t crc = crc32(out.data() + start + 4, out.size() - start - 4);
+    std::memcpy(out.data() + start, &crc, 4);
+}
+
+// Caller holds mtx. Rebuilds the index from the file; small values are decoded
+// right away, large ones on first access.
+void KeyValueStorage::load() {
+    struct stat st{};
+    ::fstat(fd, &st);
+    size_t size = static_cast<size_t>(st.st_size);
+    std::vector<uint8_t> data(size);
+    if (size > 0 && !readAll(fd, data.data(), size, 0)) {
+        log_error("Key-value storage: cannot read " + path + ": " + std::strerror(errno));
+        return;
+    }
+
+    size_t pos = 0;
+    while (pos + kRecordHeader <= size) {
+        uint32_t crc, value_len;
+        uint16_t key_len, flags;
+        std::memcpy(&crc, data.data() + pos, 4);
+        std::memcpy(&key_len, data.data() + pos + 4, 2);
+        std::memcpy(&flags, data.data() + pos + 6, 2);
+        std::memcpy(&value_len, data.data() + pos + 8, 4);
+        size_t len = kRecordHeader + key_len + value_len;
+        if (pos + len > size || crc32(data.data() + pos + 4, len - 4) != crc) break;
+
+        std::string key(reinterpret_cast<const char*>(data.data() + pos + kRecordHeader), key_len);
+        auto it = index.find(key);
+        if (it != index.end()) live_bytes -= it->second.record;
+        if (flags & kFlagErase) {
+            index.erase(key);
+        } else {
+            Slot slot;
+            slot.offset = pos + kRecordHeader + key_len;
+            slot.length = value_len;
+            slot.record = static_cast<uint32_t>(len);
+            if (value_len <= options.cache_bytes) {
+                const uint8_t* v = data.data() + slot.offset;
+                json value = json::from_msgpack(v, v + value_len, true, false);
+                if (value.is_discarded()) break;
+                slot.cached = std::move(value);
+            }
+            live_bytes += len;
+            index[key] = std::move(slot);
+        }
+        pos += len;
+    }
+
+    if (pos < size) {
+        log_warning("Key-value storage " + path + ": dropping " + std::to_string(size - pos) +
+                    " bytes of torn or corrupt records");
+        if (::ftruncate(fd, static_cast<off_t>(pos)) != 0) {
+            log_error("Key-value storage: cannot truncate " + path + ": " + std::strerror(errno));
+        }
+    }
+    file_bytes = pos;
+}
+
+// Caller holds mtx
+std::optional<json> KeyValueStorage::readValue(const Slot& slot) const {
+    std::vector<uint8_t> buf(slot.length);
+    if (!readAll(fd, buf.data(), buf.size(), slot.offset)) {
+        log_error("Key-value storage: cannot read value from " + path + ": " + std::strerror(errno));
+        return std::nullopt;
+    }
+    json value = json::from_msgpack(buf, true, false);
+    if (value.is_discarded()) return std::nullopt;
+    return value;
+}
+
+// Caller holds mtx. Rewrites the file with the live records only, through a
+// synced temporary file renamed over the old one.
+bool KeyValueStorage::compact() {
+    const std::string tmp = path + ".compact";
+    std::vector<uint8_t> buf;
+    std::vector<std::pair<Slot*, Slot>> moved;
+    for (auto& p : index) {
+        std::vector<uint8_t> value(p.second.length);
+        if (!readAll(fd, value.data(), value.size(), p.second.offset)) return false;
+        size_t start = buf.size();
+        encode(buf, p.first, &value);
+        Slot slot;
+        slot.offset = start + kRecordHeader + p.first.size();
+        slot.length = p.second.length;
+        slot.record = static_cast<uint32_t>(buf.size() - start);
+        moved.push_back({&p.second, slot});
+    }
+
+    int out = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = out >= 0 && writeAll(out, buf.data(), buf.size()) && ::fsync(out) == 0 &&
+              ::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        log_error("Key-value storage: cannot compact " + path + ": " + std::strerror(errno));
+        if (out >= 0) ::close(out);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    size_t before = file_bytes;
+    ::close(fd);
+    fd = ::open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC);
+    ::close(out);
+    for (auto& m : moved) {
+        m.first->offset = m.second.offset;
+        m.first->record = m.second.record;
+    }
+    file_bytes = live_bytes = buf.size();
+    log_info("Key-value storage " + path + " compacted from " + std::to_string(before) + " to " +
+             std::to_string(file_bytes) + " bytes");
+    return fd >= 0;
+}
+
+} // namespace common::per
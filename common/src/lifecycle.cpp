@@ -0,0 +1,48 @@
+#include "lifecycle.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+namespace common::lifecycle {
+
+static std::atomic_bool g_ready_sent{false};
+static volatile std::sig_atomic_t g_terminate = 0;
+
+static void onTerminate(int) {
+    g_terminate = 1;
+}
+
+bool isManaged() {
+    return std::getenv(kReadyFdEnv) != nullptr;
+}
+
+void notifyReady() {
+    const char* env = std::getenv(kReadyFdEnv);
+    if (!env || g_ready_sent.exchange(true)) return;
+
+    int fd = std::atoi(env);
+    const char byte = 'R';
+    if (::write(fd, &byte, 1) != 1) {
+        log_warning("Failed to signal readiness to the Service Manager");
+    }
+    ::close(fd);
+}
+
+void waitForTermination() {
+    struct sigaction sa{};
+    sa.sa_handler = onTerminate;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGINT, &sa, nullptr);
+
+    while (!g_terminate) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    log_info("Termination requested by the Service Manager");
+}
+
+} // namespace common::lifecycle
@@ -3,6 +3,8 @@
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include <filesystem>
+#include <atomic>
+#include <unistd.h>
 
 using json = nlohmann::json;
 
@@ -27,8 +29,12 @@ static void save_json_file_atomic(const std::string &filename, const json &j)
     try {
         namespace fs = std::filesystem;
         fs::path target = fs::u8path(filename);
+        // A temp file per save: with group commit a save's temp file waits for
+        // the batch leader to rename it, and a later save of the same file must
+        // not rewrite it in the meantime
+        static std::atomic<uint64_t> tmp_counter{0};
         fs::path tmp = target;
-        tmp += ".tmp";
+        tmp += ".tmp." + std::to_string(::getpid()) + "." + std::to_string(tmp_counter++);
 
         // Write to temporary file first
         {
@@ -38,18 +44,18 @@ static void save_json_file_atomic(const std::string &filename, const json &j)
                 return;
             }
             ofs << j.dump(4);
-            ofs.flush();
             ofs.close();
+            if (!ofs) {
+                log_error(std::string("Failed to write temp file: ") + tmp.string());
+                return;
+            }
         }
 
-        // Atomically replace target with tmp
-        std::error_code ec;
-        if (fs::exists(target, ec)) {
-            fs::remove(target, ec); // ignore error, will attempt rename anyway
-        }
-        fs::rename(tmp, target, ec);
-        if (ec) {
-            log_error(std::string("Failed to rename temp file to target: ") + ec.message());
+        // Atomically replace target with tmp; rename() overwrites in place, so
+        // readers never see the file missing
+        if (!common::DurabilityManager::instance().commitReplace(tmp.string(), target.string())) {
+            std::error_code ec;
+            if (!fs::exists(tmp, ec)) return;
             // attempt non-atomic fallback: copy & remove
             fs::copy_file(tmp, target, fs::copy_options::overwrite_existing, ec);
             if (!ec) fs::remove(tmp, ec);
@@ -80,4 +86,8 @@ nlohmann::json Persistence::loadState(const std::string& filename)
 void Persistence::saveState(const std::string& filename, const nlohmann::json& state)
 {
     save_json_file_atomic(filename, state);
-}
\ No newline at end of file
+}
+void Persistence::setDurability(const common::DurabilityOptions& options)
+{
+    common::DurabilityManager::instance().configure(options);
+}
@@ -0,0 +1,92 @@
+#include "persistency_client.hpp"
+#include "rpc_frame.hpp"
+#include "logging.hpp"
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace common::per {
+
+PersistencyClient::PersistencyClient(std::string service, std::string socket_path)
+    : service(std::move(service)), socket_path(std::move(socket_path)) {}
+
+PersistencyClient::~PersistencyClient() {
+    disconnect();
+}
+
+bool PersistencyClient::connect(std::chrono::milliseconds timeout) {
+    disconnect();
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) return false;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        disconnect();
+        return false;
+    }
+    // A hung daemon must not block the service's writer forever
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((timeout.count() % 1000) * 1000);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return true;
+}
+
+void PersistencyClient::disconnect() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+bool PersistencyClient::request(const json& req, json& reply) {
+    if (fd < 0) return false;
+    std::string out;
+    if (!rpc::call(fd, service, req.dump(), out)) {
+        log_error("Persistency request of " + service + " failed" + (out.empty() ? "" : ": " + out));
+        disconnect();
+        return false;
+    }
+    reply = json::parse(out, nullptr, false);
+    return !reply.is_discarded();
+}
+
+std::optional<json> PersistencyClient::load() {
+    json reply;
+    if (!request(json{{"op", "load"}}, reply)) return std::nullopt;
+    json state = reply.value("state", json::object());
+    if (!state.is_object()) return std::nullopt;
+    stored = state;
+    return state;
+}
+
+bool PersistencyClient::save(const json& state) {
+    if (!state.is_object()) return false;
+    json set = json::object();
+    std::vector<std::string> erase;
+    for (auto it = state.begin(); it != state.end(); ++it) {
+        auto cur = stored.find(it.key());
+        if (cur == stored.end() || *cur != it.value()) set[it.key()] = it.value();
+    }
+    for (auto it = stored.begin(); it != stored.end(); ++it) {
+        if (!state.contains(it.key())) erase.push_back(it.key());
+    }
+    if (set.empty() && erase.empty()) return true;
+    return update(set, erase);
+}
+
+bool PersistencyClient::update(const json& set, const std::vector<std::string>& erase) {
+    json reply;
+    if (!request(json{{"op", "update"}, {"set", set}, {"erase", erase}}, reply)) return false;
+    for (auto it = set.begin(); it != set.end(); ++it) stored[it.key()] = it.value();
+    for (const auto& key : erase) stored.erase(key);
+    return true;
+}
+
+} // namespace common::per
@@ -0,0 +1,105 @@
+#include "rpc_frame.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace common::rpc {
+
+void encodeHeader(const FrameHeader& h, uint8_t* out) {
+    out[0] = static_cast<uint8_t>(kMagic >> 8);
+    out[1] = static_cast<uint8_t>(kMagic & 0xff);
+    out[2] = h.flags;
+    out[3] = h.name_len;
+    out[4] = static_cast<uint8_t>(h.payload_len >> 24);
+    out[5] = static_cast<uint8_t>(h.payload_len >> 16);
+    out[6] = static_cast<uint8_t>(h.payload_len >> 8);
+    out[7] = static_cast<uint8_t>(h.payload_len);
+}
+
+bool decodeHeader(const uint8_t* in, FrameHeader& h) {
+    uint16_t magic = static_cast<uint16_t>((in[0] << 8) | in[1]);
+    if (magic != kMagic) return false;
+    h.flags = in[2];
+    h.name_len = in[3];
+    h.payload_len = (uint32_t(in[4]) << 24) | (uint32_t(in[5]) << 16) | (uint32_t(in[6]) << 8) | in[7];
+    return h.payload_len <= kMaxPayload;
+}
+
+bool readFull(int fd, void* buf, std::size_t len) {
+    auto* p = static_cast<uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = ::recv(fd, p, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool writeFull(int fd, const void* buf, std::size_t len, int flags) {
+    auto* p = static_cast<const uint8_t*>(buf);
+    while (len > 0) {
+        ssize_t n = ::send(fd, p, len, flags | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool sendFrame(int fd, const std::string& service, const void* payload, std::size_t len, uint8_t flags) {
+    if (service.size() > 255 || len > kMaxPayload) return false;
+    FrameHeader h;
+    h.flags = flags;
+    h.name_len = static_cast<uint8_t>(service.size());
+    h.payload_len = static_cast<uint32_t>(len);
+
+    // Header and name are coalesced with the payload into one segment
+    uint8_t head[kHeaderSize + 255];
+    encodeHeader(h, head);
+    std::copy(service.begin(), service.end(), head + kHeaderSize);
+    return writeFull(fd, head, kHeaderSize + service.size(), len > 0 ? MSG_MORE : 0) &&
+           writeFull(fd, payload, len);
+}
+
+bool recvFrame(int fd, FrameHeader& h, std::string& service, std::string& payload) {
+    uint8_t head[kHeaderSize];
+    if (!readFull(fd, head, sizeof(head)) || !decodeHeader(head, h)) return false;
+    service.resize(h.name_len);
+    payload.resize(h.payload_len);
+    return readFull(fd, &service[0], h.name_len) && readFull(fd, &payload[0], h.payload_len);
+}
+
+int connectTcp(const std::string& host, int port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) return -1;
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool call(int fd, const std::string& service, const std::string& request, std::string& reply) {
+    FrameHeader h;
+    std::string name;
+    if (!sendFrame(fd, service, request.data(), request.size()) || !recvFrame(fd, h, name, reply)) {
+        return false;
+    }
+    return (h.flags & kFlagError) == 0;
+}
+
+} // namespace common::rpc
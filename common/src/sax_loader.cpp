@@ -0,0 +1,149 @@
+#include "sax_loader.hpp"
+
+using json = nlohmann::json;
+
+namespace common::sax {
+
+namespace {
+
+// Routes nlohmann's SAX events to the binding of the current value.
+// Subtrees without a binding are skipped by counting their depth.
+class Driver : public json::json_sax_t {
+public:
+    explicit Driver(Binding& root) : root(&root) {}
+
+    bool null() override {
+        return scalar([](Binding* b) { return b->onNull(); });
+    }
+    bool boolean(bool v) override {
+        return scalar([v](Binding* b) { return b->onBool(v); });
+    }
+    bool number_integer(number_integer_t v) override {
+        return scalar([v](Binding* b) { return b->onInt(v); });
+    }
+    bool number_unsigned(number_unsigned_t v) override {
+        return scalar([v](Binding* b) { return b->onUint(v); });
+    }
+    bool number_float(number_float_t v, const string_t&) override {
+        return scalar([v](Binding* b) { return b->onDouble(v); });
+    }
+    bool string(string_t& v) override {
+        return scalar([&v](Binding* b) { return b->onString(v); });
+    }
+    bool binary(binary_t&) override {
+        return scalar([](Binding*) { return false; });
+    }
+
+    bool start_object(std::size_t) override {
+        return open([](Binding* b) { return b->beginObject(); }, false);
+    }
+    bool key(string_t& k) override {
+        if (skip_depth > 0) return true;
+        frames.back().key = k;
+        pending = frames.back().binding->key(k);
+        return true;
+    }
+    bool end_object() override {
+        return close([](Binding* b) { return b->endObject(); });
+    }
+    bool start_array(std::size_t) override {
+        return open([](Binding* b) { return b->beginArray(); }, true);
+    }
+    bool end_array() override {
+        return close([](Binding* b) { return b->endArray(); });
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+        if (error.empty()) error = "syntax error at byte " + std::to_string(position) + ": " + ex.what();
+        return false;
+    }
+
+    std::string error;
+
+private:
+    struct Frame {
+        Binding* binding;
+        bool array;
+        std::string key;
+    };
+
+    // Binding for the value that starts now; nullptr to skip it
+    Binding* next() {
+        if (frames.empty()) return std::exchange(root, nullptr);
+        if (frames.back().array) return frames.back().binding->element();
+        return std::exchange(pending, nullptr);
+    }
+
+    template <typename F>
+    bool scalar(F event) {
+        if (skip_depth > 0) return true;
+        Binding* b = next();
+        if (!b) return true;
+        if (!event(b)) return reject(b);
+        b->finish();
+        return true;
+    }
+
+    template <typename F>
+    bool open(F event, bool array) {
+        if (skip_depth > 0) {
+            skip_depth++;
+            return true;
+        }
+        Binding* b = next();
+        if (!b) {
+            skip_depth = 1;
+            return true;
+        }
+        if (!event(b)) return reject(b);
+        frames.push_back(Frame{b, array, {}});
+        return true;
+    }
+
+    template <typename F>
+    bool close(F event) {
+        if (skip_depth > 0) {
+            skip_depth--;
+            return true;
+        }
+        Binding* b = frames.back().binding;
+        bool ok = event(b);
+        if (!ok) return reject(b);
+        frames.pop_back();
+        b->finish();
+        return true;
+    }
+
+    bool reject(Binding* b) {
+        std::string where;
+        for (const auto& f : frames) {
+            if (!f.array && !f.key.empty()) where += "/" + f.key;
+        }
+        std::string why = b->error();
+        error = (why.empty() ? std::string("unexpected value type") : why) + " at " + (where.empty() ? "/" : where);
+        return false;
+    }
+
+    Binding* root;
+    Binding* pending = nullptr;
+    std::vector<Frame> frames;
+    std::size_t skip_depth = 0;
+};
+
+} // namespace
+
+bool parse(std::FILE* file, Binding& root, std::string& error) {
+    Driver driver(root);
+    bool ok = json::sax_parse(file, &driver);
+    if (!ok) error = driver.error.empty() ? "invalid document" : driver.error;
+    return ok;
+}
+
+bool parse(std::string_view text, Binding& root, std::string& error) {
+    Driver driver(root);
+    bool ok = json::sax_parse(text, &driver);
+    if (!ok) error = driver.error.empty() ? "invalid document" : driver.error;
+    return ok;
+}
+
+} // namespace common::sax
@@ -0,0 +1,265 @@
+#include "state_image.hpp"
+#include "checksum.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr char kMagic[4] = {'I', 'V', 'S', 'I'};
+constexpr std::size_t kHeaderSize = 32;
+constexpr std::size_t kCrcOffset = 12;
+constexpr std::size_t kEntrySize = 16;
+
+// CRC of everything except the crc field
+uint32_t imageCrc(const uint8_t* data, std::size_t len) {
+    uint32_t crc = common::crc32(data, kCrcOffset);
+    return common::crc32(data + kCrcOffset + 4, len - kCrcOffset - 4, crc);
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& buf, std::size_t at, T value) {
+    std::memcpy(buf.data() + at, &value, sizeof(T));
+}
+
+} // namespace
+
+namespace common {
+
+bool StateImage::write(const std::string& path, const json& state, uint64_t sequence) {
+    if (!state.is_object()) return false;
+    static_assert(sizeof(Entry) == kEntrySize, "entry layout");
+
+    std::vector<std::string> keys;
+    for (auto it = state.begin(); it != state.end(); ++it) keys.push_back(it.key());
+    std::sort(keys.begin(), keys.end());
+    // A truncated key would break the sort order lookups rely on
+    for (const auto& key : keys) {
+        if (key.size() > UINT16_MAX) {
+            log_error("State image: key of " + std::to_string(key.size()) + " bytes is too long for " + path);
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> buf(kHeaderSize + keys.size() * kEntrySize);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        const json& v = state.at(keys[i]);
+        Entry e{};
+        e.key_offset = static_cast<uint32_t>(buf.size());
+        e.key_len = static_cast<uint16_t>(keys[i].size());
+        buf.insert(buf.end(), keys[i].begin(), keys[i].end());
+        buf.resize((buf.size() + 7) & ~std::size_t{7}); // 8-aligned values
+
+        std::vector<uint8_t> value;
+        if (v.is_null()) {
+            e.type = static_cast<uint8_t>(Type::Null);
+        } else if (v.is_boolean()) {
+            e.type = static_cast<uint8_t>(Type::Bool);
+            value.push_back(v.get<bool>() ? 1 : 0);
+        } else if (v.is_number_integer()) {
+            e.type = static_cast<uint8_t>(Type::Int);
+            int64_t n = v.get<int64_t>();
+            value.resize(8);
+            std::memcpy(value.data(), &n, 8);
+        } else if (v.is_number_float()) {
+            e.type = static_cast<uint8_t>(Type::Double);
+            double d = v.get<double>();
+            value.resize(8);
+            std::memcpy(value.data(), &d, 8);
+        } else if (v.is_string()) {
+            e.type = static_cast<uint8_t>(Type::String);
+            const std::string& s = v.get_ref<const std::string&>();
+            value.assign(s.begin(), s.end());
+        } else {
+            e.type = static_cast<uint8_t>(Type::Json);
+            value = json::to_msgpack(v);
+        }
+        e.value_offset = static_cast<uint32_t>(buf.size());
+        e.value_len = static_cast<uint32_t>(value.size());
+        buf.insert(buf.end(), value.begin(), value.end());
+        std::memcpy(buf.data() + kHeaderSize + i * kEntrySize, &e, kEntrySize);
+    }
+
+    std::memcpy(buf.data(), kMagic, 4);
+    put<uint16_t>(buf, 4, kVersion);
+    put<uint16_t>(buf, 6, static_cast<uint16_t>(kHeaderSize));
+    put<uint32_t>(buf, 8, static_cast<uint32_t>(keys.size()));
+    put<uint64_t>(buf, 16, sequence);
+    put<uint64_t>(buf, 24, buf.size());
+    put<uint32_t>(buf, kCrcOffset, imageCrc(buf.data(), buf.size()));
+
+    const std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0;
+    for (std::size_t done = 0; ok && done < buf.size();) {
+        ssize_t n = ::write(fd, buf.data() + done, buf.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) done += static_cast<std::size_t>(n);
+    }
+    ok = ok && ::fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    ok = ok && ::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        log_error("State image: cannot write " + path + ": " + std::strerror(errno));
+        ::unlink(tmp.c_str());
+    }
+    return ok;
+}
+
+std::unique_ptr<StateImage> StateImage::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || static_cast<std::size_t>(st.st_size) < kHeaderSize) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::size_t length = static_cast<std::size_t>(st.st_size);
+    void* map = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        log_error("State image: cannot map " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(map);
+    uint16_t version, header_size;
+    uint32_t count, crc;
+    uint64_t seq, total;
+    std::memcpy(&version, data + 4, 2);
+    std::memcpy(&header_size, data + 6, 2);
+    std::memcpy(&count, data + 8, 4);
+    std::memcpy(&crc, data + kCrcOffset, 4);
+    std::memcpy(&seq, data + 16, 8);
+    std::memcpy(&total, data + 24, 8);
+
+    bool valid = std::memcmp(data, kMagic, 4) == 0 && version == kVersion && header_size == kHeaderSize &&
+                 total == length && kHeaderSize + std::size_t{count} * kEntrySize <= length &&
+                 imageCrc(data, length) == crc;
+    if (valid) {
+        // The checksum vouches for the content, not for the offsets of a buggy writer
+        for (uint32_t i = 0; valid && i < count; ++i) {
+            Entry e;
+            std::memcpy(&e, data + kHeaderSize + i * kEntrySize, kEntrySize);
+            Type type = static_cast<Type>(e.type);
+            valid = std::size_t{e.key_offset} + e.key_len <= length &&
+                    std::size_t{e.value_offset} + e.value_len <= length && e.type <= uint8_t(Type::Json) &&
+                    (type != Type::Bool || e.value_len == 1) &&
+                    ((type != Type::Int && type != Type::Double) || e.value_len == 8);
+        }
+    }
+    if (!valid) {
+        log_warning("State image " + path + " is invalid; ignoring it");
+        ::munmap(map, length);
+        return nullptr;
+    }
+    return std::unique_ptr<StateImage>(new StateImage(data, length, count, seq));
+}
+
+StateImage::~StateImage() {
+    ::munmap(const_cast<uint8_t*>(data), length);
+}
+
+const StateImage::Entry* StateImage::entry(uint32_t i) const {
+    return reinterpret_cast<const Entry*>(data + kHeaderSize + i * kEntrySize);
+}
+
+std::string_view StateImage::keyOf(const Entry& e) const {
+    return std::string_view(reinterpret_cast<const char*>(data + e.key_offset), e.key_len);
+}
+
+const StateImage::Entry* StateImage::find(std::string_view key) const {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = keyOf(*entry(mid)).compare(key);
+        if (cmp == 0) return entry(mid);
+        if (cmp < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return nullptr;
+}
+
+bool StateImage::contains(std::string_view key) const {
+    return find(key) != nullptr;
+}
+
+std::optional<bool> StateImage::getBool(std::string_view key) const {
+    const Entry* e = find(key);
+    if (!e || e->type != static_cast<uint8_t>(Type::Bool) || e->value_len != 1) return std::nullopt;
+    return data[e->value_offset] != 0;
+}
+
+std::optional<int64_t> StateImage::getInt(std::string_view key) const {
+    const Entry* e = find(key);
+    if (!e || e->type != static_cast<uint8_t>(Type::Int) || e->value_len != 8) return std::nullopt;
+    int64_t n;
+    std::memcpy(&n, data + e->value_offset, 8);
+    return n;
+}
+
+std::optional<double> StateImage::getDouble(std::string_view key) const {
+    const Entry* e = find(key);
+    if (!e || e->value_len != 8) return std::nullopt;
+    if (e->type == static_cast<uint8_t>(Type::Int)) return static_cast<double>(*getInt(key));
+    if (e->type != static_cast<uint8_t>(Type::Double)) return std::nullopt;
+    double d;
+    std::memcpy(&d, data + e->value_offset, 8);
+    return d;
+}
+
+std::optional<std::string_view> StateImage::getString(std::string_view key) const {
+    const Entry* e = find(key);
+    if (!e || e->type != static_cast<uint8_t>(Type::String)) return std::nullopt;
+    return std::string_view(reinterpret_cast<const char*>(data + e->value_offset), e->value_len);
+}
+
+json StateImage::decode(const Entry& e) const {
+    switch (static_cast<Type>(e.type)) {
+    case Type::Bool:
+        return data[e.value_offset] != 0;
+    case Type::Int: {
+        int64_t n;
+        std::memcpy(&n, data + e.value_offset, 8);
+        return n;
+    }
+    case Type::Double: {
+        double d;
+        std::memcpy(&d, data + e.value_offset, 8);
+        return d;
+    }
+    case Type::String:
+        return std::string(reinterpret_cast<const char*>(data + e.value_offset), e.value_len);
+    case Type::Json: {
+        json v = json::from_msgpack(data + e.value_offset, data + e.value_offset + e.value_len, true, false);
+        return v.is_discarded() ? json() : v;
+    }
+    default:
+        return json();
+    }
+}
+
+json StateImage::get(std::string_view key) const {
+    const Entry* e = find(key);
+    return e ? decode(*e) : json();
+}
+
+json StateImage::toJson() const {
+    json out = json::object();
+    for (uint32_t i = 0; i < count; ++i) {
+        const Entry* e = entry(i);
+        out[std::string(keyOf(*e))] = decode(*e);
+    }
+    return out;
+}
+
+} // namespace common
@@ -0,0 +1,328 @@
+#include "state_journal.hpp"
+#include "checksum.hpp"
+#include "durability.hpp"
+#include "logging.hpp"
+#include "persistence.hpp"
+#include "state_image.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+bool writeAll(int fd, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+namespace common {
+
+StateJournal::StateJournal(std::string path) : StateJournal(std::move(path), Options{}) {}
+
+StateJournal::StateJournal(std::string path, Options options)
+    : path(path), journal_path(path + ".journal"), rotated_path(path + ".journal.old"),
+      image_path(path + ".img"), legacy_snapshot_path(path + ".snap"), options(options) {}
+
+StateJournal::~StateJournal() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+    }
+    compact_cv.notify_all();
+    if (compactor.joinable()) compactor.join();
+    // Fold the journal into the image so the next start maps it without replaying
+    if (fd >= 0 && journal_bytes > 0 && writeSnapshot(state, seq)) {
+        std::error_code ec;
+        std::filesystem::remove(rotated_path, ec);
+        if (::ftruncate(fd, 0) != 0) log_warning("State journal " + path + ": cannot truncate journal");
+    }
+    if (fd >= 0) ::close(fd);
+}
+
+json StateJournal::recover() {
+    namespace fs = std::filesystem;
+    std::lock_guard<std::mutex> lk(mtx);
+    state = json::object();
+    seq = 0;
+
+    std::error_code ec;
+    bool journaled = fs::exists(image_path, ec) || fs::exists(legacy_snapshot_path, ec) ||
+                     fs::exists(journal_path, ec) || fs::exists(rotated_path, ec);
+    if (journaled) {
+        if (auto image = StateImage::open(image_path)) {
+            state = image->toJson();
+            seq = image->sequence();
+        } else {
+            // JSON snapshots of earlier versions
+            json snap = Persistence::loadState(legacy_snapshot_path);
+            if (snap.is_object() && snap.contains("state") && snap["state"].is_object()) {
+                state = snap["state"];
+                seq = snap.value("seq", uint64_t{0});
+            }
+        }
+        seq = replay(rotated_path, seq, false);
+        seq = replay(journal_path, seq, true);
+    } else {
+        json legacy = Persistence::loadState(path);
+        if (legacy.is_object()) state = legacy;
+    }
+
+    // A compaction was interrupted, or the state came from the plain document:
+    // make the snapshot cover everything before appending
+    if (fs::exists(rotated_path, ec) || !journaled) {
+        if (writeSnapshot(state, seq)) fs::remove(rotated_path, ec);
+    }
+    if (!openJournal()) return state;
+    if (!compactor.joinable()) compactor = std::thread([this]() { runCompactor(); });
+    return state;
+}
+
+size_t StateJournal::save(const json& next) {
+    if (!next.is_object()) {
+        log_error("State journal " + path + ": state must be a JSON object");
+        return 0;
+    }
+    std::lock_guard<std::mutex> lk(mtx);
+    size_t written = 0;
+    for (auto it = next.begin(); it != next.end(); ++it) {
+        auto cur = state.find(it.key());
+        if (cur != state.end() && *cur == it.value()) continue;
+        if (append(it.key(), &it.value())) written++;
+    }
+    std::vector<std::string> removed;
+    for (auto it = state.begin(); it != state.end(); ++it) {
+        if (!next.contains(it.key())) removed.push_back(it.key());
+    }
+    for (const auto& key : removed) {
+        if (append(key, nullptr)) written++;
+    }
+    if (written > 0) commit();
+    return written;
+}
+
+bool StateJournal::put(const std::string& key, const json& value) {
+    std::lock_guard<std::mutex> lk(mtx);
+    return append(key, &value) && commit();
+}
+
+bool StateJournal::erase(const std::string& key) {
+    std::lock_guard<std::mutex> lk(mtx);
+    return append(key, nullptr) && commit();
+}
+
+bool StateJournal::apply(const json& set, const std::vector<std::string>& erase, size_t* written) {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (written) *written = 0;
+    if (fd < 0) return false;
+    const size_t start_bytes = journal_bytes;
+    const uint64_t start_seq = seq;
+    std::vector<std::pair<std::string, json>> undo; // previous values; discarded json if absent
+
+    auto record = [&](const std::string& key, const json* value) {
+        auto cur = state.find(key);
+        undo.emplace_back(key, cur != state.end() ? *cur : json(json::value_t::discarded));
+        return append(key, value);
+    };
+    bool ok = true;
+    if (set.is_object()) {
+        for (auto it = set.begin(); ok && it != set.end(); ++it) {
+            auto cur = state.find(it.key());
+            if (cur != state.end() && *cur == it.value()) continue;
+            ok = record(it.key(), &it.value());
+        }
+    }
+    for (size_t i = 0; ok && i < erase.size(); ++i) {
+        if (state.contains(erase[i])) ok = record(erase[i], nullptr);
+    }
+    if (ok && !undo.empty()) ok = commit();
+    if (ok) {
+        if (written) *written = undo.size();
+        return true;
+    }
+
+    // Roll the whole batch back: no record of it survives a restart either
+    if (::ftruncate(fd, static_cast<off_t>(start_bytes)) != 0) {
+        log_error("State journal " + path + ": cannot roll back failed batch: " + std::strerror(errno));
+    }
+    journal_bytes = start_bytes;
+    seq = start_seq;
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+        if (it->second.is_discarded()) state.erase(it->first);
+        else state[it->first] = std::move(it->second);
+    }
+    return false;
+}
+
+uint64_t StateJournal::sequence() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return seq;
+}
+
+size_t StateJournal::journalBytes() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return journal_bytes;
+}
+
+uint64_t StateJournal::compactions() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return compaction_count;
+}
+
+bool StateJournal::append(const std::string& key, const json* value) {
+    if (fd < 0 || key.size() > UINT16_MAX) return false;
+    std::vector<uint8_t> packed;
+    if (value) packed = json::to_msgpack(*value);
+
+    uint64_t rseq = seq + 1;
+    uint16_t key_len = static_cast<uint16_t>(key.size());
+    uint16_t flags = value ? 0 : kFlagErase;
+    uint32_t value_len = static_cast<uint32_t>(packed.size());
+    std::vector<uint8_t> rec(kRecordHeader + key.size() + packed.size());
+    std::memcpy(rec.data() + 4, &rseq, 8);
+    std::memcpy(rec.data() + 12, &key_len, 2);
+    std::memcpy(rec.data() + 14, &flags, 2);
+    std::memcpy(rec.data() + 16, &value_len, 4);
+    std::memcpy(rec.data() + kRecordHeader, key.data(), key.size());
+    if (!packed.empty()) std::memcpy(rec.data() + kRecordHeader + key.size(), packed.data(), packed.size());
+    uint32_t crc = crc32(rec.data() + 4, rec.size() - 4);
+    std::memcpy(rec.data(), &crc, 4);
+
+    if (!writeAll(fd, rec.data(), rec.size())) {
+        log_error("State journal " + path + ": append failed: " + std::strerror(errno));
+        // Drop a partial record, or replay would stop at it and lose later ones
+        if (::ftruncate(fd, static_cast<off_t>(journal_bytes)) != 0) {
+            log_error("State journal " + path + ": cannot drop partial record: " + std::strerror(errno));
+        }
+        return false;
+    }
+    seq = rseq;
+    journal_bytes += rec.size();
+    if (value) state[key] = *value;
+    else state.erase(key);
+    return true;
+}
+
+// Caller holds mtx. Commits the records appended since the last commit, then
+// rotates a full journal: a record never moves to the rotated file before it
+// is as durable as the mode promises.
+bool StateJournal::commit() {
+    bool ok = DurabilityManager::instance().commitAppend(journal_path, fd);
+    if (ok && journal_bytes >= options.compact_bytes && !compact_pending) rotate();
+    return ok;
+}
+
+// Caller holds mtx. Starts a new journal and hands the state it covers to the compactor.
+void StateJournal::rotate() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    // A failed compaction left its input behind: snapshot again without rotating over it
+    if (!fs::exists(rotated_path, ec)) {
+        ::close(fd);
+        fd = -1;
+        fs::rename(journal_path, rotated_path, ec);
+        if (ec) log_error("State journal " + path + ": cannot rotate: " + ec.message());
+        if (!openJournal()) return;
+    }
+    compact_state = state;
+    compact_seq = seq;
+    compact_pending = true;
+    compact_cv.notify_all();
+}
+
+bool StateJournal::openJournal() {
+    fd = ::open(journal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log_error("State journal " + path + ": cannot open journal: " + std::strerror(errno));
+        return false;
+    }
+    struct stat st{};
+    ::fstat(fd, &st);
+    journal_bytes = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+// Caller holds mtx. Applies the records of `file` newer than `after`; returns the last sequence.
+uint64_t StateJournal::replay(const std::string& file, uint64_t after, bool truncate_torn) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) return after;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    uint64_t last = after;
+    while (pos + kRecordHeader <= data.size()) {
+        uint32_t crc, value_len;
+        uint64_t rseq;
+        uint16_t key_len, flags;
+        std::memcpy(&crc, data.data() + pos, 4);
+        std::memcpy(&rseq, data.data() + pos + 4, 8);
+        std::memcpy(&key_len, data.data() + pos + 12, 2);
+        std::memcpy(&flags, data.data() + pos + 14, 2);
+        std::memcpy(&value_len, data.data() + pos + 16, 4);
+        size_t len = kRecordHeader + key_len + value_len;
+        if (pos + len > data.size() || crc32(data.data() + pos + 4, len - 4) != crc) break;
+
+        if (rseq > last) {
+            std::string key(reinterpret_cast<const char*>(data.data() + pos + kRecordHeader), key_len);
+            if (flags & kFlagErase) {
+                state.erase(key);
+            } else {
+                const uint8_t* v = data.data() + pos + kRecordHeader + key_len;
+                json value = json::from_msgpack(v, v + value_len, true, false);
+                if (value.is_discarded()) break;
+                state[key] = std::move(value);
+            }
+            last = rseq;
+        }
+        pos += len;
+    }
+
+    if (pos < data.size()) {
+        log_warning("State journal " + file + ": dropping " + std::to_string(data.size() - pos) +
+                    " bytes of torn or corrupt records");
+        if (truncate_torn) ::truncate(file.c_str(), static_cast<off_t>(pos));
+    }
+    return last;
+}
+
+void StateJournal::runCompactor() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        compact_cv.wait(lk, [this]() { return compact_pending || stopping; });
+        if (!compact_pending) return;
+        json snap_state = std::move(compact_state);
+        uint64_t snap_seq = compact_seq;
+
+        lk.unlock();
+        bool ok = writeSnapshot(snap_state, snap_seq);
+        std::error_code ec;
+        if (ok) std::filesystem::remove(rotated_path, ec);
+        lk.lock();
+
+        compact_pending = false;
+        if (ok) compaction_count++;
+    }
+}
+
+bool StateJournal::writeSnapshot(const json& snap_state, uint64_t snap_seq) {
+    return StateImage::write(image_path, snap_state, snap_seq);
+}
+
+} // namespace common
@@ -0,0 +1,174 @@
+#include "write_behind.hpp"
+#include "persistence.hpp"
+#include "state_journal.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace common {
+
+WriteBehind::WriteBehind(std::string filename, Snapshot snapshot)
+    : WriteBehind(std::move(filename), std::move(snapshot), Options{}) {}
+
+WriteBehind::WriteBehind(std::string filename, Snapshot snapshot, Options options)
+    : filename(std::move(filename)), pending_path(this->filename + ".pending"), snapshot(std::move(snapshot)),
+      options(options) {
+    if (options.journaled) {
+        journal = std::make_unique<StateJournal>(this->filename, StateJournal::Options{options.compact_bytes});
+    }
+    writer = std::thread([this]() { run(); });
+}
+
+WriteBehind::~WriteBehind() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (writer.joinable()) writer.join();
+}
+
+nlohmann::json WriteBehind::load() {
+    if (!options.persistency_service.empty()) {
+        std::error_code ec;
+        local_newer = std::filesystem::exists(pending_path, ec);
+        auto client = std::make_unique<per::PersistencyClient>(options.persistency_service,
+                                                               options.persistency_socket);
+        std::optional<nlohmann::json> stored;
+        if (client->connect()) stored = client->load();
+        if (stored) {
+            daemon = std::move(client);
+            if (!local_newer && !stored->empty()) return *stored;
+            // Never moved to the daemon, or written locally while it was away
+            nlohmann::json local = loadLocal();
+            if (!local_newer && local.empty()) return local;
+            if (daemon->save(local)) {
+                log_info("Moved " + filename + " to the persistency daemon");
+                clearPending();
+            } else {
+                log_warning("Persistency daemon unavailable; storing " + filename + " locally");
+                daemon.reset();
+            }
+            return local;
+        }
+        log_warning("Persistency daemon unavailable; storing " + filename + " locally");
+        next_reconnect = std::chrono::steady_clock::now() + options.reconnect_interval;
+    }
+    return loadLocal();
+}
+
+nlohmann::json WriteBehind::loadLocal() {
+    local_loaded = true;
+    nlohmann::json state = journal ? journal->recover() : Persistence::loadState(filename);
+    return state.is_object() ? state : nlohmann::json::object();
+}
+
+// Marks the local copy as newer than the daemon's before it gets so, so
+// that it wins at the next start even if the service dies right after.
+void WriteBehind::saveLocal(const nlohmann::json& state) {
+    if (!options.persistency_service.empty() && !local_newer) {
+        std::ofstream marker(pending_path, std::ios::trunc);
+        local_newer = static_cast<bool>(marker);
+        if (!local_newer) log_error("Cannot create " + pending_path);
+    }
+    if (journal) journal->save(state);
+    else Persistence::saveState(filename, state);
+}
+
+void WriteBehind::clearPending() {
+    if (!local_newer) return;
+    std::error_code ec;
+    std::filesystem::remove(pending_path, ec);
+    local_newer = false;
+}
+
+// Writer thread; at most once per reconnect_interval
+bool WriteBehind::reconnect() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_reconnect) return false;
+    next_reconnect = now + options.reconnect_interval;
+    auto client = std::make_unique<per::PersistencyClient>(options.persistency_service, options.persistency_socket);
+    if (!client->connect() || !client->load()) return false;
+    daemon = std::move(client);
+    log_info("Persistency daemon back; storing " + filename + " through it");
+    return true;
+}
+
+void WriteBehind::markDirty() {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        auto now = std::chrono::steady_clock::now();
+        wake = !dirty;
+        if (!dirty) first_mark = now;
+        dirty = true;
+        last_mark = now;
+        marked_seq++;
+    }
+    // Later marks only extend the quiet window; the writer re-checks it when it wakes
+    if (wake) cv.notify_all();
+}
+
+void WriteBehind::flush() {
+    std::unique_lock<std::mutex> lk(mtx);
+    uint64_t target = marked_seq;
+    if (written_seq >= target) return;
+    if (dirty) flush_requested = true;
+    cv.notify_all();
+    cv.wait(lk, [&]() { return written_seq >= target; });
+}
+
+uint64_t WriteBehind::writes() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return write_count;
+}
+
+uint64_t WriteBehind::updates() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return marked_seq;
+}
+
+void WriteBehind::run() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        cv.wait(lk, [this]() { return dirty || stopping; });
+        if (!dirty) return;
+
+        // Coalesce until the state is quiet or the oldest change is max_delay old
+        while (!stopping && !flush_requested) {
+            auto due = std::min(last_mark + options.window, first_mark + options.max_delay);
+            if (std::chrono::steady_clock::now() >= due) break;
+            cv.wait_until(lk, due);
+        }
+        dirty = false;
+        flush_requested = false;
+        uint64_t seq = marked_seq;
+
+        lk.unlock();
+        try {
+            nlohmann::json state = snapshot();
+            if (!daemon && !options.persistency_service.empty()) reconnect();
+            if (daemon && daemon->save(state)) {
+                clearPending();
+            } else if (daemon) {
+                log_warning("Persistency daemon lost; storing " + filename + " locally");
+                daemon.reset();
+                next_reconnect = std::chrono::steady_clock::now() + options.reconnect_interval;
+            }
+            if (!daemon) {
+                if (!local_loaded) loadLocal();
+                saveLocal(state);
+            }
+        } catch (const std::exception& e) {
+            log_error("Write-behind of " + filename + " failed: " + e.what());
+        }
+        lk.lock();
+
+        write_count++;
+        written_seq = seq;
+        cv.notify_all();
+    }
+}
+
+} // namespace common
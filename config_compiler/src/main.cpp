@@ -0,0 +1,25 @@
+#include <iostream>
+#include <string>
+#include "../../common/include/config_image.hpp"
+
+// Build step: compile config/services.json into the binary image that
+// processes map at startup (see common/include/config_image.hpp).
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "usage: config_compiler <services.json> <services.img>" << std::endl;
+        return 1;
+    }
+    std::string error;
+    if (!common::ConfigImage::compile(argv[1], argv[2], &error)) {
+        std::cerr << "config_compiler: " << error << std::endl;
+        return 1;
+    }
+    auto image = common::ConfigImage::open(argv[2]);
+    if (!image) {
+        std::cerr << "config_compiler: " << argv[2] << " does not validate" << std::endl;
+        return 1;
+    }
+    std::cout << "config_compiler: " << image->size() << " services -> " << argv[2] << std::endl;
+    return 0;
+}
@@ -1,13 +1,31 @@
 #include <iostream>
+#include <mutex>
 #include <string>
 #include "someip.hpp"
 #include "logging.hpp"
+#include "config_image.hpp"
+#include "config_watcher.hpp"
 
 class HMIClient {
 public:
-    HMIClient() {
-        // Initialize the client
-        log_info("HMI Client initialized.");
+    // Endpoints come from the compiled manifest image in `config_dir` (its
+    // services.json during development, or when the image is stale)
+    explicit HMIClient(const std::string& config_dir)
+        : config(config_dir + "/services.img", config_dir + "/services.json"),
+          watcher(config_dir + "/services.json") {
+        if (auto media = config.find("MediaService")) media_endpoint = std::string(media->endpoint);
+        log_info("HMI Client initialized (Media Service at " +
+                 (media_endpoint.empty() ? std::string("unknown endpoint") : media_endpoint) + ").");
+        // Follow edits of the manifest; only a change of the Media Service entry lands here
+        watcher.subscribe("MediaService", [this](const std::string&, const common::ConfigWatcher::Entry& media) {
+            std::lock_guard<std::mutex> lk(endpoint_mtx);
+            std::string endpoint = media ? media->endpoint : std::string();
+            if (endpoint == media_endpoint) return;
+            media_endpoint = endpoint;
+            log_info("Media Service endpoint changed to " +
+                     (endpoint.empty() ? std::string("unknown endpoint") : endpoint) + ".");
+        });
+        watcher.start();
     }
 
     void run() {
@@ -44,10 +62,26 @@ private:
             log_warning("Unknown command: " + command);
         }
     }
+
+    common::ServiceConfig config;
+    std::mutex endpoint_mtx;
+    std::string media_endpoint;
+    // Last: its thread calls into the members above until it is destroyed
+    common::ConfigWatcher watcher;
 };
 
-int main() {
-    HMIClient client;
+int main(int argc, char** argv) {
+    std::string config_dir = IVI_CONFIG_DIR;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--config-dir" && i + 1 < argc) {
+            config_dir = argv[++i];
+        } else {
+            std::cerr << "usage: hmi_client [--config-dir <dir>]" << std::endl;
+            return 1;
+        }
+    }
+    HMIClient client(config_dir);
     client.run();
     return 0;
 }
\ No newline at end of file
@@ -7,7 +7,11 @@
 #include <nlohmann/json.hpp>
 #include "../../common/include/logging.hpp"
 #include "../../common/include/persistence.hpp"
+#include "../../common/include/write_behind.hpp"
+#include "../../common/include/versioned_state.hpp"
 #include "../../common/include/someip_shim.hpp"
+#include "../../common/include/heartbeat.hpp"
+#include "../../common/include/lifecycle.hpp"
 
 using json = nlohmann::json;
 using namespace common;
@@ -19,16 +23,25 @@ int main()
     const int rpc_port = 5001;
     std::atomic_bool running{false};
     std::thread server_thread;
-    std::mutex state_mtx;
 
-    // persistent state
-    json state;
+    // persistent state; handlers publish new versions, readers never wait on them
+    VersionedState<json> state(json::object());
     const std::string persist_file = "media_state.json";
-    load_json(persist_file, state);
-    if (state.empty()) {
-        state["playing"] = false;
-        state["volume"] = 50;
-        state["track"] = "Unknown";
+    // Handlers only mark the state dirty; it is written behind them, once per burst,
+    // and only the changed keys go to the persistency daemon (or the local journal
+    // when no daemon runs)
+    WriteBehind::Options persist_opts;
+    persist_opts.journaled = true;
+    persist_opts.persistency_service = "media";
+    WriteBehind persist(persist_file, [&]() {
+        return *state.read();
+    }, persist_opts);
+    auto load_start = std::chrono::steady_clock::now();
+    state.store(persist.load());
+    log_info("Media state restored in " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+                 std::chrono::steady_clock::now() - load_start).count()) + " us");
+    if (state.read()->empty()) {
+        state.store(json{{"playing", false}, {"volume", 50}, {"track", "Unknown"}});
     }
 
     // register with Service Manager
@@ -37,58 +50,66 @@ int main()
     reg["service"] = "media";
     reg["host"] = "127.0.0.1";
     reg["port"] = rpc_port;
+    reg["service_type"] = "Media";
     json ignored_reply;
     send_message("127.0.0.1", 4000, reg, ignored_reply);
 
+    // heartbeat over the Service Manager's binary datagram channel
+    heartbeat::HeartbeatSender heartbeats("127.0.0.1");
+    heartbeats.add("media");
+    heartbeats.start(std::chrono::milliseconds(100));
+
     // RPC handler
     auto handler = [&](const json &req, const std::string &peer){
         json resp;
         try {
             std::string method = req.value("method", "");
             if (method == "play") {
-                std::lock_guard<std::mutex> lk(state_mtx);
-                state["playing"] = true;
+                state.update([&](json &s) {
+                    s["playing"] = true;
+                    resp["state"] = s;
+                });
                 resp["result"] = "ok";
-                resp["state"] = state;
-                save_json(persist_file, state);
+                persist.markDirty();
                 log_info("Playback started");
             } else if (method == "pause") {
-                std::lock_guard<std::mutex> lk(state_mtx);
-                state["playing"] = false;
+                state.update([&](json &s) {
+                    s["playing"] = false;
+                    resp["state"] = s;
+                });
                 resp["result"] = "ok";
-                resp["state"] = state;
-                save_json(persist_file, state);
+                persist.markDirty();
                 log_info("Playback paused");
             } else if (method == "stop") {
-                std::lock_guard<std::mutex> lk(state_mtx);
-                state["playing"] = false;
-                state["track"] = "Unknown";
+                state.update([&](json &s) {
+                    s["playing"] = false;
+                    s["track"] = "Unknown";
+                    resp["state"] = s;
+                });
                 resp["result"] = "ok";
-                resp["state"] = state;
-                save_json(persist_file, state);
+                persist.markDirty();
                 log_info("Playback stopped");
             } else if (method == "get_state") {
-                std::lock_guard<std::mutex> lk(state_mtx);
-                resp["state"] = state;
+                resp["state"] = *state.read();
             } else if (method == "set_volume") {
-                int vol = req.at("params").value("volume", state.value("volume", 50));
-                {
-                    std::lock_guard<std::mutex> lk(state_mtx);
-                    state["volume"] = vol;
-                    save_json(persist_file, state);
-                }
+                int vol = 50;
+                state.update([&](json &s) {
+                    vol = req.at("params").value("volume", s.value("volume", 50));
+                    s["volume"] = vol;
+                    resp["state"] = s;
+                });
+                persist.markDirty();
                 resp["result"] = "ok";
-                resp["state"] = state;
                 log_info("Volume set to " + std::to_string(vol));
             } else if (method == "set_track") {
-                std::string t = req.at("params").value("track", state.value("track", std::string("Unknown")));
-                {
-                    std::lock_guard<std::mutex> lk(state_mtx);
-                    state["track"] = t;
-                    save_json(persist_file, state);
-                }
+                std::string t;
+                state.update([&](json &s) {
+                    t = req.at("params").value("track", s.value("track", std::string("Unknown")));
+                    s["track"] = t;
+                    resp["state"] = s;
+                });
+                persist.markDirty();
                 resp["result"] = "ok";
-                resp["state"] = state;
                 log_info("Track set to " + t);
             } else {
                 resp["error"] = "unknown_method";
@@ -121,6 +142,7 @@ int main()
         }
     });
     log_info("Media Service RPC listening on port " + std::to_string(rpc_port));
+    lifecycle::notifyReady();
 
     // Event thread: periodically broadcast track metadata to Service Manager
     std::thread ev_thread([&](){
@@ -129,19 +151,19 @@ int main()
         while (running) {
             std::this_thread::sleep_for(std::chrono::seconds(10));
             json ev;
+            counter++;
+            // simulate track change occasionally
+            if ((std::rand() % 4) == 0) {
+                state.update([&](json &s) { s["track"] = std::string("Track #") + std::to_string(counter); });
+                persist.markDirty();
+            }
             {
-                std::lock_guard<std::mutex> lk(state_mtx);
-                counter++;
-                // simulate track change occasionally
-                if ((std::rand() % 4) == 0) {
-                    state["track"] = std::string("Track #") + std::to_string(counter);
-                    save_json(persist_file, state);
-                }
+                auto snap = state.read();
                 ev["type"] = "event";
                 ev["service"] = "media";
                 ev["event"] = "track_update";
-                ev["track"] = state["track"];
-                ev["playing"] = state["playing"];
+                ev["track"] = snap->value("track", std::string("Unknown"));
+                ev["playing"] = snap->value("playing", false);
             }
             json r;
             send_message("127.0.0.1", 4000, ev, r);
@@ -149,15 +171,18 @@ int main()
         }
     });
 
+    // Launched by the Service Manager: no terminal, run until terminated
+    const bool managed = lifecycle::isManaged();
+    if (managed) lifecycle::waitForTermination();
+
     // Simple CLI
     std::string line;
-    while (true) {
+    while (!managed) {
         std::cout << "media> ";
         if (!std::getline(std::cin, line)) break;
         if (line == "exit" || line == "quit") break;
         if (line == "state") {
-            std::lock_guard<std::mutex> lk(state_mtx);
-            std::cout << state.dump(2) << std::endl;
+            std::cout << state.read()->dump(2) << std::endl;
             continue;
         }
         if (line.rfind("play", 0) == 0) {
@@ -194,6 +219,7 @@ int main()
     }
 
     running = false;
+    heartbeats.stop();
     if (server_thread.joinable()) server_thread.join();
     if (ev_thread.joinable()) ev_thread.join();
     log_info("Media Service exiting");
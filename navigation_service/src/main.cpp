@@ -4,6 +4,7 @@
 #include "someip.hpp"
 #include "logging.hpp"
 #include "persistence.hpp"
+#include "lifecycle.hpp"
 
 int main() {
     // Initialize logging
@@ -18,6 +19,7 @@ int main() {
     // Start the navigation service
     std::cout << "Navigation Service running..." << std::endl;
     log_info("Navigation Service is running");
+    common::lifecycle::notifyReady();
 
     // Main service loop
     while (true) {
@@ -0,0 +1,51 @@
+#include <csignal>
+#include <iostream>
+#include <string>
+#include "persistency_server.hpp"
+#include "../../common/include/logging.hpp"
+#include "../../common/include/persistence.hpp"
+#include "../../common/include/persistency_client.hpp"
+
+// Persistency daemon: owns the persisted state of all services and
+// group-commits their updates into one journal (see persistency_server.hpp).
+int main(int argc, char **argv)
+{
+    std::string socket_path = common::per::kPersistencySocket;
+    std::string store_path = "persistency_store.json";
+    PersistencyServer::Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) socket_path = argv[++i];
+        else if (arg == "--store" && i + 1 < argc) store_path = argv[++i];
+        else if (arg == "--commit-window-us" && i + 1 < argc)
+            options.commit_window = std::chrono::microseconds(std::stol(argv[++i]));
+        else {
+            std::cerr << "usage: persistency_daemon [--socket <path>] [--store <file>]"
+                      << " [--commit-window-us <n>]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Only the writer thread commits, once per batch; it must not wait again
+    Persistence::setDurability({common::Durability::GroupCommit, std::chrono::milliseconds(1000),
+                                std::chrono::microseconds(0)});
+
+    // Handle termination on this thread only
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    PersistencyServer server(socket_path, store_path, options);
+    if (!server.start()) return 1;
+    log_info("Persistency daemon listening on " + socket_path + ", store " + store_path);
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    server.stop();
+    auto stats = server.stats();
+    log_info("Persistency daemon exiting: " + std::to_string(stats.updates) + " updates in " +
+             std::to_string(stats.commits) + " commits, " + std::to_string(stats.records) + " records");
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include "persistency_server.hpp"
+#include "../../common/include/logging.hpp"
+#include "../../common/include/rpc_frame.hpp"
+#include <cerrno>
+#include <cstring>
+#include <set>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+namespace rpc = common::rpc;
+
+PersistencyServer::PersistencyServer(std::string socket_path, std::string store_path)
+    : PersistencyServer(std::move(socket_path), std::move(store_path), Options{}) {}
+
+PersistencyServer::PersistencyServer(std::string socket_path, std::string store_path, Options options)
+    : socket_path(std::move(socket_path)), options(options),
+      journal(std::move(store_path), common::StateJournal::Options{options.compact_bytes}) {}
+
+PersistencyServer::~PersistencyServer() {
+    stop();
+}
+
+bool PersistencyServer::start() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (running) return true;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        log_error("Persistency daemon: socket path too long: " + socket_path);
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    ::unlink(socket_path.c_str()); // left behind by a crashed daemon
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0 || ::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, 64) < 0) {
+        log_error("Persistency daemon: cannot listen on " + socket_path + ": " + std::strerror(errno));
+        if (listen_fd >= 0) ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> slk(state_mtx);
+        state = journal.recover();
+    }
+    running = true;
+    stopping = false;
+    writer = std::thread(&PersistencyServer::runWriter, this);
+    acceptor = std::thread(&PersistencyServer::acceptLoop, this);
+    return true;
+}
+
+// Connections are closed first so that their pending updates are committed
+// and answered before the writer is stopped.
+void PersistencyServer::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!running) return;
+        running = false;
+    }
+    ::shutdown(listen_fd, SHUT_RDWR);
+    if (acceptor.joinable()) acceptor.join();
+    ::close(listen_fd);
+    listen_fd = -1;
+    ::unlink(socket_path.c_str());
+
+    std::list<std::unique_ptr<Connection>> conns;
+    {
+        std::lock_guard<std::mutex> lk(conn_mtx);
+        conns.swap(connections);
+    }
+    for (auto& c : conns) ::shutdown(c->fd, SHUT_RDWR);
+    for (auto& c : conns) {
+        if (c->thread.joinable()) c->thread.join();
+        ::close(c->fd);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    if (writer.joinable()) writer.join();
+}
+
+PersistencyServer::Stats PersistencyServer::stats() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return counters;
+}
+
+void PersistencyServer::acceptLoop() {
+    while (true) {
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return; // shut down
+        }
+        reapConnections();
+        std::lock_guard<std::mutex> lk(conn_mtx);
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        Connection* c = conn.get();
+        connections.push_back(std::move(conn));
+        c->thread = std::thread(&PersistencyServer::serve, this, std::ref(*c));
+    }
+}
+
+void PersistencyServer::reapConnections() {
+    std::lock_guard<std::mutex> lk(conn_mtx);
+    for (auto it = connections.begin(); it != connections.end();) {
+        if (!(*it)->finished) {
+            ++it;
+            continue;
+        }
+        (*it)->thread.join();
+        ::close((*it)->fd);
+        it = connections.erase(it);
+    }
+}
+
+void PersistencyServer::serve(Connection& conn) {
+    rpc::FrameHeader h;
+    std::string service, payload;
+    while (rpc::recvFrame(conn.fd, h, service, payload)) {
+        json req = json::parse(payload, nullptr, false);
+        json reply;
+        std::string error;
+        if (req.is_discarded() || !req.is_object()) error = "malformed request";
+        else if (service.empty() || service.find('/') != std::string::npos) error = "invalid service name";
+        else reply = handle(service, req);
+        if (reply.contains("error")) error = reply["error"].get<std::string>();
+
+        std::string out = error.empty() ? reply.dump() : error;
+        if (!rpc::sendFrame(conn.fd, "", out.data(), out.size(), error.empty() ? 0 : rpc::kFlagError)) break;
+    }
+    std::lock_guard<std::mutex> lk(conn_mtx);
+    conn.finished = true;
+}
+
+json PersistencyServer::handle(const std::string& service, const json& req) {
+    std::string op = req.value("op", "");
+    if (op == "load") return json{{"state", load(service)}};
+    if (op != "update") return json{{"error", "unknown op: " + op}};
+
+    Update update;
+    update.service = service;
+    update.set = req.value("set", json::object());
+    if (!update.set.is_object()) return json{{"error", "set must be an object"}};
+    json erase = req.value("erase", json::array());
+    for (const auto& key : erase) {
+        if (key.is_string()) update.erase.push_back(key.get<std::string>());
+    }
+
+    std::unique_lock<std::mutex> lk(mtx);
+    counters.updates++;
+    queue.push_back(&update);
+    queue_cv.notify_one();
+    done_cv.wait(lk, [&]() { return update.done; });
+    if (update.failed) return json{{"error", "update not committed"}};
+    return json{{"seq", update.seq}};
+}
+
+json PersistencyServer::load(const std::string& service) {
+    const std::string prefix = service + "/";
+    json out = json::object();
+    std::lock_guard<std::mutex> lk(state_mtx);
+    const auto& keys = state.get_ref<const json::object_t&>(); // ordered, so a service's keys are adjacent
+    for (auto it = keys.lower_bound(prefix); it != keys.end() && it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+        out[it->first.substr(prefix.size())] = it->second;
+    }
+    return out;
+}
+
+void PersistencyServer::runWriter() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        queue_cv.wait(lk, [this]() { return !queue.empty() || stopping; });
+        if (queue.empty()) return;
+        // Let the other services' updates of this window join the batch
+        if (options.commit_window.count() > 0 && !stopping) {
+            queue_cv.wait_for(lk, options.commit_window, [this]() { return stopping; });
+        }
+        std::vector<Update*> batch;
+        batch.swap(queue);
+        lk.unlock();
+
+        // Later updates of a key in the batch win
+        json set = json::object();
+        std::set<std::string> erased;
+        for (Update* u : batch) {
+            for (auto it = u->set.begin(); it != u->set.end(); ++it) {
+                std::string key = u->service + "/" + it.key();
+                set[key] = it.value();
+                erased.erase(key);
+            }
+            for (const auto& k : u->erase) {
+                std::string key = u->service + "/" + k;
+                set.erase(key);
+                erased.insert(key);
+            }
+        }
+        std::vector<std::string> erase(erased.begin(), erased.end());
+        size_t records = 0;
+        bool ok = journal.apply(set, erase, &records);
+        if (ok) {
+            std::lock_guard<std::mutex> slk(state_mtx);
+            for (auto it = set.begin(); it != set.end(); ++it) state[it.key()] = it.value();
+            for (const auto& key : erase) state.erase(key);
+        } else {
+            log_error("Persistency daemon: batch of " + std::to_string(batch.size()) +
+                      " updates could not be committed");
+        }
+        uint64_t seq = journal.sequence();
+
+        lk.lock();
+        if (ok) {
+            counters.commits++;
+            counters.records += records;
+        } else {
+            counters.failed += batch.size();
+        }
+        for (Update* u : batch) {
+            u->done = true;
+            u->failed = !ok;
+            u->seq = seq;
+        }
+        done_cv.notify_all();
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef PERSISTENCY_SERVER_HPP
+#define PERSISTENCY_SERVER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../common/include/state_journal.hpp"
+
+// Storage owner of the persistency daemon.
+//
+// Services connect over a Unix socket (protocol in persistency_client.hpp)
+// and send the keys they changed. All services share one StateJournal whose
+// keys are "<service>/<key>". A single writer thread collects the updates
+// arriving within `commit_window`, from any number of services, appends them
+// and commits them once; every sender in the batch is answered after that
+// commit. If the batch cannot be committed it is rolled back and every
+// sender gets an error frame instead. With the daemon's durability mode set
+// to GroupCommit, the whole system thus costs one sync per window instead of
+// one per service write.
+//
+// Each connection is served by its own thread; services keep theirs open.
+
+class PersistencyServer {
+public:
+    struct Options {
+        std::chrono::microseconds commit_window{2000};
+        std::size_t compact_bytes = 1024 * 1024;
+    };
+
+    struct Stats {
+        uint64_t updates = 0;  // update requests
+        uint64_t commits = 0;  // batches committed
+        uint64_t records = 0;  // journal records written
+        uint64_t failed = 0;   // updates answered with an error
+    };
+
+    PersistencyServer(std::string socket_path, std::string store_path);
+    PersistencyServer(std::string socket_path, std::string store_path, Options options);
+    ~PersistencyServer();
+
+    bool start();
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Update {
+        std::string service;
+        nlohmann::json set;
+        std::vector<std::string> erase;
+        bool done = false;
+        bool failed = false;
+        uint64_t seq = 0;
+    };
+
+    struct Connection {
+        int fd = -1;
+        bool finished = false;
+        std::thread thread;
+    };
+
+    void acceptLoop();
+    void serve(Connection& conn);
+    nlohmann::json handle(const std::string& service, const nlohmann::json& req);
+    nlohmann::json load(const std::string& service);
+    void runWriter();
+    void reapConnections();
+
+    const std::string socket_path;
+    const Options options;
+    common::StateJournal journal;
+
+    int listen_fd = -1;
+    std::thread acceptor;
+    std::mutex conn_mtx;
+    std::list<std::unique_ptr<Connection>> connections;
+
+    // Committed state, keyed "<service>/<key>"
+    mutable std::mutex state_mtx;
+    nlohmann::json state = nlohmann::json::object();
+
+    // Updates waiting for the writer, guarded by mtx
+    mutable std::mutex mtx;
+    std::condition_variable queue_cv;
+    std::condition_variable done_cv;
+    std::vector<Update*> queue;
+    bool running = false;
+    bool stopping = false;
+    Stats counters;
+    std::thread writer;
+};
+
+#endif // PERSISTENCY_SERVER_HPP
@@ -0,0 +1,124 @@
+#include "dependency_graph.hpp"
+#include <algorithm>
+#include <deque>
+
+bool DependencyGraph::setDependencies(const std::string& name, const std::vector<std::string>& declared,
+                                      std::vector<Change>& changes) {
+    std::vector<std::string> deps = declared;
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+    for (const auto& d : deps) {
+        if (d == name || reaches(d, name)) return false;
+    }
+
+    size_t first = changes.size();
+    Node& n = nodes[name];
+    bool before = effective(n);
+    for (const auto& d : n.deps) {
+        auto it = nodes.find(d);
+        it->second.dependents.erase(name);
+        if (!effective(it->second)) n.blocked--;
+        // Placeholder of a service that never registered and nobody needs any more
+        if (!it->second.alive && it->second.deps.empty() && it->second.dependents.empty()) nodes.erase(it);
+    }
+    for (const auto& d : deps) {
+        Node& dn = nodes[d];
+        dn.dependents.insert(name);
+        if (!effective(dn)) n.blocked++;
+    }
+    n.deps = std::move(deps);
+
+    if (effective(n) != before) {
+        changes.push_back({name, effective(n), n.alive, {}});
+        propagate(name, changes);
+    }
+    describe(changes, first);
+    return true;
+}
+
+void DependencyGraph::setAlive(const std::string& name, bool alive, std::vector<Change>& changes) {
+    Node& n = nodes[name];
+    if (n.alive == alive) return;
+    size_t first = changes.size();
+    bool before = effective(n);
+    n.alive = alive;
+    if (effective(n) != before) {
+        changes.push_back({name, effective(n), n.alive, {}});
+        propagate(name, changes);
+    }
+    describe(changes, first);
+}
+
+void DependencyGraph::remove(const std::string& name, std::vector<Change>& changes) {
+    if (nodes.find(name) == nodes.end()) return;
+    setDependencies(name, {}, changes);
+    setAlive(name, false, changes);
+    auto it = nodes.find(name);
+    if (it->second.dependents.empty()) nodes.erase(it);
+}
+
+bool DependencyGraph::available(const std::string& name) const {
+    auto it = nodes.find(name);
+    return it != nodes.end() && effective(it->second);
+}
+
+std::vector<std::string> DependencyGraph::dependencies(const std::string& name) const {
+    auto it = nodes.find(name);
+    return it == nodes.end() ? std::vector<std::string>{} : it->second.deps;
+}
+
+std::vector<std::string> DependencyGraph::dependents(const std::string& name) const {
+    auto it = nodes.find(name);
+    if (it == nodes.end()) return {};
+    std::vector<std::string> out(it->second.dependents.begin(), it->second.dependents.end());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// Whether `to` is a (transitive) dependency of `from`
+bool DependencyGraph::reaches(const std::string& from, const std::string& to) const {
+    std::unordered_set<std::string> seen{from};
+    std::deque<const std::string*> queue{&from};
+    while (!queue.empty()) {
+        auto it = nodes.find(*queue.front());
+        queue.pop_front();
+        if (it == nodes.end()) continue;
+        for (const auto& d : it->second.deps) {
+            if (d == to) return true;
+            if (seen.insert(d).second) queue.push_back(&d);
+        }
+    }
+    return false;
+}
+
+// `name` flipped availability. All flips in one pass go the same direction,
+// so every dependent is enqueued at most once.
+void DependencyGraph::propagate(const std::string& name, std::vector<Change>& changes) {
+    std::deque<const std::string*> queue{&name};
+    while (!queue.empty()) {
+        const Node& cur = nodes.at(*queue.front());
+        queue.pop_front();
+        bool up = effective(cur);
+        for (const auto& d : cur.dependents) {
+            Node& dn = nodes.at(d);
+            bool before = effective(dn);
+            if (up) dn.blocked--;
+            else dn.blocked++;
+            if (effective(dn) != before) {
+                changes.push_back({d, effective(dn), dn.alive, {}});
+                queue.push_back(&d);
+            }
+        }
+    }
+}
+
+void DependencyGraph::describe(std::vector<Change>& changes, size_t first) const {
+    for (size_t i = first; i < changes.size(); ++i) {
+        const Node& n = nodes.at(changes[i].service);
+        changes[i].alive = n.alive;
+        changes[i].unavailable.clear();
+        for (const auto& d : n.deps) {
+            if (!effective(nodes.at(d))) changes[i].unavailable.push_back(d);
+        }
+    }
+}
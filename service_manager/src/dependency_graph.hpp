@@ -0,0 +1,55 @@
+#ifndef DEPENDENCY_GRAPH_HPP
+#define DEPENDENCY_GRAPH_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Service dependencies declared at registration ("depends_on").
+//
+// A service is available when it is alive itself and all of its dependencies
+// are available. Each node counts its direct dependencies that are not, so a
+// liveness change only walks the dependents whose availability actually
+// flips: one incremental pass over the affected part of the graph instead of
+// re-evaluating every service. Dependencies on services that have not
+// registered yet count as unavailable.
+
+class DependencyGraph {
+public:
+    struct Change {
+        std::string service;
+        bool available;
+        bool alive;                          // the service's own liveness
+        std::vector<std::string> unavailable; // direct dependencies that are not available
+    };
+
+    // Replace the dependencies of `name`. Returns false, leaving the graph
+    // unchanged, if the declaration would create a cycle.
+    bool setDependencies(const std::string& name, const std::vector<std::string>& deps,
+                         std::vector<Change>& changes);
+    void setAlive(const std::string& name, bool alive, std::vector<Change>& changes);
+    // The service left the registry; its dependents see it as unavailable.
+    void remove(const std::string& name, std::vector<Change>& changes);
+
+    bool available(const std::string& name) const;
+    std::vector<std::string> dependencies(const std::string& name) const;
+    std::vector<std::string> dependents(const std::string& name) const;
+
+private:
+    struct Node {
+        std::vector<std::string> deps;
+        std::unordered_set<std::string> dependents;
+        bool alive = false;
+        size_t blocked = 0; // direct dependencies that are not available
+    };
+
+    static bool effective(const Node& n) { return n.alive && n.blocked == 0; }
+    bool reaches(const std::string& from, const std::string& to) const;
+    void propagate(const std::string& name, std::vector<Change>& changes);
+    void describe(std::vector<Change>& changes, size_t first) const;
+
+    std::unordered_map<std::string, Node> nodes;
+};
+
+#endif // DEPENDENCY_GRAPH_HPP
@@ -0,0 +1,349 @@
+#include "event_broker.hpp"
+#include "../../common/include/logging.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+uint64_t nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+EventBroker::EventBroker() {
+    fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    replay_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || replay_fd < 0) {
+        log_error("Event broker: failed to create socket: " + std::string(std::strerror(errno)));
+    }
+}
+
+EventBroker::~EventBroker() {
+    stop();
+    if (fd >= 0) ::close(fd);
+    if (replay_fd >= 0) ::close(replay_fd);
+}
+
+bool EventBroker::enableLog(const std::string& dir, const EventLogOptions& opts) {
+    auto l = std::make_unique<EventLog>(dir, opts);
+    if (!l->open()) return false;
+    std::lock_guard<std::mutex> lk(lvc_mtx);
+    log = std::move(l);
+    return true;
+}
+
+void EventBroker::start() {
+    std::lock_guard<std::mutex> lk(out_mtx);
+    if (sender.joinable()) return;
+    stopping = false;
+    replay_stopping = false;
+    sender = std::thread([this]() { senderLoop(); });
+    replayer = std::thread([this]() { replayLoop(); });
+}
+
+void EventBroker::stop() {
+    {
+        std::lock_guard<std::mutex> lk(out_mtx);
+        stopping = true;
+    }
+    out_cv.notify_one();
+    {
+        std::lock_guard<std::mutex> lk(replay_mtx);
+        replay_stopping = true;
+    }
+    replay_cv.notify_one();
+    if (sender.joinable()) sender.join();
+    if (replayer.joinable()) replayer.join();
+}
+
+bool EventBroker::resolve(const std::string& host, int port, sockaddr_in& addr) {
+    addr = sockaddr_in{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    return port > 0 && port <= 65535 && inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1;
+}
+
+uint32_t EventBroker::subscribe(const std::string& host, int port, const std::vector<std::string>& patterns,
+                                const SubscribeOptions& opts) {
+    sockaddr_in addr;
+    if (!resolve(host, port, addr)) {
+        log_warning("Event broker: invalid subscriber endpoint " + host + ":" + std::to_string(port));
+        return 0;
+    }
+
+    std::string endpoint = host + ":" + std::to_string(port);
+    std::lock_guard<std::mutex> cache_lk(lvc_mtx);
+    std::unique_lock<std::shared_mutex> lk(subs_mtx);
+    uint32_t id;
+    auto it = by_endpoint.find(endpoint);
+    if (it != by_endpoint.end()) {
+        id = it->second;
+    } else {
+        id = next_id++;
+        subs[id] = Subscriber{id, addr, endpoint, {}, 0, {}};
+        by_endpoint[endpoint] = id;
+    }
+
+    Subscriber& sub = subs[id];
+    std::vector<std::string> added;
+    for (const auto& p : patterns) {
+        if (!trie.insert(p, id)) {
+            log_warning("Event broker: invalid topic pattern '" + p + "' from " + endpoint);
+            continue;
+        }
+        if (opts.filter) sub.filters[p] = opts.filter;
+        else sub.filters.erase(p);
+        if (std::find(sub.patterns.begin(), sub.patterns.end(), p) == sub.patterns.end()) {
+            sub.patterns.push_back(p);
+            added.push_back(p);
+        }
+    }
+    if (sub.patterns.empty()) {
+        subs.erase(id);
+        by_endpoint.erase(endpoint);
+        return 0;
+    }
+    lk.unlock();
+
+    if (opts.resume_from && log) {
+        // Everything from the live stream's first offset on is delivered live
+        ReplayRequest req;
+        req.from_offset = *opts.resume_from;
+        req.until_offset = log->nextOffset();
+        req.patterns = added;
+        std::lock_guard<std::mutex> rlk(replay_mtx);
+        replay_jobs.push_back(ReplayJob{addr, std::move(req)});
+        replay_cv.notify_one();
+        log_info("Event broker: " + endpoint + " resuming from offset " + std::to_string(*opts.resume_from));
+        return id;
+    }
+
+    // Replay last values for the newly added patterns. The cache holds one
+    // entry per (topic, key), so a scan is bounded by the number of distinct
+    // topics rather than by event volume.
+    size_t replayed = 0;
+    if (opts.replay_last && !added.empty()) {
+        std::vector<Outgoing> batch;
+        for (const auto& t : last_values) {
+            bool match = std::any_of(added.begin(), added.end(),
+                                     [&](const std::string& p) { return TopicTrie::matches(p, t.first); });
+            if (!match) continue;
+            for (const auto& kv : t.second) batch.push_back(Outgoing{id, addr, kv.second});
+        }
+        replayed = batch.size();
+        enqueue(batch);
+    }
+    log_info("Event broker: " + endpoint + " subscribed to " + std::to_string(added.size()) +
+             " patterns, replayed " + std::to_string(replayed) + " last values");
+    return id;
+}
+
+void EventBroker::unsubscribe(const std::string& host, int port, const std::vector<std::string>& patterns) {
+    std::string endpoint = host + ":" + std::to_string(port);
+    std::unique_lock<std::shared_mutex> lk(subs_mtx);
+    auto it = by_endpoint.find(endpoint);
+    if (it == by_endpoint.end()) return;
+
+    Subscriber& sub = subs[it->second];
+    const std::vector<std::string> remove = patterns.empty() ? sub.patterns : patterns;
+    for (const auto& p : remove) {
+        trie.erase(p, sub.id);
+        sub.filters.erase(p);
+        sub.patterns.erase(std::remove(sub.patterns.begin(), sub.patterns.end(), p), sub.patterns.end());
+    }
+    if (sub.patterns.empty()) {
+        subs.erase(sub.id);
+        by_endpoint.erase(it);
+        log_info("Event broker: " + endpoint + " unsubscribed");
+    }
+}
+
+EventBroker::Buffer EventBroker::serialize(const std::string& topic, const nlohmann::json& event, uint64_t offset) {
+    nlohmann::json envelope;
+    envelope["topic"] = topic;
+    envelope["event"] = event;
+    if (offset != EventLog::kInvalidOffset) envelope["offset"] = offset;
+    return std::make_shared<const std::string>(envelope.dump());
+}
+
+size_t EventBroker::publish(const std::string& topic, const nlohmann::json& event) {
+    std::string key = event.value("key", std::string());
+    std::vector<uint32_t> ids;
+    std::vector<Outgoing> batch;
+
+    std::lock_guard<std::mutex> cache_lk(lvc_mtx);
+    // Appends only happen here, under lvc_mtx, so the offset is known up front
+    Buffer payload = serialize(topic, event, log ? log->nextOffset() : EventLog::kInvalidOffset);
+    if (log) {
+        // Records are "<topic>\n<envelope>" so replays can filter without parsing
+        std::string record;
+        record.reserve(topic.size() + 1 + payload->size());
+        record.append(topic).append(1, '\n').append(*payload);
+        if (log->append(record, nowMs()) == EventLog::kInvalidOffset) {
+            log_warning("Event broker: failed to log event on " + topic);
+        }
+    }
+    auto& per_topic = last_values[topic];
+    auto cached = per_topic.find(key);
+    if (cached != per_topic.end()) {
+        cached->second = payload;
+    } else if (cached_count < MAX_CACHED_VALUES) {
+        per_topic.emplace(key, payload);
+        cached_count++;
+    }
+    if (per_topic.empty()) last_values.erase(topic);
+
+    {
+        std::shared_lock<std::shared_mutex> lk(subs_mtx);
+        trie.match(topic, ids);
+        if (ids.empty()) return 0;
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        const std::string stream = topic + '\n' + key;
+        batch.reserve(ids.size());
+        for (uint32_t id : ids) {
+            auto it = subs.find(id);
+            if (it == subs.end()) continue;
+            if (!it->second.filters.empty() && !passesFilters(it->second, topic, stream, event)) {
+                filtered_count++;
+                continue;
+            }
+            batch.push_back(Outgoing{id, it->second.addr, payload});
+        }
+    }
+    size_t recipients = batch.size();
+    enqueue(batch);
+    return recipients;
+}
+
+bool EventBroker::passesFilters(const Subscriber& sub, const std::string& topic, const std::string& stream,
+                                const nlohmann::json& event) {
+    // Delivered if any matching pattern is unfiltered or accepts the event.
+    // Every matching filter is evaluated so each keeps its own delivered state.
+    bool pass = false;
+    for (const auto& p : sub.patterns) {
+        if (!TopicTrie::matches(p, topic)) continue;
+        auto f = sub.filters.find(p);
+        if (f == sub.filters.end()) return true;
+        if (f->second->accept(stream, event)) pass = true;
+    }
+    return pass;
+}
+
+void EventBroker::enqueue(std::vector<Outgoing>& batch) {
+    {
+        std::lock_guard<std::mutex> lk(out_mtx);
+        for (auto& o : batch) {
+            if (outbox.size() >= MAX_OUTBOX) {
+                outbox.pop_front(); // slow consumers lose the oldest events first
+                dropped_count++;
+            }
+            outbox.push_back(std::move(o));
+        }
+    }
+    out_cv.notify_one();
+}
+
+void EventBroker::senderLoop() {
+    std::deque<Outgoing> pending;
+    std::unique_lock<std::mutex> lk(out_mtx);
+    while (true) {
+        out_cv.wait(lk, [this]() { return !outbox.empty() || stopping; });
+        if (outbox.empty() && stopping) return;
+        pending.swap(outbox);
+        lk.unlock();
+
+        for (const auto& o : pending) {
+            ::sendto(fd, o.payload->data(), o.payload->size(), MSG_DONTWAIT,
+                     reinterpret_cast<const sockaddr*>(&o.addr), sizeof(o.addr));
+        }
+        {
+            std::unique_lock<std::shared_mutex> slk(subs_mtx);
+            for (const auto& o : pending) {
+                auto it = subs.find(o.subscriber);
+                if (it != subs.end()) it->second.delivered++;
+            }
+        }
+        pending.clear();
+        lk.lock();
+    }
+}
+
+std::vector<EventBroker::SubscriberInfo> EventBroker::subscribers() const {
+    std::shared_lock<std::shared_mutex> lk(subs_mtx);
+    std::vector<SubscriberInfo> out;
+    for (const auto& p : subs) {
+        std::vector<std::string> filters;
+        for (const auto& f : p.second.filters) filters.push_back(f.first + ": " + f.second->describe());
+        out.push_back({p.second.id, p.second.endpoint, p.second.patterns, std::move(filters), p.second.delivered});
+    }
+    return out;
+}
+
+bool EventBroker::replay(const std::string& host, int port, ReplayRequest req) {
+    sockaddr_in addr;
+    if (!log || !resolve(host, port, addr)) return false;
+    {
+        std::lock_guard<std::mutex> lk(replay_mtx);
+        replay_jobs.push_back(ReplayJob{addr, std::move(req)});
+    }
+    replay_cv.notify_one();
+    return true;
+}
+
+void EventBroker::replayLoop() {
+    while (true) {
+        ReplayJob job;
+        {
+            std::unique_lock<std::mutex> lk(replay_mtx);
+            replay_cv.wait(lk, [this]() { return !replay_jobs.empty() || replay_stopping; });
+            if (replay_stopping) return;
+            job = std::move(replay_jobs.front());
+            replay_jobs.pop_front();
+        }
+
+        const ReplayRequest& req = job.req;
+        size_t sent = 0;
+        auto visit = [&](const LogRecord& rec) {
+            if (rec.offset >= req.until_offset) return false;
+            size_t nl = rec.payload.find('\n');
+            if (nl == std::string_view::npos) return true;
+            std::string_view topic = rec.payload.substr(0, nl);
+            bool match = req.patterns.empty() ||
+                std::any_of(req.patterns.begin(), req.patterns.end(),
+                            [&](const std::string& p) { return TopicTrie::matches(p, topic); });
+            if (match) {
+                std::string_view envelope = rec.payload.substr(nl + 1);
+                ::sendto(replay_fd, envelope.data(), envelope.size(), 0,
+                         reinterpret_cast<const sockaddr*>(&job.addr), sizeof(job.addr));
+                sent++;
+            }
+            return true;
+        };
+        if (req.from_offset) log->read(*req.from_offset, req.limit, visit);
+        else log->readSince(req.since_ms.value_or(0), req.limit, visit);
+        log_info("Event broker: replayed " + std::to_string(sent) + " logged events");
+    }
+}
+
+size_t EventBroker::cachedValues() const {
+    std::lock_guard<std::mutex> lk(lvc_mtx);
+    return cached_count;
+}
+
+uint64_t EventBroker::filtered() const {
+    std::lock_guard<std::mutex> lk(lvc_mtx);
+    return filtered_count;
+}
+
+uint64_t EventBroker::dropped() const {
+    std::lock_guard<std::mutex> lk(out_mtx);
+    return dropped_count;
+}
@@ -0,0 +1,162 @@
+#ifndef EVENT_BROKER_HPP
+#define EVENT_BROKER_HPP
+
+#include "event_filter.hpp"
+#include "event_log.hpp"
+#include "topic_trie.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Topic-routed event broker of the Service Manager.
+//
+// Events are published under a hierarchical topic ("<service>/<event>") and
+// delivered as UDP datagrams to every subscriber with a matching pattern (see
+// TopicTrie for wildcards). Each event is serialized once; all subscribers'
+// outbox entries share the same immutable buffer.
+//
+// The same buffer is kept as the last value of its (topic, key) pair, where
+// the key is the event's optional "key" field. New subscribers immediately get
+// the cached last values matching their patterns, so a late-joining HMI has
+// current state without polling every service.
+//
+// With enableLog(), every event is also appended to a durable EventLog and
+// carries its log offset. Subscribers can resume from an offset after a crash,
+// and diagnostics can replay a time window; replays are served by a separate
+// thread and socket so they do not delay live fan-out.
+//
+// Subscriptions may carry an EventFilter per pattern; it is evaluated before
+// fan-out, so unchanged or uninteresting events never reach the outbox.
+
+struct SubscribeOptions {
+    bool replay_last = true;                 // deliver cached last values first
+    std::optional<uint64_t> resume_from;     // replay the log from this offset instead
+    std::shared_ptr<EventFilter> filter;     // content filter for the given patterns
+};
+
+class EventBroker {
+public:
+    using Buffer = std::shared_ptr<const std::string>;
+
+    struct SubscriberInfo {
+        uint32_t id;
+        std::string endpoint;
+        std::vector<std::string> patterns;
+        std::vector<std::string> filters; // "<pattern>: <predicates>"
+        uint64_t delivered;
+    };
+
+    EventBroker();
+    ~EventBroker();
+
+    void start();
+    void stop();
+
+    // Subscribe the endpoint host:port to `patterns`. Repeated calls from the
+    // same endpoint extend its pattern set, so one subscriber needs a single
+    // connection for all topics. Subscribing a pattern again replaces its
+    // filter. Returns 0 if no pattern was valid.
+    uint32_t subscribe(const std::string& host, int port, const std::vector<std::string>& patterns,
+                       const SubscribeOptions& opts = {});
+
+    // Remove `patterns` (all when empty) of the endpoint's subscription.
+    void unsubscribe(const std::string& host, int port, const std::vector<std::string>& patterns);
+
+    // Route an event to all matching subscribers. Returns the number of recipients.
+    size_t publish(const std::string& topic, const nlohmann::json& event);
+
+    // Persist all published events to a segmented log in `dir`.
+    bool enableLog(const std::string& dir, const EventLogOptions& opts = {});
+    const EventLog* eventLog() const { return log.get(); }
+
+    struct ReplayRequest {
+        std::optional<uint64_t> from_offset;
+        std::optional<uint64_t> since_ms;   // wall-clock timestamp
+        uint64_t until_offset = EventLog::kInvalidOffset;
+        size_t limit = 100000;
+        std::vector<std::string> patterns;  // empty: all topics
+    };
+
+    // Stream logged events to host:port on the replay thread.
+    bool replay(const std::string& host, int port, ReplayRequest req);
+
+    std::vector<SubscriberInfo> subscribers() const;
+    uint64_t dropped() const;
+    uint64_t filtered() const;
+    size_t cachedValues() const;
+
+private:
+    struct Subscriber {
+        uint32_t id;
+        sockaddr_in addr;
+        std::string endpoint;
+        std::vector<std::string> patterns;
+        uint64_t delivered = 0;
+        std::unordered_map<std::string, std::shared_ptr<EventFilter>> filters; // by pattern
+    };
+
+    struct Outgoing {
+        uint32_t subscriber;
+        sockaddr_in addr;
+        Buffer payload;
+    };
+
+    struct ReplayJob {
+        sockaddr_in addr;
+        ReplayRequest req;
+    };
+
+    static Buffer serialize(const std::string& topic, const nlohmann::json& event, uint64_t offset);
+    static bool resolve(const std::string& host, int port, sockaddr_in& addr);
+    static bool passesFilters(const Subscriber& sub, const std::string& topic, const std::string& stream,
+                              const nlohmann::json& event);
+    void enqueue(std::vector<Outgoing>& batch);
+    void senderLoop();
+    void replayLoop();
+
+    // Lock order: lvc_mtx, then subs_mtx, then out_mtx. Holding lvc_mtx across
+    // cache update, match and enqueue keeps a replayed last value from
+    // overtaking a newer live event. It also serializes filter evaluation,
+    // whose last-delivered state is mutated under a shared subs_mtx.
+    mutable std::mutex lvc_mtx;
+    std::unordered_map<std::string, std::unordered_map<std::string, Buffer>> last_values;
+    size_t cached_count = 0;
+    uint64_t filtered_count = 0;
+    const size_t MAX_CACHED_VALUES = 4096;
+
+    mutable std::shared_mutex subs_mtx; // trie and subscribers
+    TopicTrie trie;
+    std::unordered_map<uint32_t, Subscriber> subs;
+    std::unordered_map<std::string, uint32_t> by_endpoint;
+    uint32_t next_id = 1;
+
+    mutable std::mutex out_mtx;         // outbox
+    std::condition_variable out_cv;
+    std::deque<Outgoing> outbox;
+    uint64_t dropped_count = 0;
+    bool stopping = false;
+    const size_t MAX_OUTBOX = 4096;
+
+    int fd = -1;
+    std::thread sender;
+
+    std::unique_ptr<EventLog> log;      // set before start(); appends under lvc_mtx
+    std::mutex replay_mtx;
+    std::condition_variable replay_cv;
+    std::deque<ReplayJob> replay_jobs;
+    bool replay_stopping = false;
+    int replay_fd = -1;
+    std::thread replayer;
+};
+
+#endif // EVENT_BROKER_HPP
@@ -0,0 +1,146 @@
+#include "event_filter.hpp"
+#include <algorithm>
+#include <cmath>
+
+using json = nlohmann::json;
+
+namespace {
+
+json::json_pointer toPointer(std::string field) {
+    if (field.empty() || field[0] != '/') {
+        for (auto& c : field) {
+            if (c == '.') c = '/';
+        }
+        field.insert(field.begin(), '/');
+    }
+    return json::json_pointer(field);
+}
+
+const json* lookup(const json& event, const json::json_pointer& ptr) {
+    return event.contains(ptr) ? &event.at(ptr) : nullptr;
+}
+
+} // namespace
+
+std::shared_ptr<EventFilter> EventFilter::compile(const json& spec, std::string& error) {
+    const json list = spec.is_array() ? spec : json::array({spec});
+    auto filter = std::make_shared<EventFilter>();
+
+    for (const auto& p : list) {
+        if (!p.is_object() || !p.contains("field") || !p.contains("op") ||
+            !p.at("field").is_string() || !p.at("op").is_string()) {
+            error = "predicate needs 'field' and 'op'";
+            return nullptr;
+        }
+        Predicate pred;
+        try {
+            pred.field = toPointer(p.at("field").get<std::string>());
+        } catch (const std::exception& e) {
+            error = "invalid field: " + std::string(e.what());
+            return nullptr;
+        }
+
+        const std::string op = p.at("op").get<std::string>();
+        if (op == "changed") {
+            pred.op = Op::Changed;
+            pred.stateful = true;
+        } else if (op == "delta_gt") {
+            if (!p.contains("value") || !p.at("value").is_number()) {
+                error = "delta_gt needs a numeric 'value'";
+                return nullptr;
+            }
+            pred.op = Op::DeltaGt;
+            pred.threshold = p.at("value").get<double>();
+            pred.stateful = true;
+        } else if (op == "eq") {
+            if (!p.contains("value")) {
+                error = "eq needs a 'value'";
+                return nullptr;
+            }
+            pred.op = Op::Eq;
+            pred.expected = p.at("value");
+        } else if (op == "range") {
+            if ((p.contains("min") && !p.at("min").is_number()) ||
+                (p.contains("max") && !p.at("max").is_number()) ||
+                (!p.contains("min") && !p.contains("max"))) {
+                error = "range needs numeric 'min' and/or 'max'";
+                return nullptr;
+            }
+            pred.op = Op::Range;
+            if (p.contains("min")) pred.min = p.at("min").get<double>();
+            if (p.contains("max")) pred.max = p.at("max").get<double>();
+        } else {
+            error = "unknown op '" + op + "'";
+            return nullptr;
+        }
+        if (pred.stateful) pred.slot = filter->stateful_count++;
+        filter->predicates.push_back(std::move(pred));
+    }
+    if (filter->predicates.empty()) {
+        error = "empty filter";
+        return nullptr;
+    }
+    // Stateless predicates first: they reject most events without a state lookup
+    std::stable_partition(filter->predicates.begin(), filter->predicates.end(),
+                          [](const Predicate& p) { return !p.stateful; });
+    return filter;
+}
+
+bool EventFilter::accept(const std::string& stream, const json& event) {
+    auto state = last_delivered.find(stream);
+    const std::vector<json>* last = (state != last_delivered.end()) ? &state->second : nullptr;
+
+    for (const auto& pred : predicates) {
+        const json* v = lookup(event, pred.field);
+        if (!v) return false;
+        switch (pred.op) {
+            case Op::Eq:
+                if (*v != pred.expected) return false;
+                break;
+            case Op::Range:
+                if (!v->is_number()) return false;
+                if (v->get<double>() < pred.min || v->get<double>() > pred.max) return false;
+                break;
+            case Op::Changed:
+                if (last && (*last)[pred.slot] == *v) return false;
+                break;
+            case Op::DeltaGt:
+                if (!v->is_number()) return false;
+                if (last && (*last)[pred.slot].is_number() &&
+                    std::fabs(v->get<double>() - (*last)[pred.slot].get<double>()) <= pred.threshold) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    if (stateful_count > 0) {
+        if (state == last_delivered.end()) {
+            // Past the cap new streams are not tracked and always pass
+            if (last_delivered.size() >= MAX_STREAMS) return true;
+            state = last_delivered.emplace(stream, std::vector<json>(stateful_count)).first;
+        }
+        for (const auto& pred : predicates) {
+            if (pred.stateful) state->second[pred.slot] = *lookup(event, pred.field);
+        }
+    }
+    return true;
+}
+
+std::string EventFilter::describe() const {
+    std::string out;
+    for (const auto& pred : predicates) {
+        if (!out.empty()) out += " && ";
+        out += pred.field.to_string();
+        switch (pred.op) {
+            case Op::Changed: out += " changed"; break;
+            case Op::DeltaGt: out += " delta>" + json(pred.threshold).dump(); break;
+            case Op::Eq: out += " == " + pred.expected.dump(); break;
+            case Op::Range:
+                if (std::isfinite(pred.min)) out += " >= " + json(pred.min).dump();
+                if (std::isfinite(pred.max)) out += " <= " + json(pred.max).dump();
+                break;
+        }
+    }
+    return out;
+}
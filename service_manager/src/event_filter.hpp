@@ -0,0 +1,58 @@
+#ifndef EVENT_FILTER_HPP
+#define EVENT_FILTER_HPP
+
+#include <limits>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Content filter attached to an event subscription.
+//
+// A filter is a conjunction of predicates on event fields, compiled once from
+// the subscription request:
+//   [{"field":"current_temperature","op":"delta_gt","value":0.5},
+//    {"field":"mode","op":"eq","value":"cool"}]
+// Ops: "changed", "delta_gt" (absolute numeric change), "eq", "range"
+// ("min"/"max", both inclusive and optional). Fields are names or JSON pointers
+// ("/a/b"); dots are accepted as path separators.
+//
+// "changed" and "delta_gt" compare against the last value *delivered* on the
+// same (topic, key) stream, so slow drift still triggers once it exceeds the
+// threshold. The first event of a stream always passes them.
+
+class EventFilter {
+public:
+    // Compile `spec` (a predicate object or an array of them). Returns nullptr
+    // and sets `error` if the spec is malformed.
+    static std::shared_ptr<EventFilter> compile(const nlohmann::json& spec, std::string& error);
+
+    // Evaluate the filter on an event of `stream`; records the delivered values
+    // when it passes. Not thread-safe: the broker serializes calls.
+    bool accept(const std::string& stream, const nlohmann::json& event);
+
+    std::string describe() const;
+
+private:
+    enum class Op { Changed, DeltaGt, Eq, Range };
+
+    struct Predicate {
+        Op op;
+        nlohmann::json::json_pointer field;
+        double threshold = 0.0;
+        nlohmann::json expected;
+        double min = -std::numeric_limits<double>::infinity();
+        double max = std::numeric_limits<double>::infinity();
+        bool stateful = false;
+        size_t slot = 0;         // index into the stream's last delivered values
+    };
+
+    std::vector<Predicate> predicates;
+    size_t stateful_count = 0;
+    // Last delivered value per stream and stateful predicate
+    std::unordered_map<std::string, std::vector<nlohmann::json>> last_delivered;
+    const size_t MAX_STREAMS = 1024;
+};
+
+#endif // EVENT_FILTER_HPP
@@ -0,0 +1,287 @@
+#include "event_log.hpp"
+#include "../../common/include/checksum.hpp"
+#include "../../common/include/logging.hpp"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kRecordHeader = 24;
+
+uint32_t recordCrc(uint64_t offset, uint64_t ts, const uint8_t* payload, size_t len) {
+    uint32_t crc = common::crc32(&offset, sizeof(offset));
+    crc = common::crc32(&ts, sizeof(ts), crc);
+    return common::crc32(payload, len, crc);
+}
+
+std::string segmentName(uint64_t base) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020" PRIu64 ".log", base);
+    return name;
+}
+
+} // namespace
+
+EventLog::Segment::~Segment() {
+    if (data) ::munmap(data, capacity);
+    if (fd >= 0) ::close(fd);
+}
+
+size_t EventLog::Segment::positionFor(uint64_t offset) const {
+    std::lock_guard<std::mutex> lk(index_mtx);
+    auto it = std::upper_bound(index.begin(), index.end(), offset,
+                               [](uint64_t o, const auto& e) { return o < e.first; });
+    return (it == index.begin()) ? 0 : std::prev(it)->second;
+}
+
+EventLog::EventLog(std::string dir, EventLogOptions opts)
+    : dir(std::move(dir)), opts(opts) {}
+
+EventLog::~EventLog() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (!segments.empty()) ::msync(segments.back()->data, segments.back()->capacity, MS_ASYNC);
+}
+
+EventLog::SegmentPtr EventLog::mapSegment(const std::string& path, uint64_t base, bool create) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0644);
+    if (fd < 0) {
+        log_error("Event log: cannot open segment " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    struct stat st{};
+    ::fstat(fd, &st);
+    size_t capacity = create ? opts.segment_bytes : static_cast<size_t>(st.st_size);
+    if (create && ::ftruncate(fd, static_cast<off_t>(capacity)) < 0) {
+        log_error("Event log: cannot size segment " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+    if (capacity < kRecordHeader) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* map = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        log_error("Event log: cannot map segment " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+
+    auto seg = std::make_shared<Segment>();
+    seg->base = base;
+    seg->path = path;
+    seg->fd = fd;
+    seg->data = static_cast<uint8_t*>(map);
+    seg->capacity = capacity;
+    seg->next_offset = base;
+    return seg;
+}
+
+void EventLog::recover(Segment& seg) {
+    size_t pos = 0;
+    uint64_t next = seg.base;
+    while (pos + kRecordHeader <= seg.capacity) {
+        uint32_t len, crc;
+        uint64_t offset, ts;
+        std::memcpy(&len, seg.data + pos, 4);
+        std::memcpy(&crc, seg.data + pos + 4, 4);
+        std::memcpy(&offset, seg.data + pos + 8, 8);
+        std::memcpy(&ts, seg.data + pos + 16, 8);
+        if (len == 0 || pos + kRecordHeader + len > seg.capacity || offset != next ||
+            recordCrc(offset, ts, seg.data + pos + kRecordHeader, len) != crc) {
+            break;
+        }
+        if (seg.index.empty() || pos - seg.last_indexed_pos >= opts.index_interval) {
+            seg.index.emplace_back(offset, static_cast<uint32_t>(pos));
+            seg.last_indexed_pos = pos;
+        }
+        seg.last_ts = ts;
+        pos += kRecordHeader + len;
+        next = offset + 1;
+    }
+    // Zero a torn tail so the next append starts from a clean terminator
+    if (pos + 4 <= seg.capacity) std::memset(seg.data + pos, 0, 4);
+    seg.end = pos;
+    seg.next_offset = next;
+}
+
+bool EventLog::open() {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) {
+        log_error("Event log: cannot create " + dir + ": " + ec.message());
+        return false;
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> found;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (entry.path().extension() != ".log") continue;
+        try {
+            found.emplace_back(std::stoull(name), entry.path().string());
+        } catch (...) {
+            continue;
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    std::lock_guard<std::mutex> lk(mtx);
+    segments.clear();
+    for (const auto& f : found) {
+        SegmentPtr seg = mapSegment(f.second, f.first, false);
+        if (!seg) continue;
+        recover(*seg);
+        if (!segments.empty() && seg->base != segments.back()->next_offset) {
+            log_warning("Event log: gap before segment " + f.second);
+        }
+        segments.push_back(seg);
+    }
+    if (segments.empty()) {
+        SegmentPtr seg = mapSegment(dir + "/" + segmentName(0), 0, true);
+        if (!seg) return false;
+        segments.push_back(seg);
+    }
+    log_info("Event log " + dir + " opened: " + std::to_string(segments.size()) + " segments, offsets " +
+             std::to_string(segments.front()->base) + ".." + std::to_string(segments.back()->next_offset));
+    return true;
+}
+
+bool EventLog::roll() {
+    SegmentPtr active = segments.back();
+    ::msync(active->data, active->capacity, MS_ASYNC);
+    uint64_t base = active->next_offset;
+    SegmentPtr seg = mapSegment(dir + "/" + segmentName(base), base, true);
+    if (!seg) return false;
+    segments.push_back(seg);
+    applyRetention();
+    return true;
+}
+
+void EventLog::applyRetention() {
+    uint64_t now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    uint64_t max_age_ms = static_cast<uint64_t>(opts.max_age.count()) * 1000;
+
+    // Never drop the active segment. Readers holding a dropped segment keep
+    // its mapping alive until they release it.
+    while (segments.size() > 1) {
+        const SegmentPtr& oldest = segments.front();
+        bool too_many = segments.size() > opts.max_segments;
+        bool too_old = oldest->last_ts + max_age_ms < now_ms;
+        if (!too_many && !too_old) break;
+        ::unlink(oldest->path.c_str());
+        segments.erase(segments.begin());
+    }
+}
+
+uint64_t EventLog::append(std::string_view payload, uint64_t timestamp_ms) {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (segments.empty() || payload.empty() || payload.size() + kRecordHeader + 4 > opts.segment_bytes) {
+        return kInvalidOffset;
+    }
+
+    Segment* seg = segments.back().get();
+    size_t pos = seg->end.load(std::memory_order_relaxed);
+    // Keep 4 bytes for the zero terminator after the record
+    if (pos + kRecordHeader + payload.size() + 4 > seg->capacity) {
+        if (!roll()) return kInvalidOffset;
+        seg = segments.back().get();
+        pos = 0;
+    }
+
+    uint64_t offset = seg->next_offset.load(std::memory_order_relaxed);
+    uint32_t len = static_cast<uint32_t>(payload.size());
+    uint32_t crc = recordCrc(offset, timestamp_ms, reinterpret_cast<const uint8_t*>(payload.data()), len);
+    uint8_t* p = seg->data + pos;
+    std::memcpy(p + 4, &crc, 4);
+    std::memcpy(p + 8, &offset, 8);
+    std::memcpy(p + 16, &timestamp_ms, 8);
+    std::memcpy(p + kRecordHeader, payload.data(), len);
+    std::memcpy(p + kRecordHeader + len, "\0\0\0\0", 4);
+    std::memcpy(p, &len, 4);
+
+    if (seg->index.empty() || pos - seg->last_indexed_pos >= opts.index_interval) {
+        std::lock_guard<std::mutex> ilk(seg->index_mtx);
+        seg->index.emplace_back(offset, static_cast<uint32_t>(pos));
+        seg->last_indexed_pos = pos;
+    }
+    seg->last_ts.store(timestamp_ms, std::memory_order_relaxed);
+    seg->next_offset.store(offset + 1, std::memory_order_release);
+    seg->end.store(pos + kRecordHeader + len, std::memory_order_release);
+    return offset;
+}
+
+uint64_t EventLog::nextOffset() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return segments.empty() ? 0 : segments.back()->next_offset.load();
+}
+
+uint64_t EventLog::firstOffset() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return segments.empty() ? 0 : segments.front()->base;
+}
+
+size_t EventLog::segmentCount() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return segments.size();
+}
+
+std::vector<EventLog::SegmentPtr> EventLog::snapshot() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    return segments;
+}
+
+size_t EventLog::scan(const SegmentPtr& seg, size_t pos, uint64_t from, uint64_t since_ms,
+                      size_t limit, const Visitor& visit, bool& stop) const {
+    size_t end = seg->end.load(std::memory_order_acquire);
+    size_t visited = 0;
+    while (pos + kRecordHeader <= end && visited < limit) {
+        uint32_t len;
+        uint64_t offset, ts;
+        std::memcpy(&len, seg->data + pos, 4);
+        std::memcpy(&offset, seg->data + pos + 8, 8);
+        std::memcpy(&ts, seg->data + pos + 16, 8);
+        if (offset >= from && ts >= since_ms) {
+            LogRecord rec{offset, ts, std::string_view(reinterpret_cast<const char*>(seg->data + pos + kRecordHeader), len)};
+            visited++;
+            if (!visit(rec)) {
+                stop = true;
+                break;
+            }
+        }
+        pos += kRecordHeader + len;
+    }
+    return visited;
+}
+
+size_t EventLog::read(uint64_t from, size_t limit, const Visitor& visit) const {
+    auto segs = snapshot();
+    size_t visited = 0;
+    bool stop = false;
+    for (const auto& seg : segs) {
+        if (stop || visited >= limit) break;
+        if (seg->next_offset.load(std::memory_order_acquire) <= from) continue;
+        visited += scan(seg, seg->positionFor(from), from, 0, limit - visited, visit, stop);
+    }
+    return visited;
+}
+
+size_t EventLog::readSince(uint64_t since_ms, size_t limit, const Visitor& visit) const {
+    auto segs = snapshot();
+    size_t visited = 0;
+    bool stop = false;
+    for (const auto& seg : segs) {
+        if (stop || visited >= limit) break;
+        if (seg->last_ts.load(std::memory_order_relaxed) < since_ms) continue;
+        visited += scan(seg, 0, 0, since_ms, limit - visited, visit, stop);
+    }
+    return visited;
+}
@@ -0,0 +1,99 @@
+#ifndef EVENT_LOG_HPP
+#define EVENT_LOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Durable, append-only event log of the broker.
+//
+// The log is split into fixed-size segment files "<base offset>.log" that are
+// memory-mapped; appends are a memcpy into the active segment. Record layout
+// (host byte order):
+//   length u32 | crc32(offset, timestamp, payload) u32 | offset u64 | timestamp_ms u64 | payload
+// A zero length marks the end of a segment. Each segment keeps a sparse
+// in-memory index (one entry per `index_interval` bytes) for offset lookups.
+//
+// Readers take a snapshot of the segment list and then read the mappings
+// without holding the writer's lock, so replays run concurrently with
+// live appends.
+
+struct EventLogOptions {
+    size_t segment_bytes = 4 * 1024 * 1024;
+    size_t max_segments = 16;                       // retention by size
+    std::chrono::seconds max_age{24 * 3600};        // retention by age
+    size_t index_interval = 4096;
+};
+
+struct LogRecord {
+    uint64_t offset;
+    uint64_t timestamp_ms;
+    std::string_view payload; // valid for the duration of the visitor call
+};
+
+class EventLog {
+public:
+    using Visitor = std::function<bool(const LogRecord&)>; // return false to stop
+
+    static constexpr uint64_t kInvalidOffset = ~0ull;
+
+    explicit EventLog(std::string dir, EventLogOptions opts = {});
+    ~EventLog();
+
+    // Create the directory or recover existing segments, truncating a torn tail.
+    bool open();
+
+    // Append a record; returns its offset or kInvalidOffset on failure.
+    uint64_t append(std::string_view payload, uint64_t timestamp_ms);
+
+    uint64_t nextOffset() const;
+    uint64_t firstOffset() const;
+    size_t segmentCount() const;
+
+    // Visit up to `limit` records starting at offset `from`.
+    size_t read(uint64_t from, size_t limit, const Visitor& visit) const;
+
+    // Visit up to `limit` records with a timestamp at or after `since_ms`.
+    size_t readSince(uint64_t since_ms, size_t limit, const Visitor& visit) const;
+
+private:
+    struct Segment {
+        uint64_t base = 0;
+        std::string path;
+        int fd = -1;
+        uint8_t* data = nullptr;
+        size_t capacity = 0;
+        std::atomic<size_t> end{0};             // bytes of complete records
+        std::atomic<uint64_t> next_offset{0};
+        std::atomic<uint64_t> last_ts{0};
+        mutable std::mutex index_mtx;
+        std::vector<std::pair<uint64_t, uint32_t>> index; // offset -> position
+        size_t last_indexed_pos = 0;
+
+        ~Segment();
+        size_t positionFor(uint64_t offset) const;
+    };
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    SegmentPtr mapSegment(const std::string& path, uint64_t base, bool create);
+    void recover(Segment& seg);
+    bool roll();
+    void applyRetention();
+    std::vector<SegmentPtr> snapshot() const;
+    size_t scan(const SegmentPtr& seg, size_t pos, uint64_t from, uint64_t since_ms,
+                size_t limit, const Visitor& visit, bool& stop) const;
+
+    std::string dir;
+    EventLogOptions opts;
+    mutable std::mutex mtx; // segment list and appends
+    std::vector<SegmentPtr> segments;
+};
+
+#endif // EVENT_LOG_HPP
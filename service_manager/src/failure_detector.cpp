@@ -0,0 +1,59 @@
+#include "failure_detector.hpp"
+#include <algorithm>
+#include <cmath>
+
+PhiAccrualDetector::PhiAccrualDetector(double acceptable_pause, double min_std_dev_ratio, double min_std_dev_ms)
+    : acceptable_pause(acceptable_pause), min_std_dev_ratio(min_std_dev_ratio), min_std_dev_ms(min_std_dev_ms) {}
+
+void PhiAccrualDetector::heartbeat(clock::time_point now) {
+    if (has_last) {
+        double interval = std::chrono::duration<double, std::milli>(now - last).count();
+        if (count == kWindowSize) {
+            double evicted = intervals[head];
+            sum -= evicted;
+            sum_sq -= evicted * evicted;
+        } else {
+            count++;
+        }
+        intervals[head] = interval;
+        head = (head + 1) % kWindowSize;
+        sum += interval;
+        sum_sq += interval * interval;
+    }
+    last = now;
+    has_last = true;
+}
+
+double PhiAccrualDetector::meanIntervalMs() const {
+    return count ? sum / static_cast<double>(count) : 0.0;
+}
+
+double PhiAccrualDetector::stdDevMs() const {
+    if (!count) return min_std_dev_ms;
+    double mean = meanIntervalMs();
+    double variance = std::max(0.0, sum_sq / static_cast<double>(count) - mean * mean);
+    return std::max({min_std_dev_ms, min_std_dev_ratio * mean, std::sqrt(variance)});
+}
+
+double PhiAccrualDetector::phi(clock::time_point now) const {
+    if (!hasHistory()) return 0.0;
+    double elapsed = std::chrono::duration<double, std::milli>(now - last).count();
+    double expected = meanIntervalMs() * (1.0 + acceptable_pause);
+    double y = (elapsed - expected) / stdDevMs();
+
+    // Logistic approximation of the normal CDF, accurate to ~1e-4 and
+    // numerically stable in both tails.
+    double e = std::exp(-y * (1.5976 + 0.070566 * y * y));
+    double phi = (elapsed > expected)
+        ? -std::log10(e / (1.0 + e))
+        : -std::log10(1.0 - 1.0 / (1.0 + e));
+    return std::isfinite(phi) ? phi : 1e3;
+}
+
+void PhiAccrualDetector::reset() {
+    head = 0;
+    count = 0;
+    sum = 0.0;
+    sum_sq = 0.0;
+    has_last = false;
+}
@@ -0,0 +1,60 @@
+#ifndef FAILURE_DETECTOR_HPP
+#define FAILURE_DETECTOR_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// Phi-accrual failure detector (Hayashibara et al.).
+//
+// Keeps a fixed-size window of heartbeat inter-arrival times with running sums,
+// so memory and CPU per service are constant. phi() expresses the suspicion
+// that the service has failed: phi = -log10(P(next heartbeat arrives later than now)).
+// A phi of 3 means roughly a 0.1% chance that the service is merely late.
+//
+// As in Akka's detector, the expected arrival is pushed back by an acceptable
+// pause of a few intervals, and the standard deviation has a floor relative
+// to the interval: with steady beats the measured deviation tends to zero,
+// and a single lost datagram or scheduling stall would otherwise read as a
+// failure.
+class PhiAccrualDetector {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t kWindowSize = 64;
+    static constexpr std::size_t kMinSamples = 4;
+
+    // `acceptable_pause` is in mean heartbeat intervals; the deviation is at
+    // least `min_std_dev_ratio` of the mean interval and `min_std_dev_ms`.
+    explicit PhiAccrualDetector(double acceptable_pause = 2.0, double min_std_dev_ratio = 0.25,
+                                double min_std_dev_ms = 20.0);
+
+    // Record a heartbeat arrival.
+    void heartbeat(clock::time_point now);
+
+    // Suspicion level at `now`; 0 until kMinSamples intervals have been seen.
+    double phi(clock::time_point now) const;
+
+    // True once enough intervals were observed for phi() to be meaningful.
+    bool hasHistory() const { return count >= kMinSamples; }
+
+    double meanIntervalMs() const;
+    double stdDevMs() const;
+
+    // Forget the history, e.g. after the service re-registered or came back from dead.
+    void reset();
+
+private:
+    std::array<double, kWindowSize> intervals{};
+    std::size_t head = 0;
+    std::size_t count = 0;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    double acceptable_pause;
+    double min_std_dev_ratio;
+    double min_std_dev_ms;
+    clock::time_point last{};
+    bool has_last = false;
+};
+
+#endif // FAILURE_DETECTOR_HPP
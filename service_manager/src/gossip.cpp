@@ -0,0 +1,308 @@
+#include "gossip.hpp"
+#include "../../common/include/logging.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+json toJson(const GossipEntry& e) {
+    return json{{"name", e.name}, {"host", e.host}, {"port", e.port}, {"type", e.type}, {"tags", e.tags},
+                {"status", e.status}, {"alive", e.alive}, {"deleted", e.deleted}, {"version", e.version}};
+}
+
+GossipEntry fromJson(const json& j, const std::string& origin) {
+    GossipEntry e;
+    e.origin = origin;
+    e.name = j.at("name").get<std::string>();
+    e.host = j.value("host", "");
+    e.port = j.value("port", 0);
+    e.type = j.value("type", "");
+    e.tags = j.value("tags", std::vector<std::string>{});
+    e.status = j.value("status", "dead");
+    e.alive = j.value("alive", false);
+    e.deleted = j.value("deleted", false);
+    e.version = j.at("version").get<uint64_t>();
+    return e;
+}
+
+bool parseEndpoint(const std::string& endpoint, sockaddr_in& addr) {
+    size_t colon = endpoint.rfind(':');
+    if (colon == std::string::npos) return false;
+    addr = sockaddr_in{};
+    addr.sin_family = AF_INET;
+    try {
+        addr.sin_port = htons(static_cast<uint16_t>(std::stoi(endpoint.substr(colon + 1))));
+    } catch (...) {
+        return false;
+    }
+    return inet_pton(AF_INET, endpoint.substr(0, colon).c_str(), &addr.sin_addr) == 1;
+}
+
+} // namespace
+
+GossipNode::GossipNode(std::string node_id, int port, std::vector<std::string> peer_list, ChangeHandler on_change)
+    : node_id(std::move(node_id)),
+      incarnation(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count())),
+      port(port), on_change(std::move(on_change)) {
+    for (const auto& p : peer_list) {
+        sockaddr_in addr;
+        if (parseEndpoint(p, addr)) peers.push_back(addr);
+        else log_warning("Gossip: ignoring invalid peer " + p);
+    }
+    origins[this->node_id].incarnation = incarnation;
+}
+
+GossipNode::~GossipNode() {
+    stop();
+}
+
+bool GossipNode::start() {
+    fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        log_error("Gossip: cannot bind UDP port " + std::to_string(port) + ": " + std::strerror(errno));
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        return false;
+    }
+    running = true;
+    worker = std::thread([this]() { run(); });
+    log_info("Gossip node " + node_id + " on UDP port " + std::to_string(port) + " with " +
+             std::to_string(peers.size()) + " peers");
+    return true;
+}
+
+void GossipNode::stop() {
+    running = false;
+    if (worker.joinable()) worker.join();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void GossipNode::updateLocal(std::vector<GossipEntry> batch) {
+    if (batch.empty()) return;
+    std::sort(batch.begin(), batch.end(),
+              [](const GossipEntry& a, const GossipEntry& b) { return a.version < b.version; });
+    std::lock_guard<std::mutex> lk(mtx);
+    Origin& self = origins[node_id];
+    for (auto& e : batch) {
+        e.origin = node_id;
+        // Pushes only send versions above pushed_version
+        if (e.version <= pushed_version) pushed_version = e.version - 1;
+        self.version = std::max(self.version, e.version);
+        self.entries[e.name] = std::move(e);
+    }
+    push_pending = true;
+}
+
+std::vector<GossipNode::OriginState> GossipNode::versionVector() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    std::vector<OriginState> out;
+    for (const auto& o : origins) {
+        size_t live = std::count_if(o.second.entries.begin(), o.second.entries.end(),
+                                    [](const auto& e) { return !e.second.deleted; });
+        out.push_back({o.first, o.second.incarnation, o.second.version, live, o.second.reachable});
+    }
+    return out;
+}
+
+json GossipNode::digest(const char* type) const {
+    json vv = json::object();
+    for (const auto& o : origins) vv[o.first] = {o.second.incarnation, o.second.version};
+    return json{{"type", type}, {"from", node_id}, {"vv", vv}};
+}
+
+void GossipNode::send(const json& msg, const sockaddr_in& to) {
+    std::string data = msg.dump();
+    ::sendto(fd, data.data(), data.size(), MSG_DONTWAIT, reinterpret_cast<const sockaddr*>(&to), sizeof(to));
+}
+
+// Caller holds mtx
+void GossipNode::sendDeltas(const std::string& origin, const Origin& o, uint64_t base, const sockaddr_in& to) {
+    std::vector<const GossipEntry*> entries;
+    for (const auto& e : o.entries) {
+        if (e.second.version > base) entries.push_back(&e.second);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const GossipEntry* a, const GossipEntry* b) { return a->version < b->version; });
+
+    // Contiguous chunks: each covers (chunk base, chunk max]
+    json msg;
+    size_t bytes = 0;
+    uint64_t chunk_base = base;
+    auto flush = [&](uint64_t max) {
+        msg["type"] = "delta";
+        msg["from"] = node_id;
+        msg["origin"] = origin;
+        msg["incarnation"] = o.incarnation;
+        msg["base"] = chunk_base;
+        msg["max"] = max;
+        if (!msg.contains("entries")) msg["entries"] = json::array();
+        send(msg, to);
+        msg = json();
+        bytes = 0;
+        chunk_base = max;
+    };
+    for (const GossipEntry* e : entries) {
+        json j = toJson(*e);
+        bytes += j.dump().size();
+        msg["entries"].push_back(std::move(j));
+        if (bytes >= MAX_DATAGRAM) flush(e->version);
+    }
+    if (!msg.is_null() || chunk_base < o.version) flush(o.version);
+}
+
+void GossipNode::applyDelta(const json& msg, std::vector<GossipEntry>& changed) {
+    std::string origin = msg.at("origin").get<std::string>();
+    if (origin == node_id) return; // our own entries echoed back
+    uint64_t inc = msg.at("incarnation").get<uint64_t>();
+    Origin& o = origins[origin];
+    if (inc < o.incarnation) return;
+    if (inc > o.incarnation) {
+        // The origin restarted: its previous state is void
+        for (auto& e : o.entries) {
+            if (e.second.deleted) continue;
+            GossipEntry gone = e.second;
+            gone.deleted = true;
+            changed.push_back(std::move(gone));
+        }
+        o.entries.clear();
+        o.incarnation = inc;
+        o.version = 0;
+    }
+
+    uint64_t max = 0;
+    for (const auto& j : msg.at("entries")) {
+        GossipEntry e = fromJson(j, origin);
+        max = std::max(max, e.version);
+        GossipEntry& cur = o.entries[e.name];
+        if (e.version <= cur.version) continue;
+        cur = e;
+        changed.push_back(o.reachable ? std::move(e) : masked(std::move(e)));
+    }
+    if (msg.at("base").get<uint64_t>() <= o.version) {
+        o.version = std::max({o.version, max, msg.at("max").get<uint64_t>()});
+    }
+}
+
+void GossipNode::answerDigest(const json& msg, const sockaddr_in& to) {
+    const std::string from = msg.at("from").get<std::string>();
+    const json& vv = msg.at("vv");
+    bool behind = false;
+    for (auto it = vv.begin(); it != vv.end(); ++it) {
+        if (it.key() == node_id) continue;
+        auto mine = origins.find(it.key());
+        uint64_t inc = it.value().at(0).get<uint64_t>(), ver = it.value().at(1).get<uint64_t>();
+        if (mine == origins.end() || inc > mine->second.incarnation ||
+            (inc == mine->second.incarnation && ver > mine->second.version)) {
+            behind = true;
+        }
+    }
+    for (const auto& o : origins) {
+        if (o.first == from) continue; // the peer is authoritative for its own services
+        auto theirs = vv.find(o.first);
+        if (theirs == vv.end() || theirs->at(0).get<uint64_t>() < o.second.incarnation) {
+            sendDeltas(o.first, o.second, 0, to);
+        } else if (theirs->at(0).get<uint64_t>() == o.second.incarnation &&
+                   theirs->at(1).get<uint64_t>() < o.second.version) {
+            sendDeltas(o.first, o.second, theirs->at(1).get<uint64_t>(), to);
+        }
+    }
+    if (behind && msg.at("type") == "digest") send(digest("digest_reply"), to);
+}
+
+GossipEntry GossipNode::masked(GossipEntry e) {
+    if (!e.deleted) {
+        e.alive = false;
+        e.status = "dead";
+    }
+    return e;
+}
+
+// Caller holds mtx
+void GossipNode::checkPeers(std::vector<GossipEntry>& changed) {
+    auto now = std::chrono::steady_clock::now();
+    for (auto& o : origins) {
+        if (o.first == node_id || !o.second.direct || !o.second.reachable) continue;
+        if (now - o.second.last_seen < PEER_TIMEOUT) continue;
+        o.second.reachable = false;
+        log_warning("Gossip: node " + o.first + " unreachable, marking its services dead");
+        for (const auto& e : o.second.entries) changed.push_back(masked(e.second));
+    }
+}
+
+void GossipNode::handle(const json& msg, const sockaddr_in& from) {
+    std::vector<GossipEntry> changed;
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        const std::string sender = msg.at("from").get<std::string>();
+        if (sender == node_id) return;
+        Origin& peer = origins[sender];
+        peer.last_seen = std::chrono::steady_clock::now();
+        peer.direct = true;
+        if (!peer.reachable) {
+            peer.reachable = true;
+            log_info("Gossip: node " + sender + " reachable again");
+            for (const auto& e : peer.entries) changed.push_back(e.second);
+        }
+
+        const std::string type = msg.at("type").get<std::string>();
+        if (type == "delta") applyDelta(msg, changed);
+        else if (type == "digest" || type == "digest_reply") answerDigest(msg, from);
+    }
+    if (!changed.empty()) on_change(changed);
+}
+
+void GossipNode::run() {
+    std::vector<char> buf(64 * 1024);
+    pollfd pfd{fd, POLLIN, 0};
+    auto last_round = std::chrono::steady_clock::now();
+
+    while (running) {
+        if (::poll(&pfd, 1, 100) > 0) {
+            sockaddr_in from{};
+            socklen_t len = sizeof(from);
+            ssize_t n = ::recvfrom(fd, buf.data(), buf.size(), 0, reinterpret_cast<sockaddr*>(&from), &len);
+            if (n > 0) {
+                try {
+                    handle(json::parse(buf.begin(), buf.begin() + n), from);
+                } catch (const std::exception& e) {
+                    log_warning("Gossip: malformed message: " + std::string(e.what()));
+                }
+            }
+        }
+
+        std::vector<GossipEntry> changed;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            // Eager push of local changes to every peer
+            if (push_pending) {
+                const Origin& self = origins[node_id];
+                for (const auto& peer : peers) sendDeltas(node_id, self, pushed_version, peer);
+                pushed_version = self.version;
+                push_pending = false;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_round >= GOSSIP_INTERVAL) {
+                last_round = now;
+                json d = digest("digest");
+                for (const auto& peer : peers) send(d, peer);
+                checkPeers(changed);
+            }
+        }
+        if (!changed.empty()) on_change(changed);
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef GOSSIP_HPP
+#define GOSSIP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <netinet/in.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Registry federation between Service Manager nodes.
+//
+// Every node is the origin of the services registered with it and replicates
+// the entries of all other origins. Entries carry the origin's version; each
+// node keeps a version vector (origin -> incarnation, version) of what it has
+// applied. Nodes exchange UDP datagrams with JSON bodies:
+//   - local changes are pushed eagerly to all peers as deltas;
+//   - every round a node sends its version vector ("digest") to each peer,
+//     which answers with the deltas the sender is missing and, if it is itself
+//     behind, its own digest (push-pull anti-entropy). The digests double as
+//     liveness beacons, so a quiet peer is not mistaken for a dead one.
+// A delta covers all entries of an origin in (base, max version], so the
+// version vector only advances over contiguous ranges and lost datagrams are
+// repaired by the next anti-entropy round. A restarted node has a new
+// incarnation, which supersedes everything replicated from its predecessor.
+
+struct GossipEntry {
+    std::string origin;             // node id owning the service
+    std::string name;
+    std::string host;
+    int port = 0;
+    std::string type;
+    std::vector<std::string> tags;
+    std::string status;             // alive | suspect | unverified | dead
+    bool alive = false;
+    bool deleted = false;           // tombstone of a deregistered service
+    uint64_t version = 0;
+};
+
+class GossipNode {
+public:
+    // Receives batches of replicated changes; never called with the node's lock held.
+    using ChangeHandler = std::function<void(const std::vector<GossipEntry>&)>;
+
+    struct OriginState {
+        std::string origin;
+        uint64_t incarnation;
+        uint64_t version;
+        size_t entries;
+        bool reachable;
+    };
+
+    GossipNode(std::string node_id, int port, std::vector<std::string> peers, ChangeHandler on_change);
+    ~GossipNode();
+
+    bool start();
+    void stop();
+
+    // Record changes of local services, applied in ascending version order
+    // under one lock so a concurrent push never skips part of the batch.
+    // Versions must increase across calls; an entry that arrives after a push
+    // of newer versions makes the next push start again below it.
+    void updateLocal(std::vector<GossipEntry> batch);
+    void updateLocal(GossipEntry e) { updateLocal(std::vector<GossipEntry>{std::move(e)}); }
+
+    const std::string& nodeId() const { return node_id; }
+    std::vector<OriginState> versionVector() const;
+
+private:
+    struct Origin {
+        uint64_t incarnation = 0;
+        uint64_t version = 0;       // all entries up to here are applied
+        std::unordered_map<std::string, GossipEntry> entries;
+        std::chrono::steady_clock::time_point last_seen{};
+        bool direct = false;        // heard from this node itself
+        bool reachable = true;
+    };
+
+    void run();
+    void handle(const nlohmann::json& msg, const sockaddr_in& from);
+    void applyDelta(const nlohmann::json& msg, std::vector<GossipEntry>& changed);
+    void answerDigest(const nlohmann::json& msg, const sockaddr_in& to);
+    nlohmann::json digest(const char* type) const;
+    void sendDeltas(const std::string& origin, const Origin& o, uint64_t base, const sockaddr_in& to);
+    void send(const nlohmann::json& msg, const sockaddr_in& to);
+    void checkPeers(std::vector<GossipEntry>& changed);
+    static GossipEntry masked(GossipEntry e);
+
+    std::string node_id;
+    uint64_t incarnation;
+    int port;
+    std::vector<sockaddr_in> peers;
+    ChangeHandler on_change;
+
+    mutable std::mutex mtx;         // origins and push state
+    std::unordered_map<std::string, Origin> origins;
+    bool push_pending = false;      // local changes not pushed yet
+    uint64_t pushed_version = 0;
+
+    int fd = -1;
+    std::atomic_bool running{false};
+    std::thread worker;
+    const std::chrono::milliseconds GOSSIP_INTERVAL{500};
+    const std::chrono::milliseconds PEER_TIMEOUT{3000};
+    const size_t MAX_DATAGRAM = 8 * 1024;
+};
+
+#endif // GOSSIP_HPP
@@ -0,0 +1,393 @@
+#include "launcher.hpp"
+#include "../../common/include/lifecycle.hpp"
+#include "../../common/include/logging.hpp"
+#include "../../common/include/sax_loader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+
+extern char** environ;
+
+namespace {
+
+// Readiness pipe descriptor number inside the child
+constexpr int kChildReadyFd = 3;
+
+const char* stateName(int s) {
+    static const char* names[] = {"pending", "starting", "ready", "failed"};
+    return names[s];
+}
+
+struct LaunchManifest {
+    std::string bin_dir = ".";
+    std::vector<LaunchSpec> services;
+};
+
+} // namespace
+
+// Manifests are streamed into LaunchSpecs; unknown keys are skipped unparsed
+template <>
+struct common::sax::Schema<LaunchSpec> {
+    static void describe(Fields<LaunchSpec>& f) {
+        f.required("name", &LaunchSpec::name);
+        f.required("executable", &LaunchSpec::executable);
+        f.field("args", &LaunchSpec::args);
+        f.field("depends_on", &LaunchSpec::depends_on);
+        f.field("cpu_affinity", &LaunchSpec::cpu_affinity);
+        f.field("env", &LaunchSpec::env);
+        f.field("ready", &LaunchSpec::ready);
+        f.convert<int64_t>("ready_timeout_ms",
+                           [](LaunchSpec& s, int64_t&& ms) { s.ready_timeout = std::chrono::milliseconds(ms); });
+    }
+};
+
+template <>
+struct common::sax::Schema<LaunchManifest> {
+    static void describe(Fields<LaunchManifest>& f) {
+        f.field("bin_dir", &LaunchManifest::bin_dir);
+        f.required("services", &LaunchManifest::services);
+    }
+};
+
+bool Launcher::loadManifest(const std::string& path, std::vector<LaunchSpec>& specs, std::string& bin_dir) {
+    LaunchManifest manifest;
+    std::string error;
+    if (!common::sax::loadFile(path, manifest, &error)) {
+        log_error("Invalid or missing launch manifest " + path + ": " + error);
+        return false;
+    }
+    for (const auto& spec : manifest.services) {
+        if (spec.ready != "pipe" && spec.ready != "spawn") {
+            log_error("Invalid launch manifest " + path + ": " + spec.name + " has unknown ready mode '" +
+                      spec.ready + "' (expected \"pipe\" or \"spawn\")");
+            return false;
+        }
+    }
+    bin_dir = std::move(manifest.bin_dir);
+    specs = std::move(manifest.services);
+    return true;
+}
+
+Launcher::Launcher(std::vector<LaunchSpec> specs, std::string bin_dir)
+    : bin_dir(std::move(bin_dir)) {
+    nodes.reserve(specs.size());
+    for (auto& spec : specs) {
+        Node n;
+        n.spec = std::move(spec);
+        nodes.push_back(std::move(n));
+    }
+}
+
+Launcher::~Launcher() {
+    stop();
+}
+
+bool Launcher::start() {
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!index.emplace(nodes[i].spec.name, i).second) {
+            log_error("Launch manifest: duplicate service " + nodes[i].spec.name);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const auto& dep : nodes[i].spec.depends_on) {
+            auto it = index.find(dep);
+            if (it == index.end()) {
+                log_error("Launch manifest: " + nodes[i].spec.name + " depends on unknown service " + dep);
+                return false;
+            }
+            nodes[it->second].dependents.push_back(i);
+            nodes[i].remaining_deps++;
+        }
+    }
+
+    // Reject cycles up front (Kahn's algorithm on a scratch copy of the in-degrees)
+    std::vector<size_t> indegree(nodes.size());
+    std::vector<size_t> queue;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        indegree[i] = nodes[i].remaining_deps;
+        if (indegree[i] == 0) queue.push_back(i);
+    }
+    size_t visited = 0;
+    while (!queue.empty()) {
+        size_t i = queue.back();
+        queue.pop_back();
+        visited++;
+        for (size_t d : nodes[i].dependents) {
+            if (--indegree[d] == 0) queue.push_back(d);
+        }
+    }
+    if (visited != nodes.size()) {
+        log_error("Launch manifest: dependency cycle detected");
+        return false;
+    }
+
+    running = true;
+    t0 = std::chrono::steady_clock::now();
+    orchestrator = std::thread([this]() { run(); });
+    return true;
+}
+
+double Launcher::sinceStart() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+bool Launcher::spawn(Node& node, std::string& error) {
+    const LaunchSpec& spec = node.spec;
+    const bool wait_ready = spec.ready == "pipe";
+    std::string exe = spec.executable;
+    if (!exe.empty() && exe[0] != '/') exe = bin_dir + "/" + exe;
+
+    int pipefd[2] = {-1, -1};
+    if (wait_ready) {
+        int raw[2];
+        if (::pipe2(raw, O_CLOEXEC) < 0) {
+            error = std::string("pipe: ") + std::strerror(errno);
+            return false;
+        }
+        // Keep both ends clear of the child's target descriptor so dup2 always
+        // produces a fresh, inheritable copy.
+        pipefd[0] = ::fcntl(raw[0], F_DUPFD_CLOEXEC, 10);
+        pipefd[1] = ::fcntl(raw[1], F_DUPFD_CLOEXEC, 10);
+        ::close(raw[0]);
+        ::close(raw[1]);
+    }
+
+    // Environment: inherited, minus variables the manifest overrides
+    std::vector<std::string> env_storage;
+    for (char** e = environ; e && *e; ++e) {
+        std::string var(*e);
+        std::string key = var.substr(0, var.find('='));
+        bool overridden = key == common::lifecycle::kReadyFdEnv ||
+            std::any_of(spec.env.begin(), spec.env.end(),
+                        [&](const auto& kv) { return kv.first == key; });
+        if (!overridden) env_storage.push_back(std::move(var));
+    }
+    for (const auto& kv : spec.env) env_storage.push_back(kv.first + "=" + kv.second);
+    if (wait_ready) {
+        env_storage.push_back(std::string(common::lifecycle::kReadyFdEnv) + "=" + std::to_string(kChildReadyFd));
+    }
+    std::vector<char*> envp;
+    for (auto& e : env_storage) envp.push_back(e.data());
+    envp.push_back(nullptr);
+
+    std::vector<std::string> arg_storage;
+    arg_storage.push_back(exe);
+    arg_storage.insert(arg_storage.end(), spec.args.begin(), spec.args.end());
+    std::vector<char*> argv;
+    for (auto& a : arg_storage) argv.push_back(a.data());
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    // Managed services do not own the terminal; the Service Manager's CLI does
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    if (wait_ready) posix_spawn_file_actions_adddup2(&actions, pipefd[1], kChildReadyFd);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty;
+    sigemptyset(&empty);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    // The child inherits the spawning thread's affinity mask, so pin this
+    // thread for the duration of the spawn instead of racing the child's
+    // own thread creation with sched_setaffinity afterwards.
+    cpu_set_t saved;
+    bool pinned = false;
+    if (!spec.cpu_affinity.empty() &&
+        pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved) == 0) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (int cpu : spec.cpu_affinity) CPU_SET(cpu, &mask);
+        pinned = pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+        if (!pinned) log_warning("Launcher: cannot apply CPU affinity for " + spec.name);
+    }
+
+    pid_t pid = -1;
+    int rc = posix_spawn(&pid, exe.c_str(), &actions, &attr, argv.data(), envp.data());
+
+    if (pinned) pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (pipefd[1] >= 0) ::close(pipefd[1]);
+
+    if (rc != 0) {
+        if (pipefd[0] >= 0) ::close(pipefd[0]);
+        error = exe + ": " + std::strerror(rc);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        node.pid = pid;
+    }
+    node.ready_fd = pipefd[0];
+    node.deadline = std::chrono::steady_clock::now() + spec.ready_timeout;
+    return true;
+}
+
+void Launcher::markReady(size_t idx, std::vector<size_t>& runnable) {
+    Node& node = nodes[idx];
+    if (node.ready_fd >= 0) {
+        ::close(node.ready_fd);
+        node.ready_fd = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        node.state = State::Ready;
+        node.ready_ms = sinceStart();
+    }
+    log_info("Launcher: " + node.spec.name + " ready after " + std::to_string(node.ready_ms) + " ms");
+    for (size_t d : node.dependents) {
+        if (--nodes[d].remaining_deps == 0 && nodes[d].state == State::Pending) runnable.push_back(d);
+    }
+}
+
+void Launcher::markFailed(size_t idx, const std::string& why) {
+    Node& node = nodes[idx];
+    if (node.ready_fd >= 0) {
+        ::close(node.ready_fd);
+        node.ready_fd = -1;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        node.state = State::Failed;
+        node.detail = why;
+    }
+    log_error("Launcher: " + node.spec.name + " failed: " + why);
+    for (size_t d : node.dependents) {
+        if (nodes[d].state == State::Pending) markFailed(d, "dependency " + node.spec.name + " failed");
+    }
+}
+
+void Launcher::run() {
+    std::vector<size_t> runnable;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].remaining_deps == 0) runnable.push_back(i);
+    }
+
+    std::vector<pollfd> pfds;
+    std::vector<size_t> waiting;
+    while (running) {
+        // Spawn everything whose dependencies are satisfied
+        while (!runnable.empty()) {
+            size_t idx = runnable.back();
+            runnable.pop_back();
+            Node& node = nodes[idx];
+            std::string error;
+            if (!spawn(node, error)) {
+                markFailed(idx, error);
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                node.state = State::Starting;
+                node.spawn_ms = sinceStart();
+            }
+            log_info("Launcher: spawned " + node.spec.name + " (pid " + std::to_string(node.pid) + ")");
+            if (node.spec.ready != "pipe") markReady(idx, runnable);
+        }
+
+        pfds.clear();
+        waiting.clear();
+        auto now = std::chrono::steady_clock::now();
+        auto next_deadline = now + std::chrono::milliseconds(100);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i].state != State::Starting) continue;
+            pfds.push_back(pollfd{nodes[i].ready_fd, POLLIN, 0});
+            waiting.push_back(i);
+            next_deadline = std::min(next_deadline, nodes[i].deadline);
+        }
+        if (waiting.empty()) break;
+
+        auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(next_deadline - now).count();
+        int rc = ::poll(pfds.data(), pfds.size(), static_cast<int>(std::max<long long>(0, timeout)));
+        if (rc < 0 && errno != EINTR) {
+            log_error("Launcher: poll failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        now = std::chrono::steady_clock::now();
+        for (size_t k = 0; k < waiting.size(); ++k) {
+            size_t idx = waiting[k];
+            if (pfds[k].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char byte;
+                ssize_t n = ::read(nodes[idx].ready_fd, &byte, 1);
+                if (n == 1) markReady(idx, runnable);
+                else markFailed(idx, "exited before signalling readiness");
+            } else if (now >= nodes[idx].deadline) {
+                markFailed(idx, "not ready within " + std::to_string(nodes[idx].spec.ready_timeout.count()) + " ms");
+            }
+        }
+    }
+
+    size_t ready = 0, failed = 0;
+    log_info("=== Boot timeline ===");
+    for (const auto& ev : timeline()) {
+        if (ev.state == "ready") ready++;
+        if (ev.state == "failed") failed++;
+        log_info(ev.name + ": spawn +" + std::to_string(ev.spawn_ms) + " ms, ready +" +
+                 std::to_string(ev.ready_ms) + " ms [" + ev.state + "]" +
+                 (ev.detail.empty() ? "" : " " + ev.detail));
+    }
+    log_info("Boot finished after " + std::to_string(sinceStart()) + " ms: " + std::to_string(ready) +
+             " ready, " + std::to_string(failed) + " failed");
+}
+
+void Launcher::stop() {
+    running = false;
+    if (orchestrator.joinable()) orchestrator.join();
+
+    for (auto& node : nodes) {
+        if (node.ready_fd >= 0) {
+            ::close(node.ready_fd);
+            node.ready_fd = -1;
+        }
+        if (node.pid > 0) ::kill(node.pid, SIGTERM);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    for (auto& node : nodes) {
+        if (node.pid <= 0) continue;
+        while (::waitpid(node.pid, nullptr, WNOHANG) == 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                log_warning("Launcher: killing unresponsive service " + node.spec.name);
+                ::kill(node.pid, SIGKILL);
+                ::waitpid(node.pid, nullptr, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::lock_guard<std::mutex> lk(mtx);
+        node.pid = -1;
+    }
+}
+
+std::vector<BootEvent> Launcher::timeline() const {
+    std::lock_guard<std::mutex> lk(mtx);
+    std::vector<BootEvent> events;
+    events.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        BootEvent ev;
+        ev.name = node.spec.name;
+        ev.pid = node.pid;
+        ev.state = stateName(static_cast<int>(node.state));
+        ev.spawn_ms = node.spawn_ms;
+        ev.ready_ms = node.ready_ms;
+        ev.detail = node.detail;
+        events.push_back(std::move(ev));
+    }
+    return events;
+}
@@ -0,0 +1,88 @@
+#ifndef LAUNCHER_HPP
+#define LAUNCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Dependency-aware service launcher.
+//
+// Services are spawned with posix_spawn as soon as all their dependencies have
+// signalled readiness, so independent branches of the dependency DAG start in
+// parallel. Each child gets the write end of a readiness pipe in IVI_READY_FD
+// (see common/include/lifecycle.hpp); the launcher polls all read ends at once.
+
+struct LaunchSpec {
+    std::string name;
+    std::string executable;
+    std::vector<std::string> args;
+    std::vector<std::string> depends_on;
+    std::vector<std::pair<std::string, std::string>> env;
+    std::vector<int> cpu_affinity;                 // empty: inherit
+    std::string ready = "pipe";                    // "pipe" | "spawn": ready as soon as spawned
+    std::chrono::milliseconds ready_timeout{5000};
+};
+
+// One row of the boot timeline; times are relative to the start of the launch.
+struct BootEvent {
+    std::string name;
+    pid_t pid = -1;
+    std::string state;      // pending | starting | ready | failed
+    double spawn_ms = -1.0;
+    double ready_ms = -1.0;
+    std::string detail;
+};
+
+class Launcher {
+public:
+    // Parse a launch manifest ({"bin_dir": ..., "services": [...]}); unknown
+    // "ready" modes are rejected.
+    static bool loadManifest(const std::string& path, std::vector<LaunchSpec>& specs, std::string& bin_dir);
+
+    Launcher(std::vector<LaunchSpec> specs, std::string bin_dir);
+    ~Launcher();
+
+    // Validate the dependency graph and start orchestrating on a background thread.
+    bool start();
+
+    // Terminate all spawned services and reap them.
+    void stop();
+
+    std::vector<BootEvent> timeline() const;
+
+private:
+    enum class State { Pending, Starting, Ready, Failed };
+
+    struct Node {
+        LaunchSpec spec;
+        std::vector<size_t> dependents;
+        size_t remaining_deps = 0;
+        State state = State::Pending;
+        pid_t pid = -1;
+        int ready_fd = -1;
+        std::chrono::steady_clock::time_point deadline;
+        double spawn_ms = -1.0;
+        double ready_ms = -1.0;
+        std::string detail;
+    };
+
+    void run();
+    bool spawn(Node& node, std::string& error);
+    void markReady(size_t idx, std::vector<size_t>& runnable);
+    void markFailed(size_t idx, const std::string& why);
+    double sinceStart() const;
+
+    std::vector<Node> nodes;
+    std::string bin_dir;
+    std::chrono::steady_clock::time_point t0;
+    mutable std::mutex mtx; // guards nodes' state for timeline()
+    std::atomic_bool running{false};
+    std::thread orchestrator;
+};
+
+#endif // LAUNCHER_HPP
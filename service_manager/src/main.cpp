@@ -1,13 +1,37 @@
 #include <iostream>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <memory>
+#include <optional>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
 #include <nlohmann/json.hpp>
 #include "../../common/include/logging.hpp"
 #include "../../common/include/persistence.hpp"
 #include "../../common/include/someip_shim.hpp"
+#include "../../common/include/heartbeat.hpp"
+#include "../../common/include/rpc_frame.hpp"
+#include "failure_detector.hpp"
+#include "registry_snapshot.hpp"
+#include "launcher.hpp"
+#include "registry_index.hpp"
+#include "registry_view.hpp"
+#include "event_broker.hpp"
+#include "rpc_proxy.hpp"
+#include "query_server.hpp"
+#include "gossip.hpp"
+#include "dependency_graph.hpp"
 
 using json = nlohmann::json;
 using namespace common;
@@ -17,31 +41,144 @@ struct ServiceInfo {
     std::string name;
     std::string host;
     int port;
+    std::string type;           // e.g. Media, Navigation, Climate
+    std::vector<std::string> tags;
     std::chrono::system_clock::time_point last_heartbeat;
     bool is_alive;
+    bool is_suspect = false;    // alive, but phi crossed PHI_SUSPECT
+    bool is_verified = true;    // false for entries restored from a snapshot until they heartbeat
+    uint32_t instance_id = 0;   // key of the binary heartbeat channel
+    uint32_t last_sequence = 0;
+    uint16_t load = 0;
+    uint64_t version = 0;       // registry version of the last visible change
+    std::string origin;         // federation node owning a replicated entry; empty if local
+    PhiAccrualDetector detector;
 };
 
+static const char* statusOf(const ServiceInfo &s) {
+    if (!s.is_alive) return "dead";
+    if (!s.is_verified) return "unverified";
+    return s.is_suspect ? "suspect" : "alive";
+}
+
+static IndexedAttributes indexAttributes(const ServiceInfo &s) {
+    return IndexedAttributes{s.type, s.host, s.port, s.tags};
+}
+
 class ServiceManager {
 private:
     std::unordered_map<std::string, ServiceInfo> services;
+    // instance_id -> entry in `services`; node pointers stay valid across rehash
+    std::unordered_map<uint32_t, ServiceInfo*> instances;
+    RegistryIndex index; // secondary indexes over `services`, guarded by services_mtx
+    // Declared dependencies and the availability changes not yet announced on
+    // registry/availability/<service>, guarded by services_mtx
+    DependencyGraph dependencies;
+    std::vector<DependencyGraph::Change> availability_changes;
     std::mutex services_mtx;
+    // Availability changes queued by publishView() and published to the broker
+    // once services_mtx is released; availability_mtx keeps them in order
+    std::mutex outbox_mtx;
+    std::vector<DependencyGraph::Change> availability_outbox; // guarded by outbox_mtx
+    std::mutex availability_mtx;
     std::atomic_bool running{false};
-    std::thread registration_server_thread;
-    std::thread query_server_thread;
+    // Newline-delimited JSON on REGISTRATION_PORT; one worker keeps each
+    // client's register/deregister/event requests in arrival order
+    std::unique_ptr<QueryServer> registration_server;
+    // Registration pipeline: register/deregister requests are queued and
+    // applied in batches under a single services_mtx acquisition
+    std::mutex pipeline_mtx;
+    std::condition_variable pipeline_cv;
+    std::vector<std::pair<json, std::string>> pending_registrations; // request, peer
+    std::thread registration_pipeline_thread;
+    uint64_t registration_batches = 0;  // guarded by services_mtx
+    uint64_t registrations_applied = 0; // guarded by services_mtx
+    // The registry dump is logged as one line, at most once per interval
+    bool registry_dump_due = false;     // guarded by services_mtx
+    std::chrono::steady_clock::time_point last_registry_dump{};
+    const std::chrono::seconds REGISTRY_LOG_INTERVAL{2};
+    std::unique_ptr<QueryServer> query_server;
+    std::shared_ptr<const RegistryView> registry_view = std::make_shared<RegistryView>();
+    bool view_dirty = false; // guarded by services_mtx
+    RegistryChangeLog change_log; // versions and removals for changes_since, guarded by services_mtx
+    // (version, name) in ascending order, appended by touch(). Versions only
+    // grow, so the order needs no sort; superseded pairs are dropped on publish.
+    std::vector<std::pair<uint64_t, std::string>> version_order; // guarded by services_mtx
     std::thread heartbeat_monitor_thread;
-    const int REGISTRATION_PORT = 4000;
-    const int QUERY_PORT = 4001;
+    std::thread heartbeat_channel_thread;
+    int heartbeat_fd = -1;
+    std::array<uint8_t, heartbeat::kMaxFrameSize> heartbeat_frame{};
+    uint64_t heartbeat_frames = 0;   // guarded by services_mtx
+    uint64_t heartbeat_rejected = 0; // malformed frames and unknown instances
+    // Shifted by --port-offset so several managers can run on one machine
+    int REGISTRATION_PORT = 4000;
+    int QUERY_PORT = 4001;
+    int HEARTBEAT_PORT = heartbeat::kDefaultPort;
+    int PROXY_PORT = rpc::kDefaultProxyPort;
+    // Registry snapshot and event log live under data_dir (--data-dir)
+    const std::string data_dir;
+    RegistrySnapshot snapshot;
+    std::unique_ptr<Launcher> launcher;
+    EventBroker broker;
+    std::unique_ptr<RpcProxy> proxy;
+    // Federation: local changes not yet handed to the gossip node, guarded by services_mtx
+    std::unique_ptr<GossipNode> gossip;
+    std::unordered_set<std::string> local_changes;
+    // Fallback for services without enough heartbeat history for the phi detector
     const int HEARTBEAT_TIMEOUT_SEC = 30;
+    const double PHI_SUSPECT = 3.0;
+    const double PHI_DEAD = 8.0;
+    const std::chrono::milliseconds HEARTBEAT_CHECK_INTERVAL{100};
+
+    size_t query_threads = 0; // 0: one per core
 
 public:
-    ServiceManager() = default;
+    explicit ServiceManager(const std::string &data_dir)
+        : data_dir(data_dir), snapshot(data_dir + "/service_registry.snap") {}
     ~ServiceManager() = default;
 
+    void setQueryThreads(size_t n) { query_threads = n; }
+
+    void setPortOffset(int offset) {
+        REGISTRATION_PORT += offset;
+        QUERY_PORT += offset;
+        HEARTBEAT_PORT += offset;
+        PROXY_PORT += offset;
+    }
+
+    // Join a federation of Service Managers; call before initialize()
+    void setFederation(const std::string &node_id, int gossip_port, const std::vector<std::string> &peers) {
+        gossip = std::make_unique<GossipNode>(node_id, gossip_port, peers,
+                                              [this](const std::vector<GossipEntry> &changes) {
+                                                  applyRemoteChanges(changes);
+                                              });
+    }
+
     void initialize() {
         log_info("Service Manager initializing");
         running = true;
+
+        // Warm restart: discovery is served from the last snapshot right away
+        restoreSnapshot();
+        snapshot.start();
+        if (!broker.enableLog(data_dir + "/event_log")) {
+            log_warning("Event log unavailable; events will not be replayable");
+        }
+        broker.start();
+        proxy = std::make_unique<RpcProxy>(PROXY_PORT,
+                                           [this](const std::string &name, std::string &host, int &port) {
+                                               return resolveService(name, host, port);
+                                           });
+        if (!proxy->start()) {
+            log_warning("RPC proxy unavailable; clients must call services directly");
+        }
+        if (gossip && !gossip->start()) {
+            log_warning("Federation unavailable; serving local services only");
+            gossip.reset();
+        }
         
-        // Start registration server
+        // Start registration pipeline and server
+        registration_pipeline_thread = std::thread([this]() { runRegistrationPipeline(); });
         if (!startRegistrationServer()) {
             log_error("Failed to start registration server");
             return;
@@ -53,6 +190,11 @@ public:
             return;
         }
         
+        // Start binary heartbeat channel; JSON heartbeats keep working without it
+        if (!startHeartbeatChannel()) {
+            log_warning("Binary heartbeat channel unavailable on port " + std::to_string(HEARTBEAT_PORT));
+        }
+
         // Start heartbeat monitor
         startHeartbeatMonitor();
         
@@ -62,171 +204,666 @@ public:
     bool startRegistrationServer() {
         auto handler = [this](const json &req, const std::string &peer) {
             this->handleRegistration(req, peer);
+            return json{{"status", "ok"}};
         };
-        
-        // Start registration server in a background thread
-        registration_server_thread = std::thread([this, handler]() {
-            log_info("Registration server listening on port " + std::to_string(REGISTRATION_PORT));
-            // Simplified server loop - in production, use proper socket programming
-            while (running) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
-        });
-        
+
+        registration_server = std::make_unique<QueryServer>(REGISTRATION_PORT, 1, handler);
+        if (!registration_server->start()) {
+            registration_server.reset();
+            return false;
+        }
         log_info("Registration server started on port " + std::to_string(REGISTRATION_PORT));
         return true;
     }
 
     bool startQueryServer() {
         auto handler = [this](const json &req, const std::string &peer) {
-            this->handleQuery(req, peer);
+            return this->handleQuery(req, peer);
         };
-        
-        // Start query server in a background thread
-        query_server_thread = std::thread([this, handler]() {
-            log_info("Query server listening on port " + std::to_string(QUERY_PORT));
-            // Simplified server loop - in production, use proper socket programming
+
+        // SO_REUSEPORT workers, each with its own epoll loop
+        query_server = std::make_unique<QueryServer>(QUERY_PORT, query_threads, handler);
+        if (!query_server->start()) {
+            query_server.reset();
+            return false;
+        }
+        log_info("Query server started on port " + std::to_string(QUERY_PORT));
+        return true;
+    }
+
+    bool startHeartbeatChannel() {
+        heartbeat_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (heartbeat_fd < 0) {
+            log_error("Heartbeat channel socket failed: " + std::string(std::strerror(errno)));
+            return false;
+        }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(HEARTBEAT_PORT));
+        if (::bind(heartbeat_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            log_error("Heartbeat channel bind failed: " + std::string(std::strerror(errno)));
+            ::close(heartbeat_fd);
+            heartbeat_fd = -1;
+            return false;
+        }
+
+        heartbeat_channel_thread = std::thread([this]() {
+            pollfd pfd{heartbeat_fd, POLLIN, 0};
             while (running) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                if (::poll(&pfd, 1, 100) <= 0) continue;
+                ssize_t n = ::recv(heartbeat_fd, heartbeat_frame.data(), heartbeat_frame.size(), 0);
+                if (n > 0) handleHeartbeatFrame(heartbeat_frame.data(), static_cast<size_t>(n));
             }
         });
-        
-        log_info("Query server started on port " + std::to_string(QUERY_PORT));
+
+        log_info("Heartbeat channel listening on UDP port " + std::to_string(HEARTBEAT_PORT));
+        return true;
+    }
+
+    // Hot path: one registry lock per datagram, one integer-keyed lookup per entry,
+    // no allocation and no logging.
+    void handleHeartbeatFrame(const uint8_t* frame, size_t len) {
+        auto now = std::chrono::system_clock::now();
+        auto mono_now = PhiAccrualDetector::clock::now();
+        {
+            std::lock_guard<std::mutex> lk(services_mtx);
+            heartbeat_frames++;
+            size_t count = heartbeat::decode(frame, len, [&](const heartbeat::Entry& e) {
+                auto it = instances.find(e.instance_id);
+                if (it == instances.end()) {
+                    heartbeat_rejected++;
+                    return;
+                }
+                ServiceInfo& s = *it->second;
+                // Drop duplicated or reordered datagrams
+                if (s.last_sequence != 0 && static_cast<int32_t>(e.sequence - s.last_sequence) <= 0) return;
+                s.last_sequence = e.sequence;
+                s.load = e.load;
+                recordHeartbeat(s, now, mono_now);
+            });
+            if (count == 0) heartbeat_rejected++;
+            publishView();
+        }
+        publishAvailability();
+    }
+
+    // Caller holds services_mtx
+    void recordHeartbeat(ServiceInfo &s, std::chrono::system_clock::time_point now,
+                         PhiAccrualDetector::clock::time_point mono_now) {
+        if (!s.is_alive) {
+            // The outage is not a sample of the normal inter-arrival time
+            s.detector.reset();
+            dependencies.setAlive(s.name, true, availability_changes);
+            log_info("Service back alive: " + s.name);
+        }
+        if (!s.is_alive || s.is_suspect || !s.is_verified) touch(s);
+        s.detector.heartbeat(mono_now);
+        s.last_heartbeat = now;
+        s.is_alive = true;
+        s.is_suspect = false;
+        s.is_verified = true;
+    }
+
+    // Endpoint lookup for the RPC proxy; only alive services are reachable
+    bool resolveService(const std::string &name, std::string &host, int &port) {
+        std::lock_guard<std::mutex> lk(services_mtx);
+        auto it = services.find(name);
+        if (it == services.end() || !it->second.is_alive) return false;
+        host = it->second.host;
+        port = it->second.port;
+        return true;
+    }
+
+    // Repopulate the registry from the last snapshot. Entries are served as
+    // "unverified" until their next heartbeat or re-registration, and fall
+    // back to HEARTBEAT_TIMEOUT_SEC if the service never comes back.
+    void restoreSnapshot() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SnapshotEntry> entries;
+        if (!snapshot.load(entries)) return;
+
+        {
+            std::lock_guard<std::mutex> lk(services_mtx);
+            auto now = std::chrono::system_clock::now();
+            for (auto &e : entries) {
+                ServiceInfo info;
+                info.name = e.name;
+                info.host = e.host;
+                info.port = e.port;
+                info.type = e.type;
+                info.tags = e.tags;
+                info.instance_id = e.instance_id;
+                info.last_heartbeat = now;
+                info.is_alive = true;
+                info.is_verified = false;
+
+                ServiceInfo &slot = services[info.name];
+                slot = info;
+                instances[info.instance_id] = &slot;
+                index.insert(info.name, indexAttributes(info));
+                dependencies.setAlive(info.name, true, availability_changes);
+                touch(slot);
+            }
+            publishView();
+        }
+        publishAvailability();
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        log_info("Restored " + std::to_string(entries.size()) + " services from registry snapshot in " +
+                 std::to_string(us) + " us");
+    }
+
+    // Caller holds services_mtx. Records a change of `s` visible to queries.
+    void touch(ServiceInfo &s) {
+        s.version = change_log.next();
+        version_order.emplace_back(s.version, s.name);
+        view_dirty = true;
+        if (s.origin.empty()) local_changes.insert(s.name);
+    }
+
+    // Caller holds services_mtx
+    void addTombstone(const std::string &name) {
+        change_log.remove(name);
+        view_dirty = true;
+    }
+
+    // Caller holds services_mtx. Rebuilds the query view if anything a query
+    // can observe has changed since the last publish, hands local changes to
+    // the federation and queues availability changes; the caller runs
+    // publishAvailability() once it has released services_mtx.
+    void publishView() {
+        queueAvailability();
+        if (!view_dirty) return;
+        view_dirty = false;
+        if (gossip && !local_changes.empty()) {
+            std::vector<GossipEntry> batch;
+            for (const auto &name : local_changes) {
+                GossipEntry e;
+                e.name = name;
+                auto it = services.find(name);
+                if (it != services.end() && it->second.origin.empty()) {
+                    const ServiceInfo &s = it->second;
+                    e = GossipEntry{"", s.name, s.host, s.port, s.type, s.tags, statusOf(s), s.is_alive,
+                                    false, s.version};
+                } else {
+                    e.deleted = true;
+                    e.version = change_log.version();
+                }
+                batch.push_back(std::move(e));
+            }
+            gossip->updateLocal(std::move(batch));
+        }
+        local_changes.clear();
+        auto view = std::make_shared<RegistryView>();
+        view->services.reserve(services.size());
+        for (const auto &p : services) {
+            const ServiceInfo &s = p.second;
+            view->services.emplace(p.first, RegistryView::Entry{s.name, s.host, s.port, s.type, s.tags,
+                                                                statusOf(s), s.is_alive,
+                                                                dependencies.available(s.name), s.version});
+            if (s.is_alive) view->alive++;
+        }
+        version_order.erase(std::remove_if(version_order.begin(), version_order.end(),
+                                           [this](const std::pair<uint64_t, std::string> &v) {
+                                               auto it = services.find(v.second);
+                                               return it == services.end() || it->second.version != v.first;
+                                           }),
+                            version_order.end());
+        view->by_version = version_order;
+        view->index = index;
+        change_log.stamp(*view);
+        std::atomic_store(&registry_view, std::shared_ptr<const RegistryView>(std::move(view)));
+    }
+
+    // Caller holds services_mtx
+    void queueAvailability() {
+        if (availability_changes.empty()) return;
+        std::lock_guard<std::mutex> lk(outbox_mtx);
+        for (auto &c : availability_changes) availability_outbox.push_back(std::move(c));
+        availability_changes.clear();
+    }
+
+    // Caller must not hold services_mtx: publishing appends to the event log,
+    // which may roll a segment. Announces availability flips computed by the
+    // dependency graph, e.g. registry/availability/hmi {"available":false,
+    // "unavailable_dependencies":["media"]}, so dependents fail over instead of
+    // waiting for RPC timeouts.
+    void publishAvailability() {
+        {
+            std::lock_guard<std::mutex> lk(outbox_mtx);
+            if (availability_outbox.empty()) return;
+        }
+        std::lock_guard<std::mutex> order(availability_mtx);
+        std::vector<DependencyGraph::Change> changes;
+        {
+            std::lock_guard<std::mutex> lk(outbox_mtx);
+            changes.swap(availability_outbox);
+        }
+        for (const auto &c : changes) {
+            json event{{"service", c.service}, {"available", c.available}, {"alive", c.alive},
+                       {"unavailable_dependencies", c.unavailable}};
+            broker.publish("registry/availability/" + c.service, event);
+            if (!c.available && c.alive) {
+                log_warning("Service unavailable through its dependencies: " + c.service);
+            }
+        }
+    }
+
+    // Apply entries replicated from other nodes. A local registration of the
+    // same name takes precedence over a remote one.
+    void applyRemoteChanges(const std::vector<GossipEntry> &changes) {
+        {
+            std::lock_guard<std::mutex> lk(services_mtx);
+            for (const auto &e : changes) {
+                auto it = services.find(e.name);
+                if (it != services.end() && it->second.origin.empty()) continue;
+                if (e.deleted) {
+                    if (it == services.end() || it->second.origin != e.origin) continue;
+                    dependencies.remove(e.name, availability_changes);
+                    index.erase(e.name);
+                    services.erase(it);
+                    addTombstone(e.name);
+                    continue;
+                }
+                ServiceInfo &s = services[e.name];
+                s.name = e.name;
+                s.host = e.host;
+                s.port = e.port;
+                s.type = e.type;
+                s.tags = e.tags;
+                s.origin = e.origin;
+                s.is_alive = e.alive;
+                s.is_suspect = e.status == "suspect";
+                s.is_verified = e.status != "unverified";
+                dependencies.setAlive(e.name, e.alive, availability_changes);
+                index.insert(e.name, indexAttributes(s));
+                touch(s);
+            }
+            publishView();
+        }
+        publishAvailability();
+    }
+
+    // Caller holds services_mtx
+    void publishSnapshot() {
+        std::vector<SnapshotEntry> entries;
+        entries.reserve(services.size());
+        for (auto &p : services) {
+            if (!p.second.origin.empty()) continue; // replicated entries come back via gossip
+            entries.push_back({p.second.name, p.second.host, p.second.port, p.second.instance_id,
+                               p.second.type, p.second.tags});
+        }
+        snapshot.publish(std::move(entries));
+    }
+
+    // Start the services declared in a launch manifest along their dependency DAG
+    bool launchServices(const std::string &manifest, const std::string &bin_dir_override) {
+        std::vector<LaunchSpec> specs;
+        std::string bin_dir;
+        if (!Launcher::loadManifest(manifest, specs, bin_dir)) return false;
+        if (!bin_dir_override.empty()) bin_dir = bin_dir_override;
+
+        launcher = std::make_unique<Launcher>(std::move(specs), bin_dir);
+        if (!launcher->start()) {
+            launcher.reset();
+            return false;
+        }
+        log_info("Launching services from " + manifest);
         return true;
     }
 
     void startHeartbeatMonitor() {
         heartbeat_monitor_thread = std::thread([this]() {
             while (running) {
-                std::this_thread::sleep_for(std::chrono::seconds(10));
+                std::this_thread::sleep_for(HEARTBEAT_CHECK_INTERVAL);
                 this->checkHeartbeats();
+                this->logRegistryDump();
             }
         });
     }
 
+    // Drains the registration queue. Everything queued while a batch is being
+    // applied forms the next batch, so a boot storm of N registrations costs a
+    // few lock acquisitions, snapshots and view rebuilds instead of N.
+    void runRegistrationPipeline() {
+        std::vector<std::pair<json, std::string>> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lk(pipeline_mtx);
+                pipeline_cv.wait(lk, [this]() { return !pending_registrations.empty() || !running; });
+                if (pending_registrations.empty()) return;
+                batch.swap(pending_registrations);
+            }
+            applyRegistrations(batch);
+            batch.clear();
+        }
+    }
+
+    void applyRegistrations(const std::vector<std::pair<json, std::string>> &batch) {
+        std::vector<std::string> registered, deregistered;
+        {
+            std::lock_guard<std::mutex> lk(services_mtx);
+            for (const auto &item : batch) {
+                const json &req = item.first;
+                const std::string &peer = item.second;
+                std::string type = req.value("type", "");
+                if (type == "register_batch") {
+                    auto entries = req.find("services");
+                    if (entries == req.end() || !entries->is_array()) {
+                        log_error("Error handling registration: register_batch without services (peer: " +
+                                  peer + ")");
+                        continue;
+                    }
+                    for (const auto &entry : *entries) registerService(entry, peer, registered);
+                } else if (type == "register") {
+                    registerService(req, peer, registered);
+                } else {
+                    deregisterService(req, peer, deregistered);
+                }
+            }
+            if (registered.empty() && deregistered.empty()) return;
+            publishSnapshot();
+            publishView();
+            registry_dump_due = true;
+            registration_batches++;
+            registrations_applied += registered.size() + deregistered.size();
+        }
+        publishAvailability();
+
+        if (registered.size() == 1) {
+            log_info("Service registered: " + registered.front());
+        } else if (!registered.empty()) {
+            std::string names;
+            for (const auto &r : registered) names += (names.empty() ? "" : ", ") + r.substr(0, r.find(' '));
+            log_info("Registered " + std::to_string(registered.size()) + " services: " + names);
+        }
+        for (const auto &d : deregistered) log_info("Service deregistered: " + d);
+    }
+
+    // Caller holds services_mtx. Appends a log description of the registration to `done`.
+    void registerService(const json &req, const std::string &peer, std::vector<std::string> &done) {
+        try {
+            ServiceInfo info;
+            info.name = req.at("service").get<std::string>();
+            info.host = req.value("host", "127.0.0.1");
+            info.port = req.at("port").get<int>();
+            info.type = req.value("service_type", "");
+            info.tags = req.value("tags", std::vector<std::string>{});
+            info.last_heartbeat = std::chrono::system_clock::now();
+            info.is_alive = true;
+            info.instance_id = req.value("instance_id", heartbeat::instanceId(info.name));
+            info.detector.heartbeat(PhiAccrualDetector::clock::now());
+
+            auto prev = services.find(info.name);
+            if (prev != services.end() && prev->second.instance_id != info.instance_id) {
+                instances.erase(prev->second.instance_id);
+            }
+            ServiceInfo &slot = services[info.name];
+            slot = info;
+            instances[info.instance_id] = &slot;
+            index.insert(info.name, indexAttributes(info));
+            // {"depends_on":["navigation","audio"]}: dependents are told when these become unavailable
+            if (!dependencies.setDependencies(info.name, req.value("depends_on", std::vector<std::string>{}),
+                                              availability_changes)) {
+                log_warning("Ignoring cyclic depends_on of " + info.name);
+            }
+            dependencies.setAlive(info.name, true, availability_changes);
+            touch(slot);
+            done.push_back(info.name + " at " + info.host + ":" + std::to_string(info.port) + " (peer: " +
+                           peer + ", instance " + std::to_string(info.instance_id) + ")");
+        } catch (std::exception &e) {
+            log_error("Error handling registration: " + std::string(e.what()));
+        }
+    }
+
+    // Caller holds services_mtx. Replicated entries are deregistered by their own node.
+    void deregisterService(const json &req, const std::string &peer, std::vector<std::string> &done) {
+        try {
+            std::string service_name = req.at("service").get<std::string>();
+            auto it = services.find(service_name);
+            if (it == services.end() || !it->second.origin.empty()) return;
+            instances.erase(it->second.instance_id);
+            index.erase(service_name);
+            services.erase(it);
+            dependencies.remove(service_name, availability_changes);
+            addTombstone(service_name);
+            local_changes.insert(service_name);
+            done.push_back(service_name + " (peer: " + peer + ")");
+        } catch (std::exception &e) {
+            log_error("Error handling registration: " + std::string(e.what()));
+        }
+    }
+
     void handleRegistration(const json &req, const std::string &peer) {
         try {
             std::string type = req.value("type", "");
             
-            if (type == "register") {
-                std::lock_guard<std::mutex> lk(services_mtx);
-                
-                ServiceInfo info;
-                info.name = req.at("service").get<std::string>();
-                info.host = req.value("host", "127.0.0.1");
-                info.port = req.at("port").get<int>();
-                info.last_heartbeat = std::chrono::system_clock::now();
-                info.is_alive = true;
-                
-                services[info.name] = info;
-                log_info("Service registered: " + info.name + " at " + info.host + ":" + 
-                         std::to_string(info.port) + " (peer: " + peer + ")");
-                printServices();
-            } 
+            if (type == "register" || type == "register_batch" || type == "deregister") {
+                // {"type":"register_batch","services":[{"service":"media","port":5001,...},...]}
+                // lets a launcher or gateway register many services in one request
+                {
+                    std::lock_guard<std::mutex> lk(pipeline_mtx);
+                    pending_registrations.emplace_back(req, peer);
+                }
+                pipeline_cv.notify_one();
+            }
             else if (type == "heartbeat") {
-                std::lock_guard<std::mutex> lk(services_mtx);
-                
-                std::string service_name = req.at("service").get<std::string>();
-                if (services.count(service_name)) {
-                    services[service_name].last_heartbeat = std::chrono::system_clock::now();
-                    services[service_name].is_alive = true;
-                    log_info("Heartbeat received from: " + service_name);
+                // Legacy JSON heartbeat; the binary channel on HEARTBEAT_PORT is preferred
+                {
+                    std::lock_guard<std::mutex> lk(services_mtx);
+                    auto it = services.find(req.at("service").get<std::string>());
+                    if (it != services.end() && it->second.origin.empty()) {
+                        recordHeartbeat(it->second, std::chrono::system_clock::now(),
+                                        PhiAccrualDetector::clock::now());
+                        publishView();
+                    }
                 }
+                publishAvailability();
             }
             else if (type == "event") {
                 std::string service_name = req.value("service", "unknown");
                 std::string event_name = req.value("event", "unknown");
-                log_info("Event from " + service_name + ": " + event_name);
+                std::string topic = req.value("topic", service_name + "/" + event_name);
+                size_t recipients = broker.publish(topic, req);
+                log_info("Event from " + service_name + ": " + event_name + " -> " +
+                         std::to_string(recipients) + " subscribers");
+            }
+            else if (type == "subscribe" || type == "unsubscribe") {
+                // {"type":"subscribe","topics":["climate/#","+/track_update"],
+                //  "reply_host":"127.0.0.1","reply_port":6000}
+                // A reconnecting subscriber passes "from_offset" (last offset seen + 1)
+                // to receive the events it missed before the live stream. An optional
+                // "filter" (see EventFilter) limits delivery to interesting changes, e.g.
+                // [{"field":"current_temperature","op":"delta_gt","value":0.5}]
+                std::string host = req.value("reply_host", std::string("127.0.0.1"));
+                int port = req.at("reply_port").get<int>();
+                auto topics = req.value("topics", std::vector<std::string>{});
+                if (type == "subscribe") {
+                    SubscribeOptions opts;
+                    opts.replay_last = req.value("replay_last", true);
+                    if (req.contains("from_offset")) opts.resume_from = req.at("from_offset").get<uint64_t>();
+                    if (req.contains("filter")) {
+                        std::string error;
+                        opts.filter = EventFilter::compile(req.at("filter"), error);
+                        if (!opts.filter) {
+                            log_warning("Rejected subscription from " + host + ":" + std::to_string(port) +
+                                        ": invalid filter: " + error);
+                            return;
+                        }
+                    }
+                    broker.subscribe(host, port, topics, opts);
+                } else {
+                    broker.unsubscribe(host, port, topics);
+                }
             }
         } catch (std::exception &e) {
             log_error("Error handling registration: " + std::string(e.what()));
         }
     }
 
-    void handleQuery(const json &req, const std::string &peer) {
+    // Runs on the query server's workers. Registry commands read the current
+    // RegistryView and never take services_mtx.
+    json handleQuery(const json &req, const std::string &peer) {
+        json resp;
         try {
             std::string cmd = req.value("cmd", "");
-            json resp;
-            
+            auto view = std::atomic_load(&registry_view);
+
             if (cmd == "list") {
-                std::lock_guard<std::mutex> lk(services_mtx);
                 resp["services"] = json::array();
-                
-                for (auto &p : services) {
-                    if (p.second.is_alive) {
+                for (const auto &p : view->services) {
+                    if (p.second.alive) {
                         json si;
                         si["service"] = p.second.name;
                         si["host"] = p.second.host;
                         si["port"] = p.second.port;
-                        si["status"] = "alive";
+                        si["status"] = p.second.status;
                         resp["services"].push_back(si);
                     }
                 }
-                log_info("Query 'list' from peer: " + peer + " returned " + 
-                         std::to_string(resp["services"].size()) + " services");
             } 
             else if (cmd == "get") {
-                std::lock_guard<std::mutex> lk(services_mtx);
                 std::string service_name = req.value("service", "");
-                
-                if (services.count(service_name) && services[service_name].is_alive) {
+                auto it = view->services.find(service_name);
+
+                if (it != view->services.end() && it->second.alive) {
                     resp["service"] = service_name;
-                    resp["host"] = services[service_name].host;
-                    resp["port"] = services[service_name].port;
+                    resp["host"] = it->second.host;
+                    resp["port"] = it->second.port;
                     resp["status"] = "found";
+                    resp["health"] = it->second.status;
+                    resp["available"] = it->second.available;
                 } else {
                     resp["status"] = "not_found";
                     resp["service"] = service_name;
                 }
-                log_info("Query 'get " + service_name + "' from peer: " + peer);
+            }
+            else if (cmd == "find") {
+                // Attribute query answered from the secondary indexes, e.g.
+                // {"cmd":"find","service_type":"Media"} for all alive Media instances
+                IndexQuery q;
+                if (req.contains("service_type")) q.type = req.at("service_type").get<std::string>();
+                if (req.contains("host")) q.host = req.at("host").get<std::string>();
+                if (req.contains("port_min")) q.port_min = req.at("port_min").get<int>();
+                if (req.contains("port_max")) q.port_max = req.at("port_max").get<int>();
+                q.tags = req.value("tags", std::vector<std::string>{});
+                bool alive_only = req.value("alive_only", true);
+
+                resp["services"] = json::array();
+                for (const auto &name : view->index.find(q)) {
+                    auto it = view->services.find(name);
+                    if (it == view->services.end() || (alive_only && !it->second.alive)) continue;
+                    json si;
+                    si["service"] = it->second.name;
+                    si["service_type"] = it->second.type;
+                    si["host"] = it->second.host;
+                    si["port"] = it->second.port;
+                    si["tags"] = it->second.tags;
+                    si["status"] = it->second.status;
+                    resp["services"].push_back(si);
+                }
+            }
+            else if (cmd == "changes_since") {
+                // {"cmd":"changes_since","version":N,"epoch":E}; see RegistryView::changesSince
+                resp = view->changesSince(req);
             }
             else if (cmd == "status") {
-                std::lock_guard<std::mutex> lk(services_mtx);
-                resp["total_services"] = (int)services.size();
-                resp["alive_services"] = 0;
-                
-                for (auto &p : services) {
-                    if (p.second.is_alive) {
-                        resp["alive_services"] = resp["alive_services"].get<int>() + 1;
-                    }
+                resp["total_services"] = view->services.size();
+                resp["alive_services"] = view->alive;
+            }
+            else if (cmd == "replay") {
+                // Stream logged events to a diagnostic client, e.g.
+                // {"cmd":"replay","since_sec":600,"topics":["climate/#"],"reply_port":6100}
+                EventBroker::ReplayRequest rr;
+                if (req.contains("from_offset")) {
+                    rr.from_offset = req.at("from_offset").get<uint64_t>();
+                } else {
+                    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                    rr.since_ms = static_cast<uint64_t>(now_ms - req.value("since_sec", 60) * 1000);
                 }
-                log_info("Query 'status' from peer: " + peer);
+                rr.limit = req.value("limit", rr.limit);
+                rr.patterns = req.value("topics", std::vector<std::string>{});
+                std::string host = req.value("reply_host", std::string("127.0.0.1"));
+                bool queued = broker.replay(host, req.value("reply_port", 0), std::move(rr));
+                resp["status"] = queued ? "replaying" : "unavailable";
+                log_info("Query 'replay' from peer: " + peer);
             }
             else {
                 resp["error"] = "unknown_command";
             }
-            
-            // Response is automatically sent by the shim on same socket
-            std::cout << "Query response: " << resp.dump() << std::endl;
         } catch (std::exception &e) {
-            log_error("Error handling query: " + std::string(e.what()));
+            log_error("Error handling query from " + peer + ": " + std::string(e.what()));
+            resp = json{{"error", "bad_request"}};
         }
+        return resp;
     }
 
     void checkHeartbeats() {
-        std::lock_guard<std::mutex> lk(services_mtx);
-        auto now = std::chrono::system_clock::now();
+        {
+            std::lock_guard<std::mutex> lk(services_mtx);
+            auto now = std::chrono::system_clock::now();
+            auto mono_now = PhiAccrualDetector::clock::now();
         
-        for (auto &p : services) {
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
-                now - p.second.last_heartbeat).count();
+            for (auto &p : services) {
+                ServiceInfo &s = p.second;
+                // Replicated entries are monitored by their own node
+                if (!s.is_alive || !s.origin.empty()) continue;
+
+                if (s.detector.hasHistory()) {
+                    double phi = s.detector.phi(mono_now);
+                    if (phi > PHI_DEAD) {
+                        s.is_alive = false;
+                        s.is_suspect = false;
+                        dependencies.setAlive(s.name, false, availability_changes);
+                        touch(s);
+                        log_warning("Service marked as dead (phi " + std::to_string(phi) + "): " + p.first);
+                    } else if (phi > PHI_SUSPECT && !s.is_suspect) {
+                        s.is_suspect = true;
+                        touch(s);
+                        log_warning("Service suspect (phi " + std::to_string(phi) + "): " + p.first);
+                    } else if (phi <= PHI_SUSPECT && s.is_suspect) {
+                        s.is_suspect = false;
+                        touch(s);
+                    }
+                    continue;
+                }
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+                    now - s.last_heartbeat).count();
             
-            if (elapsed > HEARTBEAT_TIMEOUT_SEC && p.second.is_alive) {
-                p.second.is_alive = false;
-                log_warning("Service marked as dead (no heartbeat): " + p.first + 
-                        " (timeout after " + std::to_string(elapsed) + "s)");
+                if (elapsed > HEARTBEAT_TIMEOUT_SEC) {
+                    s.is_alive = false;
+                    dependencies.setAlive(s.name, false, availability_changes);
+                    touch(s);
+                    log_warning("Service marked as dead (no heartbeat): " + p.first + 
+                            " (timeout after " + std::to_string(elapsed) + "s)");
+                }
             }
+            publishView();
         }
+        publishAvailability();
     }
 
-    void printServices() {
-        std::lock_guard<std::mutex> lk(services_mtx);
-        log_info("=== Current Registered Services ===");
-        for (auto &p : services) {
-            std::string status = p.second.is_alive ? "alive" : "dead";
-            log_info(p.first + " -> " + p.second.host + ":" + 
-                    std::to_string(p.second.port) + " [" + status + "]");
+    // Runs on the heartbeat monitor thread. The registry is formatted under
+    // the lock but written to the log outside it.
+    void logRegistryDump() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_registry_dump < REGISTRY_LOG_INTERVAL) return;
+        std::string line;
+        {
+            std::lock_guard<std::mutex> lk(services_mtx);
+            if (!registry_dump_due) return;
+            registry_dump_due = false;
+            line = "Registered services (" + std::to_string(services.size()) + "):";
+            for (auto &p : services) {
+                line += " " + p.first + "->" + p.second.host + ":" + std::to_string(p.second.port) + "[" +
+                        statusOf(p.second) + "]";
+            }
         }
+        last_registry_dump = now;
+        log_info(line);
     }
 
     void runInteractiveCLI() {
@@ -242,7 +879,7 @@ public:
                 std::lock_guard<std::mutex> lk(services_mtx);
                 std::cout << "=== Registered Services ===" << std::endl;
                 for (auto &p : services) {
-                    std::string status = p.second.is_alive ? "alive" : "dead";
+                    std::string status = statusOf(p.second);
                     std::cout << p.first << " -> " << p.second.host << ":" 
                              << p.second.port << " [" << status << "]" << std::endl;
                 }
@@ -258,7 +895,24 @@ public:
                     std::cout << "Service: " << s.name << std::endl;
                     std::cout << "Host: " << s.host << std::endl;
                     std::cout << "Port: " << s.port << std::endl;
-                    std::cout << "Status: " << (s.is_alive ? "alive" : "dead") << std::endl;
+                    std::cout << "Type: " << (s.type.empty() ? "-" : s.type) << std::endl;
+                    if (!s.tags.empty()) {
+                        std::cout << "Tags:";
+                        for (const auto &t : s.tags) std::cout << " " << t;
+                        std::cout << std::endl;
+                    }
+                    std::cout << "Instance: " << s.instance_id << " (seq " << s.last_sequence
+                              << ", load " << s.load << ")" << std::endl;
+                    std::cout << "Status: " << statusOf(s) << std::endl;
+                    auto deps = dependencies.dependencies(name);
+                    if (!deps.empty()) {
+                        std::cout << "Depends on:";
+                        for (const auto &d : deps) std::cout << " " << d;
+                        std::cout << (dependencies.available(name) ? "" : " (unavailable)") << std::endl;
+                    }
+                    std::cout << "Phi: " << s.detector.phi(PhiAccrualDetector::clock::now())
+                              << " (mean interval " << s.detector.meanIntervalMs() << " ms, stddev "
+                              << s.detector.stdDevMs() << " ms)" << std::endl;
                 } else {
                     std::cout << "Service not found: " << name << std::endl;
                 }
@@ -271,12 +925,75 @@ public:
                 }
                 std::cout << "Total services: " << services.size() << std::endl;
                 std::cout << "Alive services: " << alive_count << std::endl;
+                if (query_server) {
+                    std::cout << "Queries served: " << query_server->queries() << " ("
+                              << query_server->threads() << " workers)" << std::endl;
+                }
+                std::cout << "Registrations: " << registrations_applied << " in " << registration_batches
+                          << " batches" << std::endl;
+                std::cout << "Heartbeat frames: " << heartbeat_frames
+                          << " (rejected: " << heartbeat_rejected << ")" << std::endl;
+                auto ps = proxy->stats();
+                std::cout << "Proxied calls: " << ps.calls << " (" << ps.bytes << " bytes, "
+                          << ps.errors << " errors)" << std::endl;
+            }
+            else if (line == "timeline") {
+                if (!launcher) {
+                    std::cout << "No services launched by the Service Manager" << std::endl;
+                    continue;
+                }
+                for (const auto &ev : launcher->timeline()) {
+                    std::cout << ev.name << " [" << ev.state << "] pid " << ev.pid
+                              << " spawn +" << ev.spawn_ms << " ms, ready +" << ev.ready_ms << " ms";
+                    if (!ev.detail.empty()) std::cout << " (" << ev.detail << ")";
+                    std::cout << std::endl;
+                }
+            }
+            else if (line == "subscribers") {
+                auto subs = broker.subscribers();
+                for (const auto &sub : subs) {
+                    std::cout << sub.endpoint << " (" << sub.delivered << " delivered):";
+                    for (const auto &p : sub.patterns) std::cout << " " << p;
+                    std::cout << std::endl;
+                    for (const auto &f : sub.filters) std::cout << "    filter " << f << std::endl;
+                }
+                if (subs.empty()) {
+                    std::cout << "No event subscribers" << std::endl;
+                }
+                std::cout << "Cached last values: " << broker.cachedValues() << std::endl;
+                std::cout << "Filtered events: " << broker.filtered() << std::endl;
+                std::cout << "Dropped events: " << broker.dropped() << std::endl;
+            }
+            else if (line == "federation") {
+                if (!gossip) {
+                    std::cout << "Not federated" << std::endl;
+                    continue;
+                }
+                std::cout << "Node " << gossip->nodeId() << std::endl;
+                for (const auto &o : gossip->versionVector()) {
+                    std::cout << "  " << o.origin << " incarnation " << o.incarnation << " version " << o.version
+                              << ", " << o.entries << " services" << (o.reachable ? "" : " (unreachable)")
+                              << std::endl;
+                }
+            }
+            else if (line == "eventlog") {
+                const EventLog *elog = broker.eventLog();
+                if (!elog) {
+                    std::cout << "Event log disabled" << std::endl;
+                    continue;
+                }
+                std::cout << "Event log offsets " << elog->firstOffset() << ".." << elog->nextOffset()
+                          << " in " << elog->segmentCount() << " segments" << std::endl;
             }
             else if (line == "help") {
                 std::cout << "Commands:" << std::endl;
                 std::cout << "  list              - List all registered services" << std::endl;
                 std::cout << "  info <service>    - Get info about a service" << std::endl;
                 std::cout << "  status            - Show service manager status" << std::endl;
+                std::cout << "  timeline          - Show the boot timeline of launched services" << std::endl;
+                std::cout << "  subscribers       - List event subscribers and their topics" << std::endl;
+                std::cout << "  eventlog          - Show the retained range of the event log" << std::endl;
+                std::cout << "  federation        - Show the version vector of federated nodes" << std::endl;
                 std::cout << "  exit              - Shutdown service manager" << std::endl;
                 std::cout << "  help              - Show this help message" << std::endl;
             }
@@ -288,26 +1005,86 @@ public:
 
     void shutdown() {
         log_info("Service Manager shutting down");
+        if (launcher) {
+            launcher->stop();
+        }
         running = false;
         
-        if (registration_server_thread.joinable()) {
-            registration_server_thread.join();
+        if (registration_server) {
+            registration_server->stop();
+        }
+        {
+            // Serialises with the pipeline's predicate check so the wakeup is not lost
+            std::lock_guard<std::mutex> lk(pipeline_mtx);
         }
-        if (query_server_thread.joinable()) {
-            query_server_thread.join();
+        pipeline_cv.notify_all();
+        if (registration_pipeline_thread.joinable()) {
+            registration_pipeline_thread.join();
+        }
+        if (query_server) {
+            query_server->stop();
         }
         if (heartbeat_monitor_thread.joinable()) {
             heartbeat_monitor_thread.join();
         }
+        if (heartbeat_channel_thread.joinable()) {
+            heartbeat_channel_thread.join();
+        }
+        if (heartbeat_fd >= 0) {
+            ::close(heartbeat_fd);
+            heartbeat_fd = -1;
+        }
+        snapshot.stop();
+        broker.stop();
+        if (gossip) gossip->stop();
+        proxy->stop();
         
         log_info("Service Manager shutdown complete");
     }
 };
 
-int main()
+int main(int argc, char **argv)
 {
-    ServiceManager service_manager;
+    std::string manifest;
+    std::string bin_dir;
+    std::string data_dir = IVI_DATA_DIR;
+    size_t query_threads = 0;
+    int port_offset = 0;
+    std::string node_id;
+    int gossip_port = 4010;
+    std::vector<std::string> peers;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--manifest" && i + 1 < argc) manifest = argv[++i];
+        else if (arg == "--bin-dir" && i + 1 < argc) bin_dir = argv[++i];
+        else if (arg == "--data-dir" && i + 1 < argc) data_dir = argv[++i];
+        else if (arg == "--query-threads" && i + 1 < argc) query_threads = std::stoul(argv[++i]);
+        else if (arg == "--port-offset" && i + 1 < argc) port_offset = std::stoi(argv[++i]);
+        else if (arg == "--node-id" && i + 1 < argc) node_id = argv[++i];
+        else if (arg == "--gossip-port" && i + 1 < argc) gossip_port = std::stoi(argv[++i]);
+        else if (arg == "--peer" && i + 1 < argc) peers.push_back(argv[++i]);
+        else {
+            std::cerr << "usage: service_manager [--manifest <launch.json>] [--bin-dir <dir>]"
+                      << " [--data-dir <dir>] [--query-threads <n>] [--port-offset <n>]"
+                      << " [--node-id <id> --gossip-port <port> --peer <host:port>...]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(data_dir, ec);
+    if (ec) {
+        std::cerr << "cannot create data directory " << data_dir << ": " << ec.message() << std::endl;
+        return 1;
+    }
+    ServiceManager service_manager(data_dir);
+    service_manager.setQueryThreads(query_threads);
+    service_manager.setPortOffset(port_offset);
+    if (!node_id.empty()) service_manager.setFederation(node_id, gossip_port, peers);
     service_manager.initialize();
+    if (!manifest.empty() && !service_manager.launchServices(manifest, bin_dir)) {
+        log_error("Failed to launch services from " + manifest);
+    }
     service_manager.runInteractiveCLI();
     service_manager.shutdown();
     
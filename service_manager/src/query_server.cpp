@@ -0,0 +1,225 @@
+#include "query_server.hpp"
+#include "../../common/include/logging.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+struct Connection {
+    std::string peer;
+    std::string in;
+    std::string out;
+    bool closing = false; // peer shut down its side; close once `out` is sent
+};
+
+// SO_REUSEPORT would let a second server join a port that is already being
+// served and silently take part of its connections; probe without it first.
+bool portTaken(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    bool taken = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 && errno == EADDRINUSE;
+    ::close(fd);
+    return taken;
+}
+
+} // namespace
+
+QueryServer::QueryServer(int port, size_t threads, Handler handler)
+    : port(port), thread_count(threads), handler(std::move(handler)) {
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+}
+
+QueryServer::~QueryServer() {
+    stop();
+}
+
+int QueryServer::openListener(int listen_port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(listen_port));
+    socklen_t len = sizeof(addr);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 128) < 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    bound_port = ntohs(addr.sin_port);
+    return fd;
+}
+
+bool QueryServer::start() {
+    if (running) return true;
+    if (port != 0 && portTaken(port)) {
+        log_error("Query server: port " + std::to_string(port) + " is already served by another process");
+        return false;
+    }
+    // The first listener fixes the port when binding to an ephemeral one
+    int listen_port = port;
+    for (size_t i = 0; i < thread_count; ++i) {
+        auto w = std::make_unique<Worker>();
+        w->listen_fd = openListener(listen_port);
+        w->epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (w->listen_fd < 0 || w->epoll_fd < 0) {
+            log_error("Query server: failed to listen on port " + std::to_string(listen_port) + ": " +
+                      std::strerror(errno));
+            if (w->listen_fd >= 0) ::close(w->listen_fd);
+            if (w->epoll_fd >= 0) ::close(w->epoll_fd);
+            workers.push_back(std::move(w));
+            stop();
+            return false;
+        }
+        listen_port = bound_port;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = w->listen_fd;
+        ::epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD, w->listen_fd, &ev);
+        workers.push_back(std::move(w));
+    }
+
+    running = true;
+    for (auto& w : workers) {
+        Worker* worker = w.get();
+        worker->thread = std::thread([this, worker]() { run(*worker); });
+    }
+    log_info("Query server listening on port " + std::to_string(bound_port) + " with " +
+             std::to_string(workers.size()) + " workers");
+    return true;
+}
+
+void QueryServer::stop() {
+    running = false;
+    for (auto& w : workers) {
+        if (w->thread.joinable()) w->thread.join();
+        if (w->listen_fd >= 0) ::close(w->listen_fd);
+        if (w->epoll_fd >= 0) ::close(w->epoll_fd);
+    }
+    workers.clear();
+}
+
+uint64_t QueryServer::queries() const {
+    uint64_t total = 0;
+    for (const auto& w : workers) total += w->queries.load(std::memory_order_relaxed);
+    return total;
+}
+
+void QueryServer::run(Worker& w) {
+    std::unordered_map<int, Connection> conns;
+    epoll_event events[64];
+
+    auto closeConn = [&](int fd) {
+        ::epoll_ctl(w.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        conns.erase(fd);
+    };
+
+    // Write as much of the pending output as the socket takes; wait for
+    // EPOLLOUT only while something is left over.
+    auto flush = [&](int fd, Connection& c) {
+        while (!c.out.empty()) {
+            ssize_t n = ::send(fd, c.out.data(), c.out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n <= 0) return false;
+            c.out.erase(0, static_cast<size_t>(n));
+        }
+        epoll_event ev{};
+        ev.events = c.closing ? 0u : static_cast<uint32_t>(EPOLLIN);
+        if (!c.out.empty()) ev.events |= EPOLLOUT;
+        ev.data.fd = fd;
+        ::epoll_ctl(w.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+        return true;
+    };
+
+    while (running) {
+        int n = ::epoll_wait(w.epoll_fd, events, 64, 200);
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == w.listen_fd) {
+                sockaddr_in peer{};
+                socklen_t len = sizeof(peer);
+                int c;
+                while ((c = ::accept4(w.listen_fd, reinterpret_cast<sockaddr*>(&peer), &len,
+                                      SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    char host[INET_ADDRSTRLEN] = {};
+                    inet_ntop(AF_INET, &peer.sin_addr, host, sizeof(host));
+                    conns[c].peer = std::string(host) + ":" + std::to_string(ntohs(peer.sin_port));
+                    epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = c;
+                    ::epoll_ctl(w.epoll_fd, EPOLL_CTL_ADD, c, &ev);
+                    len = sizeof(peer);
+                }
+                continue;
+            }
+
+            auto it = conns.find(fd);
+            if (it == conns.end()) continue;
+            Connection& conn = it->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConn(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) {
+                if (!flush(fd, conn) || (conn.closing && conn.out.empty())) {
+                    closeConn(fd);
+                    continue;
+                }
+            }
+            if (!(events[i].events & EPOLLIN)) continue;
+
+            char buf[16 * 1024];
+            while (true) {
+                ssize_t r = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+                if (r < 0 && errno == EINTR) continue;
+                if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (r <= 0) {
+                    conn.closing = true;
+                    break;
+                }
+                conn.in.append(buf, static_cast<size_t>(r));
+            }
+
+            size_t start = 0, nl;
+            while ((nl = conn.in.find('\n', start)) != std::string::npos) {
+                nlohmann::json resp;
+                try {
+                    resp = handler(nlohmann::json::parse(conn.in.begin() + start, conn.in.begin() + nl), conn.peer);
+                } catch (const std::exception&) {
+                    resp = {{"error", "bad_request"}};
+                }
+                conn.out += resp.dump();
+                conn.out += '\n';
+                start = nl + 1;
+                w.queries.fetch_add(1, std::memory_order_relaxed);
+            }
+            conn.in.erase(0, start);
+
+            // A client that half-closes after its last request still gets every reply
+            if (conn.in.size() > MAX_REQUEST || !flush(fd, conn) || (conn.closing && conn.out.empty())) {
+                closeConn(fd);
+            }
+        }
+    }
+
+    for (auto& c : conns) ::close(c.first);
+}
@@ -0,0 +1,63 @@
+#ifndef QUERY_SERVER_HPP
+#define QUERY_SERVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-threaded discovery query server.
+//
+// Each worker owns a listening socket bound to the same port with
+// SO_REUSEPORT, so the kernel spreads incoming connections across workers
+// without a shared accept queue, and runs its own epoll loop over its
+// connections. Requests and replies are newline-delimited JSON; pipelined
+// requests on one connection are answered in order, also after the client has
+// shut down its sending side. start() fails if another process already
+// listens on the port, rather than sharing it through SO_REUSEPORT.
+//
+// The handler runs on the worker threads concurrently and must not block on
+// registry writers; the Service Manager answers from an immutable registry
+// view (see RegistryView in main.cpp). The registration port uses the same
+// server with one worker; its replies only acknowledge receipt.
+
+class QueryServer {
+public:
+    using Handler = std::function<nlohmann::json(const nlohmann::json& req, const std::string& peer)>;
+
+    // `threads` == 0 starts one worker per core.
+    QueryServer(int port, size_t threads, Handler handler);
+    ~QueryServer();
+
+    bool start();
+    void stop();
+
+    int boundPort() const { return bound_port; } // actual port when constructed with 0
+    size_t threads() const { return workers.size(); }
+    uint64_t queries() const;
+
+private:
+    struct Worker {
+        int listen_fd = -1;
+        int epoll_fd = -1;
+        std::atomic<uint64_t> queries{0};
+        std::thread thread;
+    };
+
+    int openListener(int port);
+    void run(Worker& w);
+
+    int port;
+    int bound_port = 0;
+    size_t thread_count;
+    Handler handler;
+    std::atomic_bool running{false};
+    std::vector<std::unique_ptr<Worker>> workers;
+    const size_t MAX_REQUEST = 64 * 1024;
+};
+
+#endif // QUERY_SERVER_HPP
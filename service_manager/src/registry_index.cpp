@@ -0,0 +1,81 @@
+#include "registry_index.hpp"
+#include <algorithm>
+
+namespace {
+
+template <typename Map, typename Key>
+void removeFrom(Map& index, const Key& key, const std::string& name) {
+    auto it = index.find(key);
+    if (it == index.end()) return;
+    it->second.erase(name);
+    if (it->second.empty()) index.erase(it);
+}
+
+} // namespace
+
+void RegistryIndex::insert(const std::string& name, const IndexedAttributes& a) {
+    erase(name);
+    attrs[name] = a;
+    if (!a.type.empty()) by_type[a.type].insert(name);
+    by_host[a.host].insert(name);
+    by_port[a.port].insert(name);
+    for (const auto& tag : a.tags) by_tag[tag].insert(name);
+}
+
+void RegistryIndex::erase(const std::string& name) {
+    auto it = attrs.find(name);
+    if (it == attrs.end()) return;
+    const IndexedAttributes& a = it->second;
+    removeFrom(by_type, a.type, name);
+    removeFrom(by_host, a.host, name);
+    removeFrom(by_port, a.port, name);
+    for (const auto& tag : a.tags) removeFrom(by_tag, tag, name);
+    attrs.erase(it);
+}
+
+bool RegistryIndex::matches(const IndexedAttributes& a, const IndexQuery& q) const {
+    if (q.type && a.type != *q.type) return false;
+    if (q.host && a.host != *q.host) return false;
+    if (q.port_min && a.port < *q.port_min) return false;
+    if (q.port_max && a.port > *q.port_max) return false;
+    for (const auto& tag : q.tags) {
+        if (std::find(a.tags.begin(), a.tags.end(), tag) == a.tags.end()) return false;
+    }
+    return true;
+}
+
+std::vector<std::string> RegistryIndex::find(const IndexQuery& q) const {
+    static const Bucket empty;
+    std::vector<std::string> result;
+
+    // Pick the most selective equality index as the candidate set
+    const Bucket* best = nullptr;
+    auto consider = [&](const std::unordered_map<std::string, Bucket>& index, const std::string& key) {
+        auto it = index.find(key);
+        const Bucket* b = (it == index.end()) ? &empty : &it->second;
+        if (!best || b->size() < best->size()) best = b;
+    };
+    if (q.type) consider(by_type, *q.type);
+    if (q.host) consider(by_host, *q.host);
+    for (const auto& tag : q.tags) consider(by_tag, tag);
+
+    if (best) {
+        for (const auto& name : *best) {
+            if (matches(attrs.at(name), q)) result.push_back(name);
+        }
+    } else if (q.port_min && q.port_max && *q.port_min > *q.port_max) {
+        return result;
+    } else if (q.port_min || q.port_max) {
+        auto lo = q.port_min ? by_port.lower_bound(*q.port_min) : by_port.begin();
+        auto hi = q.port_max ? by_port.upper_bound(*q.port_max) : by_port.end();
+        for (auto it = lo; it != hi; ++it) {
+            result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+    } else {
+        result.reserve(attrs.size());
+        for (const auto& p : attrs) result.push_back(p.first);
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,54 @@
+#ifndef REGISTRY_INDEX_HPP
+#define REGISTRY_INDEX_HPP
+
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Secondary indexes over the service registry: by type, host, port and tag.
+//
+// Maintained incrementally on register/deregister. find() starts from the
+// smallest matching index bucket and verifies the remaining criteria on that
+// candidate set only, so selective queries never scan the whole registry.
+
+struct IndexedAttributes {
+    std::string type;
+    std::string host;
+    int port = 0;
+    std::vector<std::string> tags;
+};
+
+struct IndexQuery {
+    std::optional<std::string> type;
+    std::optional<std::string> host;
+    std::optional<int> port_min;
+    std::optional<int> port_max;
+    std::vector<std::string> tags; // all must match
+};
+
+class RegistryIndex {
+public:
+    void insert(const std::string& name, const IndexedAttributes& attrs);
+    void erase(const std::string& name);
+
+    // Names of all services matching every criterion in `q`.
+    std::vector<std::string> find(const IndexQuery& q) const;
+
+    size_t size() const { return attrs.size(); }
+
+private:
+    using Bucket = std::unordered_set<std::string>;
+
+    bool matches(const IndexedAttributes& a, const IndexQuery& q) const;
+
+    std::unordered_map<std::string, IndexedAttributes> attrs;
+    std::unordered_map<std::string, Bucket> by_type;
+    std::unordered_map<std::string, Bucket> by_host;
+    std::unordered_map<std::string, Bucket> by_tag;
+    std::map<int, Bucket> by_port;
+};
+
+#endif // REGISTRY_INDEX_HPP
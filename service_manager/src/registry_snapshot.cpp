@@ -0,0 +1,205 @@
+#include "registry_snapshot.hpp"
+#include "../../common/include/checksum.hpp"
+#include "../../common/include/logging.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kMagic = 0x52495649; // "IVIR"
+constexpr uint16_t kVersion = 2;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kEntryFixedSize = 14;
+
+template <typename T>
+void put(std::vector<uint8_t>& buf, T value) {
+    const auto* p = reinterpret_cast<const uint8_t*>(&value);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+T get(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// Lengths and the tag count are stored as u16
+bool fitsLayout(const SnapshotEntry& e) {
+    if (e.name.size() > UINT16_MAX || e.host.size() > UINT16_MAX || e.type.size() > UINT16_MAX ||
+        e.tags.size() > UINT16_MAX) {
+        return false;
+    }
+    for (const auto& tag : e.tags) {
+        if (tag.size() > UINT16_MAX) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+RegistrySnapshot::RegistrySnapshot(std::string path)
+    : path(std::move(path)) {}
+
+RegistrySnapshot::~RegistrySnapshot() {
+    stop();
+}
+
+bool RegistrySnapshot::load(std::vector<SnapshotEntry>& out) const {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const auto* base = static_cast<const uint8_t*>(map);
+    bool ok = get<uint32_t>(base) == kMagic && get<uint16_t>(base + 4) == kVersion &&
+              common::crc32(base + kHeaderSize, size - kHeaderSize) == get<uint32_t>(base + 12);
+
+    if (ok) {
+        uint32_t count = get<uint32_t>(base + 8);
+        const uint8_t* p = base + kHeaderSize;
+        const uint8_t* end = base + size;
+        out.clear();
+        out.reserve(count);
+        for (uint32_t i = 0; i < count && ok; ++i) {
+            if (end - p < static_cast<ptrdiff_t>(kEntryFixedSize)) { ok = false; break; }
+            SnapshotEntry e;
+            e.instance_id = get<uint32_t>(p);
+            e.port = get<uint16_t>(p + 4);
+            uint16_t name_len = get<uint16_t>(p + 6);
+            uint16_t host_len = get<uint16_t>(p + 8);
+            uint16_t type_len = get<uint16_t>(p + 10);
+            uint16_t tag_count = get<uint16_t>(p + 12);
+            p += kEntryFixedSize;
+            if (end - p < name_len + host_len + type_len) { ok = false; break; }
+            e.name.assign(reinterpret_cast<const char*>(p), name_len);
+            e.host.assign(reinterpret_cast<const char*>(p + name_len), host_len);
+            e.type.assign(reinterpret_cast<const char*>(p + name_len + host_len), type_len);
+            p += name_len + host_len + type_len;
+            for (uint16_t t = 0; t < tag_count; ++t) {
+                if (end - p < 2) { ok = false; break; }
+                uint16_t tag_len = get<uint16_t>(p);
+                p += 2;
+                if (end - p < tag_len) { ok = false; break; }
+                e.tags.emplace_back(reinterpret_cast<const char*>(p), tag_len);
+                p += tag_len;
+            }
+            out.push_back(std::move(e));
+        }
+    }
+
+    ::munmap(map, size);
+    if (!ok) log_warning("Registry snapshot " + path + " is corrupt, ignoring it");
+    return ok;
+}
+
+void RegistrySnapshot::publish(std::vector<SnapshotEntry> entries) {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        pending = std::move(entries);
+        dirty = true;
+    }
+    cv.notify_one();
+}
+
+void RegistrySnapshot::start() {
+    std::lock_guard<std::mutex> lk(mtx);
+    if (writer.joinable()) return;
+    stopping = false;
+    writer = std::thread([this]() { writerLoop(); });
+}
+
+void RegistrySnapshot::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (writer.joinable()) writer.join();
+}
+
+void RegistrySnapshot::writerLoop() {
+    std::unique_lock<std::mutex> lk(mtx);
+    while (true) {
+        cv.wait(lk, [this]() { return dirty || stopping; });
+        if (dirty) {
+            std::vector<SnapshotEntry> image = std::move(pending);
+            dirty = false;
+            lk.unlock();
+            write(image);
+            lk.lock();
+        } else if (stopping) {
+            return;
+        }
+    }
+}
+
+bool RegistrySnapshot::write(const std::vector<SnapshotEntry>& entries) const {
+    std::vector<uint8_t> buf(kHeaderSize, 0);
+    uint32_t count = 0;
+    for (const auto& e : entries) {
+        // A truncated length would desync every later entry behind a valid CRC
+        if (!fitsLayout(e)) {
+            log_warning("Registry snapshot: skipping " + e.name.substr(0, 64) + ", a field is too long");
+            continue;
+        }
+        ++count;
+        put<uint32_t>(buf, e.instance_id);
+        put<uint16_t>(buf, static_cast<uint16_t>(e.port));
+        put<uint16_t>(buf, static_cast<uint16_t>(e.name.size()));
+        put<uint16_t>(buf, static_cast<uint16_t>(e.host.size()));
+        put<uint16_t>(buf, static_cast<uint16_t>(e.type.size()));
+        put<uint16_t>(buf, static_cast<uint16_t>(e.tags.size()));
+        buf.insert(buf.end(), e.name.begin(), e.name.end());
+        buf.insert(buf.end(), e.host.begin(), e.host.end());
+        buf.insert(buf.end(), e.type.begin(), e.type.end());
+        for (const auto& tag : e.tags) {
+            put<uint16_t>(buf, static_cast<uint16_t>(tag.size()));
+            buf.insert(buf.end(), tag.begin(), tag.end());
+        }
+    }
+    uint32_t magic = kMagic;
+    uint16_t version = kVersion;
+    uint32_t crc = common::crc32(buf.data() + kHeaderSize, buf.size() - kHeaderSize);
+    std::memcpy(buf.data(), &magic, 4);
+    std::memcpy(buf.data() + 4, &version, 2);
+    std::memcpy(buf.data() + 8, &count, 4);
+    std::memcpy(buf.data() + 12, &crc, 4);
+
+    std::string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log_error("Failed to open registry snapshot for writing: " + tmp);
+        return false;
+    }
+    size_t off = 0;
+    while (off < buf.size()) {
+        ssize_t n = ::write(fd, buf.data() + off, buf.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            log_error("Failed to write registry snapshot: " + std::string(std::strerror(errno)));
+            ::close(fd);
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    ::fdatasync(fd);
+    ::close(fd);
+
+    if (::rename(tmp.c_str(), path.c_str()) < 0) {
+        log_error("Failed to replace registry snapshot: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    return true;
+}
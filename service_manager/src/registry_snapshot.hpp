@@ -0,0 +1,58 @@
+#ifndef REGISTRY_SNAPSHOT_HPP
+#define REGISTRY_SNAPSHOT_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Compact binary snapshot of the service registry for warm restarts.
+//
+// File layout (host byte order, the file never leaves the machine):
+//   header: magic u32 | version u16 | reserved u16 | count u32 | crc32(body) u32
+//   entry:  instance_id u32 | port u16 | name_len u16 | host_len u16 | type_len u16 |
+//           tag_count u16 | name | host | type | (tag_len u16 | tag) * tag_count
+//
+// publish() hands the latest registry image to a background writer, which
+// replaces the file atomically; intermediate images are coalesced. Entries
+// with a field or tag count beyond u16 are left out of the file.
+
+struct SnapshotEntry {
+    std::string name;
+    std::string host;
+    int port = 0;
+    uint32_t instance_id = 0;
+    std::string type;
+    std::vector<std::string> tags;
+};
+
+class RegistrySnapshot {
+public:
+    explicit RegistrySnapshot(std::string path);
+    ~RegistrySnapshot();
+
+    // Map the snapshot file and decode it. Returns false if it is missing or corrupt.
+    bool load(std::vector<SnapshotEntry>& out) const;
+
+    // Queue a new registry image for the background writer.
+    void publish(std::vector<SnapshotEntry> entries);
+
+    void start();
+    void stop(); // writes any pending image before returning
+
+private:
+    void writerLoop();
+    bool write(const std::vector<SnapshotEntry>& entries) const;
+
+    std::string path;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<SnapshotEntry> pending;
+    bool dirty = false;
+    bool stopping = false;
+    std::thread writer;
+};
+
+#endif // REGISTRY_SNAPSHOT_HPP
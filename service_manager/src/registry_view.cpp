@@ -0,0 +1,62 @@
+#include "registry_view.hpp"
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+using json = nlohmann::json;
+
+json RegistryView::changesSince(const json& req) const {
+    uint64_t since = req.value("version", uint64_t{0});
+    bool full = req.value("epoch", uint64_t{0}) != epoch || since < tombstone_floor || since > version;
+    if (full) since = 0;
+
+    auto entryJson = [](const Entry& e) {
+        return json{{"service", e.name}, {"service_type", e.type}, {"host", e.host},
+                    {"port", e.port}, {"tags", e.tags}, {"status", e.status}};
+    };
+    json resp;
+    resp["changed"] = json::array();
+    resp["removed"] = json::array();
+    auto after = [](uint64_t v, const std::pair<uint64_t, std::string>& e) { return v < e.first; };
+    auto first = std::upper_bound(by_version.begin(), by_version.end(), since, after);
+    for (auto it = first; it != by_version.end(); ++it) {
+        resp["changed"].push_back(entryJson(services.at(it->second)));
+    }
+    if (!full) {
+        std::unordered_set<std::string> removed;
+        auto t = std::upper_bound(tombstones.begin(), tombstones.end(), since, after);
+        for (; t != tombstones.end(); ++t) {
+            // A service registered again after its removal is reported as changed
+            if (!services.count(t->second) && removed.insert(t->second).second) {
+                resp["removed"].push_back(t->second);
+            }
+        }
+    }
+    resp["version"] = version;
+    resp["epoch"] = epoch;
+    resp["full"] = full;
+    return resp;
+}
+
+RegistryChangeLog::RegistryChangeLog(size_t max_tombstones)
+    : RegistryChangeLog(static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count()),
+                        max_tombstones) {}
+
+RegistryChangeLog::RegistryChangeLog(uint64_t epoch, size_t max_tombstones)
+    : run_epoch(epoch), max_tombstones(max_tombstones) {}
+
+uint64_t RegistryChangeLog::remove(const std::string& name) {
+    tombstones.emplace_back(++current, name);
+    if (tombstones.size() > max_tombstones) {
+        floor = tombstones.front().first;
+        tombstones.pop_front();
+    }
+    return current;
+}
+
+void RegistryChangeLog::stamp(RegistryView& view) const {
+    view.epoch = run_epoch;
+    view.version = current;
+    view.tombstones.assign(tombstones.begin(), tombstones.end());
+    view.tombstone_floor = floor;
+}
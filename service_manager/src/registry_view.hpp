@@ -0,0 +1,75 @@
+#ifndef REGISTRY_VIEW_HPP
+#define REGISTRY_VIEW_HPP
+
+#include <cstdint>
+#include <deque>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "registry_index.hpp"
+
+// Immutable image of the registry answered by the query workers. It is
+// rebuilt under services_mtx whenever the registry or a service's status
+// changes and swapped in atomically, so queries never wait for writers.
+//
+// Every visible change bumps the registry version. `by_version` and the
+// tombstones of removed services let changes_since answer in O(log n + changes).
+struct RegistryView {
+    struct Entry {
+        std::string name;
+        std::string host;
+        int port;
+        std::string type;
+        std::vector<std::string> tags;
+        const char* status;
+        bool alive;
+        bool available; // alive and all dependencies available
+        uint64_t version;
+    };
+    std::unordered_map<std::string, Entry> services;
+    RegistryIndex index;
+    size_t alive = 0;
+    uint64_t epoch = 0;
+    uint64_t version = 0;
+    std::vector<std::pair<uint64_t, std::string>> by_version;  // ascending
+    std::vector<std::pair<uint64_t, std::string>> tombstones;  // ascending
+    uint64_t tombstone_floor = 0; // removals at or below were truncated
+
+    // Reply to {"cmd":"changes_since","version":N,"epoch":E}: the entries
+    // changed after N and the services removed since. Clients keep the
+    // returned version and epoch; "full":true means replace the cache, sent
+    // when N is from another run, older than the kept tombstones or unknown.
+    nlohmann::json changesSince(const nlohmann::json& req) const;
+};
+
+// Registry version counter and the bounded log of removals behind
+// changes_since. The epoch changes on every start so clients holding versions
+// of a previous run resync fully. Not thread-safe; the Service Manager keeps
+// it under services_mtx.
+class RegistryChangeLog {
+public:
+    explicit RegistryChangeLog(size_t max_tombstones = 1024);
+    RegistryChangeLog(uint64_t epoch, size_t max_tombstones);
+
+    // Version for an added or changed entry
+    uint64_t next() { return ++current; }
+    // Records the removal of `name`; the oldest tombstone is dropped past the limit
+    uint64_t remove(const std::string& name);
+
+    uint64_t version() const { return current; }
+    uint64_t epoch() const { return run_epoch; }
+
+    // Copies the epoch, version and tombstones into a view being built
+    void stamp(RegistryView& view) const;
+
+private:
+    const uint64_t run_epoch;
+    const size_t max_tombstones;
+    uint64_t current = 0;
+    std::deque<std::pair<uint64_t, std::string>> tombstones;
+    uint64_t floor = 0;
+};
+
+#endif // REGISTRY_VIEW_HPP
@@ -0,0 +1,215 @@
+#include "rpc_proxy.hpp"
+#include "../../common/include/logging.hpp"
+#include "../../common/include/rpc_frame.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace rpc = common::rpc;
+
+namespace {
+
+constexpr int kPipeSize = 1 << 20;
+// A hung backend fails the call instead of pinning its connection thread
+constexpr timeval kBackendTimeout{5, 0};
+
+// Fallback for descriptors splice() does not support
+bool copyPayload(int from, int to, size_t len) {
+    char buf[64 * 1024];
+    while (len > 0) {
+        size_t n = std::min(len, sizeof(buf));
+        if (!rpc::readFull(from, buf, n) || !rpc::writeFull(to, buf, n)) return false;
+        len -= n;
+    }
+    return true;
+}
+
+bool discardPayload(int from, size_t len) {
+    char buf[16 * 1024];
+    while (len > 0) {
+        size_t n = std::min(len, sizeof(buf));
+        if (!rpc::readFull(from, buf, n)) return false;
+        len -= n;
+    }
+    return true;
+}
+
+} // namespace
+
+RpcProxy::RpcProxy(int port, Resolver resolve)
+    : port(port), resolve(std::move(resolve)) {}
+
+RpcProxy::~RpcProxy() {
+    stop();
+}
+
+bool RpcProxy::start() {
+    listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        log_error("RPC proxy: failed to create socket: " + std::string(std::strerror(errno)));
+        return false;
+    }
+    int one = 1;
+    ::setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    socklen_t len = sizeof(addr);
+    if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd, 64) < 0 ||
+        ::getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        log_error("RPC proxy: failed to listen on port " + std::to_string(port) + ": " + std::strerror(errno));
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    bound_port = ntohs(addr.sin_port);
+
+    running = true;
+    acceptor = std::thread([this]() { acceptLoop(); });
+    log_info("RPC proxy listening on port " + std::to_string(bound_port));
+    return true;
+}
+
+void RpcProxy::stop() {
+    running = false;
+    if (acceptor.joinable()) acceptor.join();
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+        listen_fd = -1;
+    }
+    // Unblock connection threads and wait for them to finish
+    std::unique_lock<std::mutex> lk(conn_mtx);
+    for (int fd : clients) ::shutdown(fd, SHUT_RDWR);
+    for (int fd : backend_fds) ::shutdown(fd, SHUT_RDWR);
+    conn_cv.wait(lk, [this]() { return clients.empty(); });
+}
+
+RpcProxy::Stats RpcProxy::stats() const {
+    return Stats{calls.load(), bytes.load(), errors.load()};
+}
+
+void RpcProxy::acceptLoop() {
+    pollfd pfd{listen_fd, POLLIN, 0};
+    while (running) {
+        if (::poll(&pfd, 1, 200) <= 0) continue;
+        int fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        {
+            std::lock_guard<std::mutex> lk(conn_mtx);
+            clients.insert(fd);
+        }
+        std::thread([this, fd]() { serve(fd); }).detach();
+    }
+}
+
+bool RpcProxy::forward(int from, int to, const int pipefd[2], size_t len, size_t chunk) {
+    bool first = true;
+    while (len > 0) {
+        ssize_t in = ::splice(from, nullptr, pipefd[1], nullptr, std::min(len, chunk),
+                              SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (in < 0 && errno == EINTR) continue;
+        if (in < 0 && errno == EINVAL && first) return copyPayload(from, to, len);
+        if (in <= 0) return false;
+        first = false;
+        len -= static_cast<size_t>(in);
+
+        size_t pending = static_cast<size_t>(in);
+        while (pending > 0) {
+            ssize_t out = ::splice(pipefd[0], nullptr, to, nullptr, pending,
+                                   SPLICE_F_MOVE | (len > 0 ? SPLICE_F_MORE : 0));
+            if (out < 0 && errno == EINTR) continue;
+            if (out <= 0) return false;
+            pending -= static_cast<size_t>(out);
+        }
+    }
+    return true;
+}
+
+void RpcProxy::replyError(int client, const std::string& message) {
+    errors++;
+    rpc::sendFrame(client, "", message.data(), message.size(), rpc::kFlagError);
+}
+
+void RpcProxy::serve(int client) {
+    int pipefd[2] = {-1, -1};
+    size_t chunk = 64 * 1024;
+    if (::pipe2(pipefd, O_CLOEXEC) == 0) {
+        int sz = ::fcntl(pipefd[1], F_SETPIPE_SZ, kPipeSize);
+        if (sz > 0) chunk = static_cast<size_t>(sz);
+    }
+    std::unordered_map<std::string, int> backends;
+
+    while (running && pipefd[0] >= 0) {
+        uint8_t head[rpc::kHeaderSize + 255];
+        rpc::FrameHeader h;
+        if (!rpc::readFull(client, head, rpc::kHeaderSize) || !rpc::decodeHeader(head, h)) break;
+        std::string service(h.name_len, '\0');
+        if (!rpc::readFull(client, &service[0], h.name_len)) break;
+
+        auto it = backends.find(service);
+        if (it == backends.end()) {
+            std::string host;
+            int svc_port = 0;
+            int fd = -1;
+            if (!service.empty() && resolve(service, host, svc_port)) fd = rpc::connectTcp(host, svc_port);
+            if (fd < 0) {
+                if (!discardPayload(client, h.payload_len)) break;
+                replyError(client, service.empty() ? "no target service" : "service unavailable: " + service);
+                continue;
+            }
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &kBackendTimeout, sizeof(kBackendTimeout));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &kBackendTimeout, sizeof(kBackendTimeout));
+            {
+                std::lock_guard<std::mutex> lk(conn_mtx);
+                backend_fds.insert(fd);
+            }
+            it = backends.emplace(service, fd).first;
+        }
+        int backend = it->second;
+
+        // Forward the header without the name; the payload is spliced
+        rpc::FrameHeader fwd = h;
+        fwd.name_len = 0;
+        rpc::encodeHeader(fwd, head);
+        bool ok = rpc::writeFull(backend, head, rpc::kHeaderSize, h.payload_len > 0 ? MSG_MORE : 0) &&
+                  forward(client, backend, pipefd, h.payload_len, chunk);
+
+        rpc::FrameHeader reply;
+        ok = ok && rpc::readFull(backend, head, rpc::kHeaderSize) && rpc::decodeHeader(head, reply) &&
+             reply.name_len == 0;
+        ok = ok && rpc::writeFull(client, head, rpc::kHeaderSize, reply.payload_len > 0 ? MSG_MORE : 0) &&
+             forward(backend, client, pipefd, reply.payload_len, chunk);
+        if (!ok) {
+            // The client stream may be mid-frame; drop both connections
+            errors++;
+            log_warning("RPC proxy: forwarding to " + service + " failed");
+            break;
+        }
+        calls++;
+        bytes += h.payload_len + reply.payload_len;
+    }
+
+    if (pipefd[0] >= 0) ::close(pipefd[0]);
+    if (pipefd[1] >= 0) ::close(pipefd[1]);
+    std::lock_guard<std::mutex> lk(conn_mtx);
+    for (const auto& b : backends) {
+        backend_fds.erase(b.second);
+        ::close(b.second);
+    }
+    clients.erase(client);
+    ::close(client);
+    conn_cv.notify_all();
+}
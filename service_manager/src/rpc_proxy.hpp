@@ -0,0 +1,65 @@
+#ifndef RPC_PROXY_HPP
+#define RPC_PROXY_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+// RPC proxy of the Service Manager: clients address a service by name and the
+// manager forwards the call to the service's registered endpoint.
+//
+// Only the frame header and target name are read into userspace (see
+// common/include/rpc_frame.hpp). Payloads in both directions are moved
+// socket -> pipe -> socket with splice(2), so a proxied call costs two extra
+// syscalls per chunk instead of two copies of the payload. Backend
+// connections are kept per client connection and reused across calls.
+
+class RpcProxy {
+public:
+    // Resolve a service name to its endpoint; false if unknown or dead.
+    using Resolver = std::function<bool(const std::string& service, std::string& host, int& port)>;
+
+    struct Stats {
+        uint64_t calls;
+        uint64_t bytes;   // forwarded payload bytes, both directions
+        uint64_t errors;
+    };
+
+    RpcProxy(int port, Resolver resolve);
+    ~RpcProxy();
+
+    bool start();
+    void stop();
+
+    int boundPort() const { return bound_port; } // actual port when constructed with 0
+    Stats stats() const;
+
+private:
+    void acceptLoop();
+    void serve(int client);
+    bool forward(int from, int to, const int pipefd[2], size_t len, size_t chunk);
+    void replyError(int client, const std::string& message);
+
+    int port;
+    int bound_port = 0;
+    Resolver resolve;
+    int listen_fd = -1;
+    std::atomic_bool running{false};
+    std::thread acceptor;
+
+    std::mutex conn_mtx;             // live connections, shut down on stop()
+    std::condition_variable conn_cv;
+    std::unordered_set<int> clients;
+    std::unordered_set<int> backend_fds;
+
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+#endif // RPC_PROXY_HPP
@@ -0,0 +1,117 @@
+#include "topic_trie.hpp"
+#include <algorithm>
+
+namespace {
+
+// Split off the first segment of `rest`; `at_end` becomes true after the last one.
+std::string_view nextSegment(std::string_view& rest, bool& at_end) {
+    size_t slash = rest.find('/');
+    std::string_view segment = rest.substr(0, slash);
+    if (slash == std::string_view::npos) {
+        rest = std::string_view();
+        at_end = true;
+    } else {
+        rest.remove_prefix(slash + 1);
+    }
+    return segment;
+}
+
+} // namespace
+
+TopicTrie::TopicTrie() : root(std::make_unique<Node>()) {}
+
+TopicTrie::~TopicTrie() = default;
+
+TopicTrie::Node* TopicTrie::Node::child(std::string_view segment) const {
+    auto it = std::lower_bound(children.begin(), children.end(), segment,
+                               [](const auto& c, std::string_view s) { return c.first < s; });
+    return (it != children.end() && it->first == segment) ? it->second.get() : nullptr;
+}
+
+TopicTrie::Node* TopicTrie::Node::childOrCreate(std::string_view segment) {
+    if (segment == "+") {
+        if (!plus) plus = std::make_unique<Node>();
+        return plus.get();
+    }
+    if (segment == "#") {
+        if (!hash) hash = std::make_unique<Node>();
+        return hash.get();
+    }
+    auto it = std::lower_bound(children.begin(), children.end(), segment,
+                               [](const auto& c, std::string_view s) { return c.first < s; });
+    if (it == children.end() || it->first != segment) {
+        it = children.emplace(it, std::string(segment), std::make_unique<Node>());
+    }
+    return it->second.get();
+}
+
+bool TopicTrie::isValidPattern(std::string_view pattern) {
+    if (pattern.empty()) return false;
+    bool at_end = false;
+    while (!at_end) {
+        std::string_view segment = nextSegment(pattern, at_end);
+        if (segment == "#" && !at_end) return false;
+        if (segment.size() > 1 && segment.find_first_of("+#") != std::string_view::npos) return false;
+    }
+    return true;
+}
+
+bool TopicTrie::matches(std::string_view pattern, std::string_view topic) {
+    if (topic.empty()) return false;
+    bool pattern_end = false, topic_end = false;
+    while (!pattern_end) {
+        std::string_view p = nextSegment(pattern, pattern_end);
+        if (p == "#") return true;
+        if (topic_end) return false;
+        std::string_view t = nextSegment(topic, topic_end);
+        if (p != "+" && p != t) return false;
+    }
+    return topic_end;
+}
+
+bool TopicTrie::insert(std::string_view pattern, uint32_t id) {
+    if (!isValidPattern(pattern)) return false;
+    Node* node = root.get();
+    bool at_end = false;
+    while (!at_end) node = node->childOrCreate(nextSegment(pattern, at_end));
+    if (std::find(node->ids.begin(), node->ids.end(), id) == node->ids.end()) {
+        node->ids.push_back(id);
+        count++;
+    }
+    return true;
+}
+
+void TopicTrie::erase(std::string_view pattern, uint32_t id) {
+    if (!isValidPattern(pattern)) return;
+    Node* node = root.get();
+    bool at_end = false;
+    while (node && !at_end) {
+        std::string_view segment = nextSegment(pattern, at_end);
+        if (segment == "+") node = node->plus.get();
+        else if (segment == "#") node = node->hash.get();
+        else node = node->child(segment);
+    }
+    if (!node) return;
+    auto it = std::find(node->ids.begin(), node->ids.end(), id);
+    if (it != node->ids.end()) {
+        node->ids.erase(it);
+        count--;
+    }
+}
+
+void TopicTrie::match(std::string_view topic, std::vector<uint32_t>& out) const {
+    if (topic.empty()) return;
+    matchFrom(root.get(), topic, false, out);
+}
+
+void TopicTrie::matchFrom(const Node* node, std::string_view rest, bool at_end, std::vector<uint32_t>& out) const {
+    // '#' also matches the parent level itself ("climate/#" matches "climate")
+    if (node->hash) out.insert(out.end(), node->hash->ids.begin(), node->hash->ids.end());
+    if (at_end) {
+        out.insert(out.end(), node->ids.begin(), node->ids.end());
+        return;
+    }
+    std::string_view segment = nextSegment(rest, at_end);
+    if (const Node* literal = node->child(segment)) matchFrom(literal, rest, at_end, out);
+    if (node->plus) matchFrom(node->plus.get(), rest, at_end, out);
+}
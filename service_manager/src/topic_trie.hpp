@@ -0,0 +1,58 @@
+#ifndef TOPIC_TRIE_HPP
+#define TOPIC_TRIE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Trie of hierarchical topic patterns ("climate/temperature_update").
+//
+// Pattern segments are separated by '/'. Two wildcards are supported:
+//   '+'  matches exactly one segment     ("+/temperature_update")
+//   '#'  matches all remaining segments  ("climate/#", "#"); must be last
+//
+// Matching walks one trie level per topic segment and only visits the literal,
+// '+' and '#' children, so its cost depends on topic depth, not on the number
+// of subscriptions. match() does not allocate beyond growing `out`.
+
+class TopicTrie {
+public:
+    TopicTrie();
+    ~TopicTrie();
+
+    static bool isValidPattern(std::string_view pattern);
+
+    // Match a single pattern against a topic without building a trie.
+    static bool matches(std::string_view pattern, std::string_view topic);
+
+    // Returns false for invalid patterns.
+    bool insert(std::string_view pattern, uint32_t id);
+    void erase(std::string_view pattern, uint32_t id);
+
+    // Append the IDs of all patterns matching `topic` (may contain duplicates
+    // when an ID subscribed to several overlapping patterns).
+    void match(std::string_view topic, std::vector<uint32_t>& out) const;
+
+    size_t size() const { return count; }
+
+private:
+    struct Node {
+        std::vector<std::pair<std::string, std::unique_ptr<Node>>> children; // sorted by segment
+        std::unique_ptr<Node> plus;
+        std::unique_ptr<Node> hash;
+        std::vector<uint32_t> ids;
+
+        Node* child(std::string_view segment) const;
+        Node* childOrCreate(std::string_view segment);
+    };
+
+    void matchFrom(const Node* node, std::string_view rest, bool at_end, std::vector<uint32_t>& out) const;
+
+    std::unique_ptr<Node> root;
+    size_t count = 0;
+};
+
+#endif // TOPIC_TRIE_HPP
@@ -0,0 +1,108 @@
+#include "config_image.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+static void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::trunc);
+    out << text;
+}
+
+int main() {
+    log_info("Starting Config Image Tests");
+    const std::string json_path = "config_image_test_services.json";
+    const std::string image_path = "config_image_test_services.img";
+
+    // Test 1: Every service of a large manifest resolves through the perfect hash
+    {
+        const int kServices = 500;
+        std::string doc = R"({"services": [)";
+        for (int i = 0; i < kServices; ++i) {
+            doc += (i ? "," : "") + std::string(R"({"name": "Service)") + std::to_string(i) +
+                   R"(", "type": "T)" + std::to_string(i % 7) + R"(", "endpoint": "tcp://localhost:)" +
+                   std::to_string(6000 + i) + R"(", "ignored": {"x": [1, 2]}})";
+        }
+        doc += "]}";
+        writeFile(json_path, doc);
+        std::string error;
+        auto image = common::ConfigImage::compile(json_path, image_path, &error) ? common::ConfigImage::open(image_path)
+                                                                               : nullptr;
+        if (!image || image->size() != kServices) {
+            log_error("Perfect hash test FAILED: " + error);
+            return 1;
+        }
+        for (int i = 0; i < kServices; ++i) {
+            auto e = image->find("Service" + std::to_string(i));
+            if (!e || e->endpoint != "tcp://localhost:" + std::to_string(6000 + i) ||
+                e->type != "T" + std::to_string(i % 7) || image->at(i).name != "Service" + std::to_string(i)) {
+                log_error("Perfect hash test FAILED at Service" + std::to_string(i));
+                return 1;
+            }
+        }
+        if (image->find("Service500") || image->find("") || image->find("service1")) {
+            log_error("Perfect hash test FAILED: unknown name resolved");
+            return 1;
+        }
+        log_info("Perfect hash test PASSED");
+    }
+
+    // Test 2: Corrupt images are rejected; duplicates do not compile
+    {
+        {
+            std::fstream f(image_path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(100);
+            f.put('\x7f');
+        }
+        if (common::ConfigImage::open(image_path)) {
+            log_error("Validation test FAILED: corrupt image accepted");
+            return 1;
+        }
+        writeFile(json_path, R"({"services": [{"name": "A", "endpoint": "x"}, {"name": "A", "endpoint": "y"}]})");
+        std::string error;
+        if (common::ConfigImage::compile(json_path, image_path + ".dup", &error) ||
+            error.find("duplicate") == std::string::npos) {
+            log_error("Validation test FAILED: duplicate accepted");
+            return 1;
+        }
+        log_info("Validation test PASSED");
+    }
+
+    // Test 3: ServiceConfig uses the image, or the JSON when the image is stale or missing
+    {
+        writeFile(json_path, R"({"services": [{"name": "MediaService", "type": "Media", "endpoint": "tcp://a:1"}]})");
+        common::ConfigImage::compile(json_path, image_path);
+        {
+            common::ServiceConfig config(image_path, json_path);
+            auto e = config.find("MediaService");
+            if (!config.fromImage() || !e || e->endpoint != "tcp://a:1") {
+                log_error("Fallback test FAILED: image not used");
+                return 1;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        writeFile(json_path, R"({"services": [{"name": "MediaService", "type": "Media", "endpoint": "tcp://b:2"}]})");
+        {
+            common::ServiceConfig config(image_path, json_path);
+            auto e = config.find("MediaService");
+            if (config.fromImage() || !e || e->endpoint != "tcp://b:2") {
+                log_error("Fallback test FAILED: stale image used");
+                return 1;
+            }
+        }
+        std::remove(image_path.c_str());
+        {
+            common::ServiceConfig config(image_path, json_path);
+            if (config.fromImage() || !config.find("MediaService") || config.find("Other")) {
+                log_error("Fallback test FAILED: missing image");
+                return 1;
+            }
+        }
+        log_info("Fallback test PASSED");
+    }
+
+    std::remove(json_path.c_str());
+    std::remove(image_path.c_str());
+    log_info("All Config Image Tests PASSED");
+    return 0;
+}
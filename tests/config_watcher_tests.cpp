@@ -0,0 +1,158 @@
+#include "config_watcher.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+static void writeFile(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::trunc);
+    out << text;
+}
+
+// The way editors and config_compiler publish a file: write aside, rename over
+static void replaceFile(const std::string& path, const std::string& text) {
+    writeFile(path + ".tmp", text);
+    std::rename((path + ".tmp").c_str(), path.c_str());
+}
+
+static std::string manifest(const std::string& media_endpoint, bool with_nav = true) {
+    std::string doc = R"({"services": [
+        {"name": "MediaService", "type": "Media", "endpoint": ")" + media_endpoint + R"("},
+        {"name": "ClimateService", "type": "Climate", "endpoint": "tcp://localhost:5002"})";
+    if (with_nav) doc += R"(,
+        {"name": "NavigationService", "type": "Navigation", "endpoint": "tcp://localhost:5003"})";
+    return doc + "]}";
+}
+
+template <typename Pred>
+static bool waitFor(Pred pred) {
+    for (int i = 0; i < 500; ++i) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+int main() {
+    log_info("Starting Config Watcher Tests");
+    const std::string dir = "config_watcher_test";
+    const std::string path = dir + "/services.json";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    writeFile(path, manifest("tcp://localhost:5001"));
+
+    common::ConfigWatcher watcher(path, std::chrono::milliseconds(20));
+    std::mutex mtx;
+    std::map<std::string, int> calls;          // per-name notifications
+    std::map<std::string, std::string> seen;   // last endpoint, "" when removed
+    std::atomic<int> media_calls{0};
+    watcher.subscribeAll([&](const std::string& name, const common::ConfigWatcher::Entry& e) {
+        std::lock_guard<std::mutex> lk(mtx);
+        calls[name]++;
+        seen[name] = e ? e->endpoint : "";
+    });
+    watcher.subscribe("MediaService", [&](const std::string&, const common::ConfigWatcher::Entry&) {
+        media_calls++;
+    });
+    auto callsFor = [&](const std::string& name) {
+        std::lock_guard<std::mutex> lk(mtx);
+        return calls[name];
+    };
+
+    // Test 1: The initial load publishes every entry once
+    {
+        if (!watcher.start() || watcher.size() != 3 || media_calls != 1 || callsFor("ClimateService") != 1) {
+            log_error("Initial load test FAILED");
+            return 1;
+        }
+        auto media = watcher.find("MediaService");
+        if (!media || media->endpoint != "tcp://localhost:5001" || watcher.find("Unknown")) {
+            log_error("Initial load test FAILED: lookup");
+            return 1;
+        }
+        log_info("Initial load test PASSED");
+    }
+
+    // Test 2: Changing one endpoint touches only that entry
+    {
+        auto climate_before = watcher.find("ClimateService");
+        uint64_t version_before = watcher.version();
+        auto held = watcher.find("MediaService");
+        replaceFile(path, manifest("tcp://localhost:6001"));
+        bool changed = waitFor([&] { return media_calls == 2; });
+        auto media = watcher.find("MediaService");
+        if (!changed || !media || media->endpoint != "tcp://localhost:6001") {
+            log_error("Incremental apply test FAILED: change not applied");
+            return 1;
+        }
+        if (watcher.find("ClimateService") != climate_before || callsFor("ClimateService") != 1 ||
+            callsFor("NavigationService") != 1 || watcher.version() != version_before + 1) {
+            log_error("Incremental apply test FAILED: unchanged entries were republished");
+            return 1;
+        }
+        // Readers holding the old entry keep a valid copy
+        if (held->endpoint != "tcp://localhost:5001") {
+            log_error("Incremental apply test FAILED: held entry modified");
+            return 1;
+        }
+        log_info("Incremental apply test PASSED");
+    }
+
+    // Test 3: A broken manifest is rejected and the live entries stay
+    {
+        uint64_t version_before = watcher.version();
+        writeFile(path, R"({"services": [{"name": "MediaService", )");
+        bool rejected = waitFor([&] { return watcher.stats().rejected == 1; });
+        auto media = watcher.find("MediaService");
+        if (!rejected || watcher.version() != version_before || !media || media->endpoint != "tcp://localhost:6001") {
+            log_error("Invalid manifest test FAILED");
+            return 1;
+        }
+        log_info("Invalid manifest test PASSED");
+    }
+
+    // Test 4: In-place writes are seen too; removed services are announced with null
+    {
+        writeFile(path, manifest("tcp://localhost:6001", false));
+        bool removed = waitFor([&] { return callsFor("NavigationService") == 2; });
+        std::string last;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            last = seen["NavigationService"];
+        }
+        if (!removed || !last.empty() || watcher.find("NavigationService") || watcher.size() != 2 ||
+            media_calls != 2) {
+            log_error("Removal test FAILED");
+            return 1;
+        }
+        log_info("Removal test PASSED");
+    }
+
+    // Test 5: Unrelated files in the directory are ignored; stop() ends watching
+    {
+        uint64_t reloads = watcher.stats().reloads;
+        writeFile(dir + "/other.json", "{}");
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (watcher.stats().reloads != reloads) {
+            log_error("Unrelated file test FAILED");
+            return 1;
+        }
+        watcher.stop();
+        replaceFile(path, manifest("tcp://localhost:7001"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        if (watcher.find("MediaService")->endpoint != "tcp://localhost:6001") {
+            log_error("Stop test FAILED");
+            return 1;
+        }
+        log_info("Unrelated file test PASSED");
+    }
+
+    std::filesystem::remove_all(dir);
+    log_info("All Config Watcher Tests PASSED");
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "dependency_graph.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+// Availability per service reported in a batch of changes
+static std::map<std::string, bool> flips(const std::vector<DependencyGraph::Change>& changes) {
+    std::map<std::string, bool> out;
+    for (const auto& c : changes) out[c.service] = c.available;
+    return out;
+}
+
+int main() {
+    log_info("Starting Dependency Graph Tests");
+
+    // hmi -> media -> audio, hmi -> navigation, cluster -> navigation
+    DependencyGraph graph;
+    std::vector<DependencyGraph::Change> changes;
+    graph.setDependencies("media", {"audio"}, changes);
+    graph.setDependencies("hmi", {"media", "navigation", "media"}, changes);
+    graph.setDependencies("cluster", {"navigation"}, changes);
+    for (const char* s : {"hmi", "cluster", "media", "navigation"}) graph.setAlive(s, true, changes);
+
+    // Test 1: Dependencies that have not registered yet keep dependents unavailable
+    {
+        if (graph.available("hmi") || graph.available("media") || !graph.available("cluster")) {
+            log_error("Unregistered dependency test FAILED");
+            return 1;
+        }
+        changes.clear();
+        graph.setAlive("audio", true, changes);
+        auto f = flips(changes);
+        if (f != std::map<std::string, bool>{{"audio", true}, {"media", true}, {"hmi", true}}) {
+            log_error("Registration propagation test FAILED");
+            return 1;
+        }
+        log_info("Registration propagation test PASSED");
+    }
+
+    // Test 2: A death flips exactly the transitive dependents, with causes
+    {
+        changes.clear();
+        graph.setAlive("audio", false, changes);
+        auto f = flips(changes);
+        auto hmi = std::find_if(changes.begin(), changes.end(), [](const auto& c) { return c.service == "hmi"; });
+        if (f != std::map<std::string, bool>{{"audio", false}, {"media", false}, {"hmi", false}} ||
+            hmi == changes.end() || !hmi->alive || hmi->unavailable != std::vector<std::string>{"media"} ||
+            !graph.available("cluster")) {
+            log_error("Death propagation test FAILED");
+            return 1;
+        }
+
+        // A second failure below an already unavailable dependent changes nothing upstream
+        changes.clear();
+        graph.setAlive("navigation", false, changes);
+        f = flips(changes);
+        if (f != std::map<std::string, bool>{{"navigation", false}, {"cluster", false}}) {
+            log_error("Overlapping failure test FAILED");
+            return 1;
+        }
+
+        // hmi only recovers once both of its dependencies are back
+        changes.clear();
+        graph.setAlive("audio", true, changes);
+        f = flips(changes);
+        if (f != std::map<std::string, bool>{{"audio", true}, {"media", true}} || graph.available("hmi")) {
+            log_error("Partial recovery test FAILED");
+            return 1;
+        }
+        changes.clear();
+        graph.setAlive("navigation", true, changes);
+        f = flips(changes);
+        if (f != std::map<std::string, bool>{{"navigation", true}, {"cluster", true}, {"hmi", true}}) {
+            log_error("Recovery test FAILED");
+            return 1;
+        }
+        log_info("Death and recovery propagation test PASSED");
+    }
+
+    // Test 3: Cycles are rejected; deregistration looks like a failure to dependents
+    {
+        changes.clear();
+        if (graph.setDependencies("audio", {"hmi"}, changes) || !changes.empty() ||
+            !graph.dependencies("audio").empty()) {
+            log_error("Cycle rejection test FAILED");
+            return 1;
+        }
+        graph.remove("navigation", changes);
+        auto f = flips(changes);
+        if (f != std::map<std::string, bool>{{"navigation", false}, {"cluster", false}, {"hmi", false}} ||
+            graph.dependents("navigation") != std::vector<std::string>{"cluster", "hmi"}) {
+            log_error("Deregistration propagation test FAILED");
+            return 1;
+        }
+        log_info("Cycle and deregistration test PASSED");
+    }
+
+    log_info("All dependency graph tests PASSED");
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Benchmark: Persistence::saveState latency and throughput under each
+// durability mode, for a growing number of concurrent writers. Not part of
+// ctest; run manually (in the directory whose filesystem is of interest):
+//   ./tests/durability_bench [saves_per_writer]
+#include "durability.hpp"
+#include "persistence.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+struct Result {
+    double saves_per_sec;
+    double p50_us;
+    double p99_us;
+    uint64_t syncs;
+};
+
+static Result run(int writers, int saves) {
+    auto& manager = common::DurabilityManager::instance();
+    auto before = manager.stats();
+    std::mutex mtx;
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(writers) * saves);
+
+    auto t0 = Clock::now();
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w]() {
+            const std::string file = "durability_bench_" + std::to_string(w) + ".json";
+            nlohmann::json state{{"writer", w}, {"track", "Track"}, {"volume", 0}, {"position_ms", 0}};
+            std::vector<double> local;
+            for (int i = 0; i < saves; ++i) {
+                state["volume"] = i % 100;
+                state["position_ms"] = i * 250;
+                auto s0 = Clock::now();
+                Persistence::saveState(file, state);
+                local.push_back(std::chrono::duration<double, std::micro>(Clock::now() - s0).count());
+            }
+            std::lock_guard<std::mutex> lk(mtx);
+            samples.insert(samples.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    std::sort(samples.begin(), samples.end());
+    Result r;
+    r.saves_per_sec = samples.size() / secs;
+    r.p50_us = samples[samples.size() / 2];
+    r.p99_us = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    r.syncs = manager.stats().syncs - before.syncs;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int saves = argc > 1 ? std::atoi(argv[1]) : 200;
+    struct Mode {
+        const char* name;
+        common::DurabilityOptions options;
+    };
+    const Mode modes[] = {
+        {"none", {common::Durability::None, 1000ms, 0us}},
+        {"periodic", {common::Durability::Periodic, 1000ms, 0us}},
+        {"group-0us", {common::Durability::GroupCommit, 1000ms, 0us}},
+        {"group-1ms", {common::Durability::GroupCommit, 1000ms, 1000us}},
+    };
+
+    std::cout << std::setw(12) << "mode" << std::setw(9) << "writers" << std::setw(14) << "saves/s"
+              << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(10) << "syncs" << std::endl;
+    for (const Mode& mode : modes) {
+        Persistence::setDurability(mode.options);
+        for (int writers : {1, 4, 16}) {
+            Result r = run(writers, saves);
+            std::cout << std::setw(12) << mode.name << std::setw(9) << writers << std::setw(14) << std::fixed
+                      << std::setprecision(0) << r.saves_per_sec << std::setw(12) << std::setprecision(1)
+                      << r.p50_us << std::setw(12) << r.p99_us << std::setw(10) << r.syncs << std::endl;
+        }
+    }
+    Persistence::setDurability({});
+
+    for (int w = 0; w < 16; ++w) std::remove(("durability_bench_" + std::to_string(w) + ".json").c_str());
+    return 0;
+}
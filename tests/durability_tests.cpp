@@ -0,0 +1,144 @@
+#include "durability.hpp"
+#include "persistence.hpp"
+#include "state_journal.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using namespace std::chrono_literals;
+
+static std::string fileFor(int i) {
+    return "durability_test_" + std::to_string(i) + ".json";
+}
+
+int main() {
+    log_info("Starting Durability Tests");
+    auto& manager = common::DurabilityManager::instance();
+    const int kThreads = 8;
+    for (int i = 0; i < kThreads; ++i) std::remove(fileFor(i).c_str());
+
+    // Test 1: None replaces the file without syncing
+    {
+        Persistence::saveState(fileFor(0), json{{"n", 1}});
+        auto s = manager.stats();
+        if (s.syncs != 0 || Persistence::loadState(fileFor(0)).value("n", 0) != 1) {
+            log_error("No-sync mode test FAILED");
+            return 1;
+        }
+        log_info("No-sync mode test PASSED");
+    }
+
+    // Test 2: Concurrent saves share the syncs of a group commit
+    {
+        Persistence::setDurability({common::Durability::GroupCommit, 1000ms, 5000us});
+        auto before = manager.stats();
+        std::vector<std::thread> writers;
+        for (int i = 0; i < kThreads; ++i) {
+            writers.emplace_back([i]() {
+                for (int n = 1; n <= 5; ++n) Persistence::saveState(fileFor(i), json{{"n", n}, {"writer", i}});
+            });
+        }
+        for (auto& t : writers) t.join();
+        auto after = manager.stats();
+        uint64_t commits = after.commits - before.commits;
+        uint64_t syncs = after.syncs - before.syncs;
+        for (int i = 0; i < kThreads; ++i) {
+            json j = Persistence::loadState(fileFor(i));
+            if (j.value("n", 0) != 5 || j.value("writer", -1) != i) {
+                log_error("Group commit test FAILED: wrong content in " + fileFor(i));
+                return 1;
+            }
+        }
+        // Two syncs per batch; unbatched commits would need 2 per save
+        if (commits != 5 * kThreads || syncs == 0 || syncs >= 2 * commits) {
+            log_error("Group commit test FAILED: " + std::to_string(syncs) + " syncs for " +
+                      std::to_string(commits) + " commits");
+            return 1;
+        }
+        log_info("Group commit test PASSED (" + std::to_string(syncs) + " syncs for " + std::to_string(commits) +
+                 " commits)");
+    }
+
+    // Test 3: Concurrent saves of one file never publish a torn file
+    {
+        const std::string path = "durability_test_shared.json";
+        Persistence::saveState(path, json{{"n", 0}, {"writer", 0}});
+        std::atomic_bool saving{true};
+        std::atomic<int> torn{0};
+        std::thread reader([&]() {
+            while (saving) {
+                if (!Persistence::loadState(path).is_object()) torn++;
+            }
+        });
+        std::vector<std::thread> writers;
+        for (int i = 0; i < kThreads; ++i) {
+            writers.emplace_back([&path, i]() {
+                std::string pad(256 * 1024, 'a' + static_cast<char>(i));
+                for (int n = 1; n <= 20; ++n) Persistence::saveState(path, json{{"n", n}, {"writer", i}, {"pad", pad}});
+            });
+        }
+        for (auto& t : writers) t.join();
+        saving = false;
+        reader.join();
+        bool leftovers = false;
+        for (const auto& entry : std::filesystem::directory_iterator(".")) {
+            leftovers |= entry.path().filename().string().rfind(path + ".tmp", 0) == 0;
+        }
+        if (torn != 0 || Persistence::loadState(path).value("n", 0) != 20 || leftovers) {
+            log_error("Shared file test FAILED: " + std::to_string(torn.load()) + " torn reads" +
+                      (leftovers ? ", temp files left" : ""));
+            return 1;
+        }
+        std::remove(path.c_str());
+        log_info("Shared file test PASSED");
+    }
+
+    // Test 4: Journal appends commit too
+    {
+        const std::string path = "durability_test_journal.json";
+        std::remove((path + ".journal").c_str());
+        auto before = manager.stats();
+        {
+            common::StateJournal journal(path);
+            journal.recover();
+            if (!journal.put("volume", 7)) {
+                log_error("Journal commit test FAILED: put");
+                return 1;
+            }
+        }
+        if (manager.stats().commits == before.commits || manager.stats().syncs == before.syncs) {
+            log_error("Journal commit test FAILED: append was not committed");
+            return 1;
+        }
+        std::remove((path + ".journal").c_str());
+        std::remove((path + ".journal.old").c_str());
+        std::remove((path + ".img").c_str());
+        log_info("Journal commit test PASSED");
+    }
+
+    // Test 5: Periodic returns at once and syncs in the background
+    {
+        Persistence::setDurability({common::Durability::Periodic, 50ms, 0us});
+        auto before = manager.stats();
+        Persistence::saveState(fileFor(0), json{{"n", 6}});
+        if (manager.stats().syncs != before.syncs) {
+            log_error("Periodic mode test FAILED: save synced inline");
+            return 1;
+        }
+        std::this_thread::sleep_for(200ms);
+        if (manager.stats().syncs == before.syncs || Persistence::loadState(fileFor(0)).value("n", 0) != 6) {
+            log_error("Periodic mode test FAILED: no background sync");
+            return 1;
+        }
+        Persistence::setDurability({});
+        log_info("Periodic mode test PASSED");
+    }
+
+    for (int i = 0; i < kThreads; ++i) std::remove(fileFor(i).c_str());
+    log_info("All Durability Tests PASSED");
+    return 0;
+}
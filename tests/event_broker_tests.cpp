@@ -0,0 +1,168 @@
+#include "event_broker.hpp"
+#include "logging.hpp"
+#include <arpa/inet.h>
+#include <chrono>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+// A subscriber endpoint: a UDP socket on an ephemeral loopback port
+struct Receiver {
+    int fd = -1;
+    int port = 0;
+
+    Receiver() {
+        fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+        port = ntohs(addr.sin_port);
+    }
+    ~Receiver() { ::close(fd); }
+
+    // Envelopes received until `expected` arrived (or 2 s passed), plus any
+    // that follow within `settle`
+    std::vector<json> receive(size_t expected, std::chrono::milliseconds settle = std::chrono::milliseconds(100)) {
+        std::vector<json> out;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        bool settling = false;
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            if (!settling && out.size() >= expected) {
+                settling = true;
+                deadline = now + settle;
+            }
+            if (now >= deadline) break;
+            pollfd pfd{fd, POLLIN, 0};
+            int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+            if (::poll(&pfd, 1, ms) <= 0) break;
+            char buf[2048];
+            ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n > 0) out.push_back(json::parse(std::string(buf, static_cast<size_t>(n)), nullptr, false));
+        }
+        return out;
+    }
+};
+
+static json event(const std::string& key, double value) {
+    return json{{"key", key}, {"value", value}};
+}
+
+// Value of the received event with `key`, or -1
+static double valueOf(const std::vector<json>& envelopes, const std::string& key) {
+    for (const auto& e : envelopes) {
+        if (e.is_object() && e["event"].value("key", "") == key) return e["event"].value("value", -1.0);
+    }
+    return -1.0;
+}
+
+int main() {
+    log_info("Starting Event Broker Tests");
+    EventBroker broker;
+    broker.start();
+
+    // Test 1: A new subscriber gets the last value per (topic, key), then live events
+    Receiver hmi;
+    {
+        broker.publish("climate/temperature", event("cabin", 20));
+        broker.publish("climate/temperature", event("cabin", 21));
+        broker.publish("climate/temperature", event("rear", 18));
+        broker.publish("media/track_update", json{{"track", "A"}});
+        if (broker.cachedValues() != 3) {
+            log_error("Last value cache test FAILED: " + std::to_string(broker.cachedValues()) + " cached");
+            return 1;
+        }
+        broker.subscribe("127.0.0.1", hmi.port, {"climate/#"});
+        auto replayed = hmi.receive(2);
+        if (replayed.size() != 2 || valueOf(replayed, "cabin") != 21 || valueOf(replayed, "rear") != 18) {
+            log_error("Last value replay test FAILED: received " + std::to_string(replayed.size()));
+            return 1;
+        }
+        size_t recipients = broker.publish("climate/temperature", event("cabin", 22));
+        auto live = hmi.receive(1);
+        if (recipients != 1 || live.size() != 1 || live[0].value("topic", "") != "climate/temperature" ||
+            valueOf(live, "cabin") != 22) {
+            log_error("Live delivery test FAILED");
+            return 1;
+        }
+        log_info("Last value replay test PASSED");
+    }
+
+    // Test 2: replay_last=false subscribes to the live stream only
+    Receiver logger;
+    {
+        SubscribeOptions opts;
+        opts.replay_last = false;
+        broker.subscribe("127.0.0.1", logger.port, {"climate/temperature"}, opts);
+        if (!logger.receive(0, std::chrono::milliseconds(200)).empty()) {
+            log_error("Live-only subscription test FAILED: cached values replayed");
+            return 1;
+        }
+        size_t recipients = broker.publish("climate/temperature", event("rear", 19));
+        if (recipients != 2 || valueOf(logger.receive(1), "rear") != 19 || valueOf(hmi.receive(1), "rear") != 19) {
+            log_error("Live-only subscription test FAILED: live event missing");
+            return 1;
+        }
+        log_info("Live-only subscription test PASSED");
+    }
+
+    // Test 3: The cache is capped; known keys are still overwritten past the cap
+    {
+        for (int i = 0; broker.cachedValues() < 4096 && i < 5000; ++i) {
+            broker.publish("bulk/item", event("item" + std::to_string(i), i));
+        }
+        broker.publish("bulk/item", event("overflow", 1));
+        broker.publish("climate/temperature", event("cabin", 23));
+        broker.publish("climate/temperature", event("front", 17));
+        if (broker.cachedValues() != 4096) {
+            log_error("Cache cap test FAILED: " + std::to_string(broker.cachedValues()) + " cached");
+            return 1;
+        }
+        hmi.receive(2); // live copies of the two climate events
+        logger.receive(2);
+        Receiver late;
+        broker.subscribe("127.0.0.1", late.port, {"climate/temperature"});
+        auto replayed = late.receive(2);
+        if (replayed.size() != 2 || valueOf(replayed, "cabin") != 23 || valueOf(replayed, "rear") != 19) {
+            log_error("Cache cap test FAILED: replayed " + std::to_string(replayed.size()) + " values");
+            return 1;
+        }
+        log_info("Cache cap test PASSED");
+    }
+
+    // Test 4: Content filters are applied before fan-out
+    {
+        Receiver display;
+        std::string error;
+        SubscribeOptions opts;
+        opts.replay_last = false;
+        opts.filter = EventFilter::compile(json{{"field", "value"}, {"op", "delta_gt"}, {"value", 0.5}}, error);
+        broker.subscribe("127.0.0.1", display.port, {"climate/temperature"}, opts);
+        broker.unsubscribe("127.0.0.1", hmi.port, {});
+        broker.unsubscribe("127.0.0.1", logger.port, {});
+
+        uint64_t filtered = broker.filtered();
+        std::vector<double> sent = {30.0, 30.2, 30.4, 31.0};
+        std::vector<size_t> recipients;
+        for (double v : sent) recipients.push_back(broker.publish("climate/temperature", event("cabin", v)));
+        auto got = display.receive(2);
+        // The late subscriber of test 3 is unfiltered and gets all four
+        if (!opts.filter || recipients != std::vector<size_t>{2, 1, 1, 2} || got.size() != 2 ||
+            got[0]["event"].value("value", 0.0) != 30.0 || got[1]["event"].value("value", 0.0) != 31.0 ||
+            broker.filtered() != filtered + 2) {
+            log_error("Filter test FAILED: " + std::to_string(got.size()) + " delivered");
+            return 1;
+        }
+        log_info("Filter test PASSED");
+    }
+
+    broker.stop();
+    log_info("All Event Broker Tests PASSED");
+    return 0;
+}
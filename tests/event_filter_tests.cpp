@@ -0,0 +1,67 @@
+#include "event_filter.hpp"
+#include "logging.hpp"
+#include <iostream>
+
+using json = nlohmann::json;
+
+int main() {
+    log_info("Starting Event Filter Tests");
+
+    // Test 1: delta_gt compares against the last delivered value, not the last event
+    {
+        std::string error;
+        auto f = EventFilter::compile(json::parse(R"({"field":"current_temperature","op":"delta_gt","value":1})"), error);
+        bool ok = f &&
+            f->accept("climate", {{"current_temperature", 20}}) &&     // first event passes
+            !f->accept("climate", {{"current_temperature", 20.5}}) &&
+            !f->accept("climate", {{"current_temperature", 21}}) &&
+            f->accept("climate", {{"current_temperature", 21.5}}) &&   // drift past threshold
+            f->accept("other", {{"current_temperature", 21.5}});       // streams are independent
+        if (!ok) {
+            log_error("Delta filter test FAILED");
+            return 1;
+        }
+        log_info("Delta filter test PASSED");
+    }
+
+    // Test 2: Conjunction of changed, eq and range; missing fields never match
+    {
+        std::string error;
+        auto f = EventFilter::compile(json::parse(R"([
+            {"field":"fan_speed","op":"changed"},
+            {"field":"mode","op":"eq","value":"cool"},
+            {"field":"state.temp","op":"range","min":16,"max":28}])"), error);
+        auto ev = [](int fan, const std::string& mode, double temp) {
+            return json{{"fan_speed", fan}, {"mode", mode}, {"state", {{"temp", temp}}}};
+        };
+        bool ok = f &&
+            f->accept("s", ev(1, "cool", 20)) &&
+            !f->accept("s", ev(1, "cool", 20)) &&        // unchanged
+            !f->accept("s", ev(2, "heat", 20)) &&        // wrong mode; not delivered...
+            f->accept("s", ev(2, "cool", 20)) &&         // ...so fan 2 is still a change
+            !f->accept("s", ev(3, "cool", 30)) &&        // out of range
+            !f->accept("s", json{{"mode", "cool"}});
+        if (!ok) {
+            log_error("Combined filter test FAILED");
+            return 1;
+        }
+        log_info("Combined filter test PASSED");
+    }
+
+    // Test 3: Malformed specs are rejected with a reason
+    {
+        std::string error;
+        bool rejected = !EventFilter::compile(json::parse(R"({"field":"x","op":"like"})"), error) &&
+                        !EventFilter::compile(json::parse(R"({"field":"x","op":"delta_gt"})"), error) &&
+                        !EventFilter::compile(json::parse(R"({"field":"x","op":"range"})"), error) &&
+                        !EventFilter::compile(json::array(), error) && !error.empty();
+        if (!rejected) {
+            log_error("Filter validation test FAILED");
+            return 1;
+        }
+        log_info("Filter validation test PASSED");
+    }
+
+    log_info("All event filter tests PASSED");
+    return 0;
+}
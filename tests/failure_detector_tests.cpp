@@ -0,0 +1,86 @@
+#include "failure_detector.hpp"
+#include "logging.hpp"
+#include <iostream>
+
+using namespace std::chrono;
+using clock_type = PhiAccrualDetector::clock;
+
+int main() {
+    log_info("Starting Failure Detector Tests");
+
+    // Test 1: Steady 100 ms heartbeats - on-time is trusted, a 500 ms gap is not
+    {
+        PhiAccrualDetector d;
+        auto t = clock_type::time_point{} + seconds(1);
+        for (int i = 0; i < 50; ++i, t += milliseconds(100)) d.heartbeat(t);
+        t -= milliseconds(100);
+
+        double on_time = d.phi(t + milliseconds(100));
+        double late = d.phi(t + milliseconds(500));
+        if (!d.hasHistory() || on_time > 1.0 || late < 8.0) {
+            log_error("Steady heartbeat phi test FAILED");
+            return 1;
+        }
+        log_info("Steady heartbeat phi test PASSED");
+    }
+
+    // Test 2: Jittery heartbeats are suspected later than steady ones
+    {
+        PhiAccrualDetector steady, jittery;
+        auto t1 = clock_type::time_point{} + seconds(1);
+        auto t2 = t1;
+        for (int i = 0; i < 64; ++i) {
+            steady.heartbeat(t1);
+            jittery.heartbeat(t2);
+            t1 += milliseconds(100);
+            t2 += milliseconds((i % 2) ? 40 : 160);
+        }
+        t1 -= milliseconds(100);
+        t2 -= milliseconds(40);
+
+        if (jittery.phi(t2 + milliseconds(400)) >= steady.phi(t1 + milliseconds(400))) {
+            log_error("Jitter adaptation test FAILED");
+            return 1;
+        }
+        log_info("Jitter adaptation test PASSED");
+    }
+
+    // Test 3: No verdict without history, reset forgets it
+    {
+        PhiAccrualDetector d;
+        auto t = clock_type::time_point{} + seconds(1);
+        d.heartbeat(t);
+        d.heartbeat(t + milliseconds(100));
+        bool no_history = !d.hasHistory() && d.phi(t + seconds(60)) == 0.0;
+        for (int i = 2; i < 10; ++i) d.heartbeat(t + milliseconds(100 * i));
+        d.reset();
+        if (!no_history || d.hasHistory()) {
+            log_error("History test FAILED");
+            return 1;
+        }
+        log_info("History test PASSED");
+    }
+
+    // Test 4: One lost beat or a short stall is not suspicious; a silence is
+    {
+        const double kPhiSuspect = 3.0; // as in service_manager/src/main.cpp
+        const double kPhiDead = 8.0;
+        PhiAccrualDetector d;
+        auto t = clock_type::time_point{} + seconds(1);
+        for (int i = 0; i < 64; ++i, t += milliseconds(100)) d.heartbeat(t);
+        t -= milliseconds(100);
+
+        double one_lost = d.phi(t + milliseconds(210));
+        double stalled = d.phi(t + milliseconds(260));
+        double silent = d.phi(t + seconds(1));
+        if (one_lost >= kPhiSuspect || stalled >= kPhiSuspect || silent <= kPhiDead) {
+            log_error("Acceptable pause test FAILED: phi " + std::to_string(one_lost) + ", " +
+                      std::to_string(stalled) + ", " + std::to_string(silent));
+            return 1;
+        }
+        log_info("Acceptable pause test PASSED");
+    }
+
+    log_info("All failure detector tests completed successfully");
+    return 0;
+}
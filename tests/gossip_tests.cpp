@@ -0,0 +1,185 @@
+#include "gossip.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Replica of the registry as seen by one node's change handler
+struct Replica {
+    std::mutex mtx;
+    std::map<std::string, GossipEntry> entries;
+
+    void apply(const std::vector<GossipEntry>& changes) {
+        std::lock_guard<std::mutex> lk(mtx);
+        for (const auto& e : changes) {
+            if (e.deleted) entries.erase(e.name);
+            else entries[e.name] = e;
+        }
+    }
+
+    bool has(const std::string& name, bool alive = true) {
+        std::lock_guard<std::mutex> lk(mtx);
+        auto it = entries.find(name);
+        return it != entries.end() && it->second.alive == alive;
+    }
+
+    bool lacks(const std::string& name) {
+        std::lock_guard<std::mutex> lk(mtx);
+        return entries.count(name) == 0;
+    }
+};
+
+template <typename F>
+static bool eventually(F&& cond, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (cond()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return cond();
+}
+
+static GossipEntry service(const std::string& name, uint64_t version, int port) {
+    GossipEntry e;
+    e.name = name;
+    e.host = "127.0.0.1";
+    e.port = port;
+    e.status = "alive";
+    e.alive = true;
+    e.version = version;
+    return e;
+}
+
+int main() {
+    log_info("Starting Gossip Tests");
+    Replica ra, rb, rc;
+    auto handler = [](Replica& r) { return [&r](const std::vector<GossipEntry>& c) { r.apply(c); }; };
+
+    // Line topology a - b - c: c only learns a's services through b
+    auto a = std::make_unique<GossipNode>("a", 47110, std::vector<std::string>{"127.0.0.1:47111"}, handler(ra));
+    GossipNode b("b", 47111, {"127.0.0.1:47110", "127.0.0.1:47112"}, handler(rb));
+    GossipNode c("c", 47112, {"127.0.0.1:47111"}, handler(rc));
+    if (!a->start() || !b.start() || !c.start()) {
+        log_error("Gossip start test FAILED");
+        return 1;
+    }
+
+    // Test 1: Local changes replicate to all nodes, transitively
+    {
+        a->updateLocal(service("media", 1, 5001));
+        c.updateLocal(service("climate", 1, 5003));
+        bool ok = eventually([&]() { return rb.has("media") && rc.has("media") && ra.has("climate"); });
+        if (!ok || !ra.lacks("media")) {
+            log_error("Gossip replication test FAILED");
+            return 1;
+        }
+        log_info("Gossip replication test PASSED");
+    }
+
+    // Test 2: Tombstones replicate removals
+    {
+        GossipEntry gone = service("media", 2, 5001);
+        gone.deleted = true;
+        a->updateLocal(gone);
+        if (!eventually([&]() { return rb.lacks("media") && rc.lacks("media"); })) {
+            log_error("Gossip removal test FAILED");
+            return 1;
+        }
+        log_info("Gossip removal test PASSED");
+    }
+
+    // Test 3: A silent peer's services are reported dead; a restarted node's
+    // new incarnation supersedes its old state
+    {
+        a->updateLocal(service("navigation", 3, 5002));
+        if (!eventually([&]() { return rc.has("navigation"); })) {
+            log_error("Gossip setup for peer failure test FAILED");
+            return 1;
+        }
+        a.reset();
+        if (!eventually([&]() { return rb.has("navigation", false); })) {
+            log_error("Gossip peer failure test FAILED");
+            return 1;
+        }
+
+        a = std::make_unique<GossipNode>("a", 47110, std::vector<std::string>{"127.0.0.1:47111"}, handler(ra));
+        a->start();
+        a->updateLocal(service("media", 1, 5011));
+        bool ok = eventually([&]() {
+            return rb.has("media") && rc.has("media") && rb.lacks("navigation") && rc.lacks("navigation");
+        });
+        if (!ok) {
+            log_error("Gossip incarnation test FAILED");
+            return 1;
+        }
+        log_info("Gossip peer failure and restart test PASSED");
+    }
+
+    // Test 4: Local changes handed over out of version order are still pushed,
+    // also when a push of the newer version happened in between
+    {
+        a->updateLocal(service("seat", 13, 5013));
+        if (!eventually([&]() { return rb.has("seat"); })) {
+            log_error("Gossip setup for out-of-order test FAILED");
+            return 1;
+        }
+        a->updateLocal(service("mirror", 12, 5012));
+        a->updateLocal({service("lights", 15, 5015), service("horn", 14, 5014)});
+        bool ok = eventually([&]() {
+            return rb.has("mirror") && rc.has("mirror") && rb.has("horn") && rc.has("lights");
+        });
+        if (!ok) {
+            log_error("Gossip out-of-order update test FAILED");
+            return 1;
+        }
+        log_info("Gossip out-of-order update test PASSED");
+    }
+
+    // Test 5: In a full mesh whose nodes have more peers than fit in
+    // PEER_TIMEOUT / GOSSIP_INTERVAL, quiet but healthy nodes stay reachable
+    {
+        const int n = 7;
+        std::atomic<int> dead_reports{0};
+        std::vector<std::unique_ptr<GossipNode>> mesh;
+        for (int i = 0; i < n; ++i) {
+            std::vector<std::string> peers;
+            for (int j = 0; j < n; ++j) {
+                if (j != i) peers.push_back("127.0.0.1:" + std::to_string(47120 + j));
+            }
+            mesh.push_back(std::make_unique<GossipNode>(
+                "m" + std::to_string(i), 47120 + i, peers, [&](const std::vector<GossipEntry>& changes) {
+                    for (const auto& e : changes) {
+                        if (!e.alive && !e.deleted) ++dead_reports;
+                    }
+                }));
+            if (!mesh.back()->start()) {
+                log_error("Gossip mesh start test FAILED");
+                return 1;
+            }
+        }
+        for (int i = 0; i < n; ++i) mesh[i]->updateLocal(service("svc" + std::to_string(i), 1, 6000 + i));
+        bool converged = eventually([&]() {
+            for (const auto& node : mesh) {
+                if (node->versionVector().size() != n) return false;
+            }
+            return true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(4500));
+        bool reachable = true;
+        for (const auto& node : mesh) {
+            for (const auto& o : node->versionVector()) reachable &= o.reachable;
+        }
+        if (!converged || !reachable || dead_reports != 0) {
+            log_error("Gossip mesh liveness test FAILED");
+            return 1;
+        }
+        log_info("Gossip mesh liveness test PASSED");
+    }
+
+    log_info("All gossip tests PASSED");
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "heartbeat.hpp"
+#include "logging.hpp"
+#include <array>
+#include <iostream>
+
+using namespace common::heartbeat;
+
+int main() {
+    log_info("Starting Heartbeat Tests");
+
+    // Test 1: Batched frame round trip
+    {
+        Entry in[3] = {
+            {instanceId("media"), 1, 10},
+            {instanceId("climate"), 0xfffffffe, 0},
+            {0xdeadbeef, 7, 65535},
+        };
+        std::array<uint8_t, kMaxFrameSize> buf{};
+        size_t len = encode(in, 3, buf.data(), buf.size());
+        if (len != kHeaderSize + 3 * kEntrySize) {
+            log_error("Heartbeat encode test FAILED");
+            return 1;
+        }
+
+        size_t i = 0;
+        bool match = true;
+        size_t count = decode(buf.data(), len, [&](const Entry& e) {
+            match = match && e.instance_id == in[i].instance_id &&
+                    e.sequence == in[i].sequence && e.load == in[i].load;
+            i++;
+        });
+        if (count != 3 || i != 3 || !match) {
+            log_error("Heartbeat decode test FAILED");
+            return 1;
+        }
+        log_info("Heartbeat round trip test PASSED");
+    }
+
+    // Test 2: Malformed frames are rejected
+    {
+        Entry in[2] = {{1, 1, 1}, {2, 2, 2}};
+        std::array<uint8_t, kMaxFrameSize> buf{};
+        size_t len = encode(in, 2, buf.data(), buf.size());
+        auto ignore = [](const Entry&) {};
+
+        bool truncated = decode(buf.data(), len - 1, ignore) == 0;
+        buf[0] ^= 0xff;
+        bool bad_magic = decode(buf.data(), len, ignore) == 0;
+        bool too_small = encode(in, 2, buf.data(), kHeaderSize + kEntrySize) == 0;
+        if (!truncated || !bad_magic || !too_small) {
+            log_error("Heartbeat malformed frame test FAILED");
+            return 1;
+        }
+        log_info("Heartbeat malformed frame test PASSED");
+    }
+
+    log_info("All heartbeat tests completed successfully");
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "key_value_storage.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using common::per::KeyValueStorage;
+
+int main() {
+    log_info("Starting Key-Value Storage Tests");
+    const std::string path = "kvs_test.db";
+    std::remove(path.c_str());
+
+    // Test 1: Typed values are visible at once and persisted by SyncToStorage
+    {
+        {
+            KeyValueStorage kvs(path);
+            kvs.SetValue("volume", 42);
+            kvs.SetValue("track", std::string("Intro"));
+            kvs.SetValue("presets", std::vector<int>{88, 101, 104});
+            if (kvs.GetValue<int>("volume") != 42 || kvs.GetValue<std::string>("volume") ||
+                kvs.GetValue<int>("missing") || kvs.fileBytes() != 0 || !kvs.SyncToStorage()) {
+                log_error("Typed value test FAILED");
+                return 1;
+            }
+            kvs.SetValue("volume", 7);
+            kvs.DiscardPendingChanges();
+        }
+        KeyValueStorage kvs(path);
+        auto presets = kvs.GetValue<std::vector<int>>("presets");
+        if (kvs.GetValue<int>("volume") != 42 || kvs.GetValue<std::string>("track") != "Intro" || !presets ||
+            presets->size() != 3 || kvs.GetAllKeys() != std::vector<std::string>{"presets", "track", "volume"}) {
+            log_error("Persisted value test FAILED");
+            return 1;
+        }
+        log_info("Typed value test PASSED");
+    }
+
+    // Test 2: Updating one key appends only that key; large values load lazily
+    {
+        {
+            KeyValueStorage kvs(path);
+            kvs.SetValue("playlist", std::vector<std::string>(2000, "Some Song Title"));
+            kvs.SyncToStorage();
+            size_t before = kvs.fileBytes();
+            kvs.SetValue("volume", 43);
+            kvs.SyncToStorage();
+            if (kvs.fileBytes() - before > 32) {
+                log_error("Incremental update test FAILED: " + std::to_string(kvs.fileBytes() - before) + " bytes");
+                return 1;
+            }
+            kvs.RemoveKey("track");
+            kvs.SyncToStorage();
+        }
+        KeyValueStorage kvs(path);
+        auto playlist = kvs.GetValue<std::vector<std::string>>("playlist");
+        if (!playlist || playlist->size() != 2000 || kvs.GetValue<int>("volume") != 43 || kvs.KeyExists("track")) {
+            log_error("Lazy load and removal test FAILED");
+            return 1;
+        }
+        log_info("Incremental update test PASSED");
+    }
+
+    // Test 3: Superseded records are compacted away; a torn tail is dropped
+    {
+        {
+            KeyValueStorage kvs(path, {4 * 1024, 64 * 1024});
+            for (int i = 0; i < 20000; ++i) {
+                kvs.SetValue("odometer", i);
+                kvs.SyncToStorage();
+            }
+            if (kvs.fileBytes() > 128 * 1024) {
+                log_error("Compaction test FAILED: " + std::to_string(kvs.fileBytes()) + " bytes");
+                return 1;
+            }
+        }
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::app);
+            out.write("\x01\x02\x03\x04\x05\x06\x07", 7);
+        }
+        KeyValueStorage kvs(path);
+        auto playlist = kvs.GetValue<std::vector<std::string>>("playlist");
+        if (kvs.GetValue<int>("odometer") != 19999 || !playlist || playlist->size() != 2000 ||
+            kvs.GetValue<int>("volume") != 43) {
+            log_error("Recovery after compaction test FAILED");
+            return 1;
+        }
+        log_info("Compaction and recovery test PASSED");
+    }
+
+    // Test 4: Keys too long for a record are rejected and do not corrupt the file
+    {
+        {
+            KeyValueStorage kvs(path);
+            if (kvs.SetValue(std::string(70000, 'k'), 1) || !kvs.SetValue("volume", 44) || !kvs.SyncToStorage()) {
+                log_error("Long key test FAILED");
+                return 1;
+            }
+        }
+        KeyValueStorage kvs(path);
+        if (kvs.GetValue<int>("volume") != 44 || kvs.GetValue<int>("odometer") != 19999) {
+            log_error("Long key test FAILED: storage not intact after reload");
+            return 1;
+        }
+        log_info("Long key test PASSED");
+    }
+
+    std::remove(path.c_str());
+    log_info("All key-value storage tests PASSED");
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "launcher.hpp"
+#include "logging.hpp"
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+
+static const std::string dir = "launcher_test";
+
+// A /bin/sh service stub: `script` runs with the readiness pipe on fd 3
+static LaunchSpec stub(const std::string& name, const std::string& script,
+                       std::vector<std::string> depends_on = {}) {
+    LaunchSpec spec;
+    spec.name = name;
+    spec.executable = "/bin/sh";
+    spec.args = {"-c", script};
+    spec.depends_on = std::move(depends_on);
+    spec.ready_timeout = std::chrono::milliseconds(2000);
+    return spec;
+}
+
+// Records its start in the order file, signals readiness and keeps running
+static std::string readyScript(const std::string& name) {
+    return "echo " + name + " >> " + dir + "/order; echo ok >&3; exec sleep 30";
+}
+
+// Waits until no service is pending or starting; returns the final states
+static std::map<std::string, BootEvent> settle(const Launcher& launcher) {
+    std::map<std::string, BootEvent> events;
+    for (int i = 0; i < 500; ++i) {
+        events.clear();
+        bool busy = false;
+        for (const auto& ev : launcher.timeline()) {
+            busy |= ev.state == "pending" || ev.state == "starting";
+            events[ev.name] = ev;
+        }
+        if (!busy) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return events;
+}
+
+static std::vector<std::string> startOrder() {
+    std::ifstream in(dir + "/order");
+    std::vector<std::string> order;
+    for (std::string line; std::getline(in, line);) order.push_back(line);
+    return order;
+}
+
+int main() {
+    log_info("Starting Launcher Tests");
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    // Test 1: Services start along the DAG; the diamond's top waits for both branches
+    {
+        Launcher launcher({stub("hmi", readyScript("hmi"), {"media", "navigation"}),
+                           stub("media", readyScript("media"), {"audio"}),
+                           stub("navigation", readyScript("navigation"), {"audio"}),
+                           stub("audio", readyScript("audio"))},
+                          ".");
+        if (!launcher.start()) {
+            log_error("DAG start test FAILED: start rejected");
+            return 1;
+        }
+        auto events = settle(launcher);
+        auto order = startOrder();
+        bool all_ready = true;
+        for (const auto& [name, ev] : events) all_ready &= ev.state == "ready";
+        if (!all_ready || order.size() != 4 || order.front() != "audio" || order.back() != "hmi" ||
+            events["media"].spawn_ms < events["audio"].ready_ms ||
+            events["hmi"].spawn_ms < events["media"].ready_ms ||
+            events["hmi"].spawn_ms < events["navigation"].ready_ms) {
+            log_error("DAG start test FAILED");
+            return 1;
+        }
+        launcher.stop();
+        for (const auto& ev : launcher.timeline()) {
+            if (ev.pid > 0) {
+                log_error("DAG start test FAILED: " + ev.name + " not reaped");
+                return 1;
+            }
+        }
+        log_info("DAG start test PASSED");
+    }
+
+    // Test 2: Cycles and unknown dependencies are rejected before anything is spawned
+    {
+        Launcher cyclic({stub("a", readyScript("a"), {"c"}), stub("b", readyScript("b"), {"a"}),
+                         stub("c", readyScript("c"), {"b"}), stub("d", readyScript("d"))},
+                        ".");
+        Launcher dangling({stub("a", readyScript("a"), {"missing"})}, ".");
+        std::filesystem::remove(dir + "/order");
+        if (cyclic.start() || dangling.start() || !startOrder().empty()) {
+            log_error("Cycle rejection test FAILED");
+            return 1;
+        }
+        log_info("Cycle rejection test PASSED");
+    }
+
+    // Test 3: A service that never signals times out; one that exits early fails;
+    // both failures propagate to their dependents, which are never spawned
+    {
+        LaunchSpec hung = stub("hung", "exec sleep 30");
+        hung.ready_timeout = std::chrono::milliseconds(200);
+        LaunchSpec quiet = stub("quiet", "exec sleep 30");
+        quiet.ready = "spawn";
+        Launcher launcher({hung, stub("crashed", "exit 1"), stub("hmi", readyScript("hmi"), {"hung", "quiet"}),
+                           stub("cluster", readyScript("cluster"), {"crashed"}), quiet},
+                          ".");
+        std::filesystem::remove(dir + "/order");
+        auto t0 = std::chrono::steady_clock::now();
+        if (!launcher.start()) {
+            log_error("Readiness failure test FAILED: start rejected");
+            return 1;
+        }
+        auto events = settle(launcher);
+        auto elapsed = std::chrono::steady_clock::now() - t0;
+        if (events["hung"].state != "failed" || events["hung"].detail.find("not ready within 200 ms") != 0 ||
+            events["crashed"].state != "failed" || events["crashed"].detail != "exited before signalling readiness" ||
+            events["quiet"].state != "ready" ||
+            events["hmi"].state != "failed" || events["hmi"].detail != "dependency hung failed" ||
+            events["cluster"].state != "failed" || events["cluster"].detail != "dependency crashed failed" ||
+            events["hmi"].spawn_ms >= 0 || !startOrder().empty() || elapsed > std::chrono::seconds(2)) {
+            log_error("Readiness failure test FAILED");
+            return 1;
+        }
+        launcher.stop();
+        log_info("Readiness failure test PASSED");
+    }
+
+    // Test 4: Manifests with an unknown ready mode do not load
+    {
+        std::vector<LaunchSpec> specs;
+        std::string bin_dir;
+        std::ofstream(dir + "/good.json") << R"({"bin_dir": "bin", "services": [
+            {"name": "media", "executable": "media_service", "ready": "spawn"},
+            {"name": "nav", "executable": "navigation_service", "depends_on": ["media"]}]})";
+        std::ofstream(dir + "/typo.json") << R"({"services": [
+            {"name": "media", "executable": "media_service", "ready": "Pipe"}]})";
+        if (!Launcher::loadManifest(dir + "/good.json", specs, bin_dir) || specs.size() != 2 ||
+            bin_dir != "bin" || specs[0].ready != "spawn" || specs[1].ready != "pipe" ||
+            Launcher::loadManifest(dir + "/typo.json", specs, bin_dir)) {
+            log_error("Ready mode validation test FAILED");
+            return 1;
+        }
+        log_info("Ready mode validation test PASSED");
+    }
+
+    std::filesystem::remove_all(dir);
+    log_info("All Launcher Tests PASSED");
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include "persistency_server.hpp"
+#include "persistency_client.hpp"
+#include "persistence.hpp"
+#include "write_behind.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+using namespace std::chrono_literals;
+
+static const std::string kSocket = "/tmp/ivi_persistency_test.sock";
+static const std::string kStore = "persistency_test_store.json";
+
+static void removeStore() {
+    for (const char* suffix : {".journal", ".journal.old", ".img"}) std::remove((kStore + suffix).c_str());
+}
+
+int main() {
+    log_info("Starting Persistency Daemon Tests");
+    removeStore();
+    Persistence::setDurability({common::Durability::GroupCommit, 1000ms, 0us});
+    const std::vector<std::string> services = {"media", "navigation", "climate"};
+    const int kSaves = 20;
+
+    // Test 1: No daemon, no connection
+    {
+        common::per::PersistencyClient client("media", kSocket);
+        if (client.connect()) {
+            log_error("Missing daemon test FAILED");
+            return 1;
+        }
+        log_info("Missing daemon test PASSED");
+    }
+
+    // Test 2: Concurrent services share commits; each loads its own state
+    {
+        PersistencyServer server(kSocket, kStore, {5000us, 1024 * 1024});
+        if (!server.start()) {
+            log_error("Shared commit test FAILED: server did not start");
+            return 1;
+        }
+        std::vector<std::thread> clients;
+        for (const auto& name : services) {
+            clients.emplace_back([&server, name, kSaves]() {
+                common::per::PersistencyClient client(name, kSocket);
+                if (!client.connect() || !client.load()) return;
+                for (int i = 1; i <= kSaves; ++i) {
+                    client.save(json{{"service", name}, {"counter", i}, {"stale", i < kSaves}});
+                }
+                client.save(json{{"service", name}, {"counter", kSaves}});
+            });
+        }
+        for (auto& t : clients) t.join();
+
+        for (const auto& name : services) {
+            common::per::PersistencyClient client(name, kSocket);
+            auto state = client.connect() ? client.load() : std::nullopt;
+            if (!state || *state != json({{"service", name}, {"counter", kSaves}})) {
+                log_error("Shared commit test FAILED: state of " + name + " is " + (state ? state->dump() : "-"));
+                return 1;
+            }
+        }
+        auto stats = server.stats();
+        if (stats.updates != services.size() * (kSaves + 1) || stats.commits >= stats.updates) {
+            log_error("Shared commit test FAILED: " + std::to_string(stats.updates) + " updates in " +
+                      std::to_string(stats.commits) + " commits");
+            return 1;
+        }
+        log_info("Shared commit test PASSED (" + std::to_string(stats.updates) + " updates in " +
+                 std::to_string(stats.commits) + " commits)");
+    }
+
+    // Test 3: A restarted daemon serves the committed state
+    {
+        PersistencyServer server(kSocket, kStore);
+        common::per::PersistencyClient client("navigation", kSocket);
+        auto state = server.start() && client.connect() ? client.load() : std::nullopt;
+        if (!state || state->value("counter", 0) != kSaves) {
+            log_error("Daemon restart test FAILED");
+            return 1;
+        }
+        log_info("Daemon restart test PASSED");
+    }
+
+    // Test 4: WriteBehind seeds the daemon from its local file, then stores through it
+    {
+        const std::string local = "persistency_test_hmi.json";
+        Persistence::saveState(local, json{{"theme", "dark"}});
+        PersistencyServer server(kSocket, kStore);
+        server.start();
+        std::mutex mtx;
+        json state;
+        {
+            common::WriteBehind::Options opts;
+            opts.persistency_service = "hmi";
+            opts.persistency_socket = kSocket;
+            common::WriteBehind persist(local, [&]() {
+                std::lock_guard<std::mutex> lk(mtx);
+                return state;
+            }, opts);
+            state = persist.load();
+            std::lock_guard<std::mutex> lk(mtx);
+            state["brightness"] = 80;
+            persist.markDirty();
+        }
+        common::per::PersistencyClient client("hmi", kSocket);
+        auto stored = client.connect() ? client.load() : std::nullopt;
+        if (!stored || stored->value("theme", "") != "dark" || stored->value("brightness", 0) != 80 ||
+            Persistence::loadState(local).contains("brightness")) {
+            log_error("Write-behind daemon test FAILED");
+            return 1;
+        }
+        std::remove(local.c_str());
+        log_info("Write-behind daemon test PASSED");
+    }
+
+    // Test 5: State written locally while the daemon was away wins over its stale copy
+    {
+        const std::string local = "persistency_test_nav.json";
+        const std::string pending = local + ".pending";
+        std::remove(local.c_str());
+        std::remove(pending.c_str());
+        std::mutex mtx;
+        json state;
+        auto snapshot = [&]() {
+            std::lock_guard<std::mutex> lk(mtx);
+            return state;
+        };
+        auto set = [&](const std::string& route, common::WriteBehind& persist) {
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                state["route"] = route;
+            }
+            persist.markDirty();
+            persist.flush();
+        };
+        common::WriteBehind::Options opts;
+        opts.persistency_service = "nav";
+        opts.persistency_socket = kSocket;
+        opts.reconnect_interval = 0ms;
+
+        auto server = std::make_unique<PersistencyServer>(kSocket, kStore);
+        server->start();
+        {
+            common::WriteBehind persist(local, snapshot, opts);
+            state = persist.load();
+            set("home", persist);
+            server.reset();
+            set("work", persist);
+        }
+        if (!std::filesystem::exists(pending) || Persistence::loadState(local).value("route", "") != "work") {
+            log_error("Daemon loss test FAILED: local copy not marked newer");
+            return 1;
+        }
+
+        server = std::make_unique<PersistencyServer>(kSocket, kStore);
+        server->start();
+        {
+            common::WriteBehind persist(local, snapshot, opts);
+            state = persist.load();
+            if (state.value("route", "") != "work" || std::filesystem::exists(pending)) {
+                log_error("Daemon loss test FAILED: newer local copy replaced by " + state.dump());
+                return 1;
+            }
+            // Lost and back while running: the writer reconnects on its own
+            server.reset();
+            set("gym", persist);
+            server = std::make_unique<PersistencyServer>(kSocket, kStore);
+            server->start();
+            set("school", persist);
+        }
+        common::per::PersistencyClient client("nav", kSocket);
+        auto stored = client.connect() ? client.load() : std::nullopt;
+        if (!stored || stored->value("route", "") != "school" || std::filesystem::exists(pending)) {
+            log_error("Daemon loss test FAILED: daemon holds " + (stored ? stored->dump() : std::string("-")));
+            return 1;
+        }
+        server.reset();
+        std::remove(local.c_str());
+        log_info("Daemon loss test PASSED");
+    }
+
+    removeStore();
+    log_info("All Persistency Daemon Tests PASSED");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "query_server.hpp"
+#include "rpc_frame.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <iostream>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Read newline-delimited replies until `count` lines arrived
+static bool readLines(int fd, size_t count, std::vector<json>& out) {
+    std::string buf;
+    char chunk[4096];
+    while (out.size() < count) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n <= 0) return false;
+        buf.append(chunk, static_cast<size_t>(n));
+        size_t nl;
+        while ((nl = buf.find('\n')) != std::string::npos) {
+            out.push_back(json::parse(buf.substr(0, nl)));
+            buf.erase(0, nl + 1);
+        }
+    }
+    return true;
+}
+
+int main() {
+    log_info("Starting Query Server Tests");
+
+    QueryServer server(0, 4, [](const json& req, const std::string&) {
+        return json{{"id", req.at("id")}, {"cmd", req.value("cmd", "")}};
+    });
+    if (!server.start() || server.threads() != 4) {
+        log_error("Query server start test FAILED");
+        return 1;
+    }
+
+    // Test 1: Concurrent clients with pipelined requests get in-order replies
+    {
+        const int clients = 8, per_client = 200;
+        std::atomic<int> failures{0};
+        std::vector<std::thread> threads;
+        for (int c = 0; c < clients; ++c) {
+            threads.emplace_back([&, c]() {
+                int fd = common::rpc::connectTcp("127.0.0.1", server.boundPort());
+                std::string batch;
+                for (int i = 0; i < per_client; ++i) {
+                    batch += json{{"cmd", "get"}, {"id", c * 1000 + i}}.dump() + "\n";
+                }
+                std::vector<json> replies;
+                bool ok = fd >= 0 && common::rpc::writeFull(fd, batch.data(), batch.size()) &&
+                          readLines(fd, per_client, replies);
+                for (int i = 0; ok && i < per_client; ++i) ok = replies[i].at("id") == c * 1000 + i;
+                if (!ok) failures++;
+                if (fd >= 0) ::close(fd);
+            });
+        }
+        for (auto& t : threads) t.join();
+        if (failures != 0 || server.queries() != static_cast<uint64_t>(clients * per_client)) {
+            log_error("Pipelined query test FAILED");
+            return 1;
+        }
+        log_info("Pipelined query test PASSED");
+    }
+
+    // Test 2: Malformed requests are answered, not dropped
+    {
+        int fd = common::rpc::connectTcp("127.0.0.1", server.boundPort());
+        std::string req = "not json\n{\"id\":7}\n";
+        std::vector<json> replies;
+        bool ok = fd >= 0 && common::rpc::writeFull(fd, req.data(), req.size()) && readLines(fd, 2, replies) &&
+                  replies[0].value("error", "") == "bad_request" && replies[1].at("id") == 7;
+        if (fd >= 0) ::close(fd);
+        if (!ok) {
+            log_error("Malformed query test FAILED");
+            return 1;
+        }
+        log_info("Malformed query test PASSED");
+    }
+
+    // Test 3: A client that half-closes after a large pipeline gets every reply
+    {
+        const int count = 8000; // replies larger than the socket buffers
+        int fd = common::rpc::connectTcp("127.0.0.1", server.boundPort());
+        std::string batch;
+        for (int i = 0; i < count; ++i) batch += json{{"cmd", std::string(1024, 'x')}, {"id", i}}.dump() + "\n";
+        std::vector<json> replies;
+        bool ok = fd >= 0 && common::rpc::writeFull(fd, batch.data(), batch.size()) &&
+                  ::shutdown(fd, SHUT_WR) == 0 && readLines(fd, count, replies) && replies.back().at("id") == count - 1;
+        if (fd >= 0) ::close(fd);
+        if (!ok) {
+            log_error("Half-close test FAILED: " + std::to_string(replies.size()) + " replies");
+            return 1;
+        }
+        log_info("Half-close test PASSED");
+    }
+
+    // Test 4: A second server cannot take over a port that is being served
+    {
+        QueryServer second(server.boundPort(), 2, [](const json&, const std::string&) { return json::object(); });
+        if (second.start()) {
+            log_error("Port conflict test FAILED");
+            return 1;
+        }
+        log_info("Port conflict test PASSED");
+    }
+
+    server.stop();
+    log_info("All query server tests PASSED");
+    return 0;
+}
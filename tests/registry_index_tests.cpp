@@ -0,0 +1,56 @@
+#include "registry_index.hpp"
+#include "logging.hpp"
+#include <iostream>
+
+int main() {
+    log_info("Starting Registry Index Tests");
+
+    RegistryIndex index;
+    index.insert("media", {"Media", "127.0.0.1", 5001, {"audio"}});
+    index.insert("media_rear", {"Media", "10.0.0.2", 5101, {"audio", "rear"}});
+    index.insert("climate", {"Climate", "127.0.0.1", 5003, {}});
+    index.insert("navigation", {"Navigation", "127.0.0.1", 5002, {}});
+
+    // Test 1: Equality, tag and port range queries
+    {
+        IndexQuery by_type;
+        by_type.type = "Media";
+        IndexQuery by_tag_host;
+        by_tag_host.tags = {"audio"};
+        by_tag_host.host = "10.0.0.2";
+        IndexQuery by_ports;
+        by_ports.port_min = 5002;
+        by_ports.port_max = 5003;
+
+        auto media = index.find(by_type);
+        auto rear = index.find(by_tag_host);
+        auto ports = index.find(by_ports);
+        if (media != std::vector<std::string>{"media", "media_rear"} ||
+            rear != std::vector<std::string>{"media_rear"} ||
+            ports != std::vector<std::string>{"climate", "navigation"}) {
+            log_error("Index query test FAILED");
+            return 1;
+        }
+        log_info("Index query test PASSED");
+    }
+
+    // Test 2: Re-registration and deregistration keep the indexes consistent
+    {
+        index.insert("media_rear", {"Media", "10.0.0.3", 5101, {}});
+        index.erase("media");
+
+        IndexQuery by_type;
+        by_type.type = "Media";
+        IndexQuery by_tag;
+        by_tag.tags = {"audio"};
+        if (index.find(by_type) != std::vector<std::string>{"media_rear"} ||
+            !index.find(by_tag).empty() || index.size() != 3) {
+            log_error("Index maintenance test FAILED");
+            return 1;
+        }
+        log_info("Index maintenance test PASSED");
+    }
+
+    log_info("All registry index tests completed successfully");
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "registry_snapshot.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+int main() {
+    log_info("Starting Registry Snapshot Tests");
+    const std::string path = "registry_snapshot_test.snap";
+    std::remove(path.c_str());
+
+    // Test 1: Published image is written by the background writer and loads back
+    {
+        RegistrySnapshot snap(path);
+        snap.start();
+        snap.publish({{"media", "127.0.0.1", 5001, 11, "", {}}});
+        snap.publish({{"media", "127.0.0.1", 5001, 11, "", {}},
+                      {"climate", "10.0.0.2", 5003, 22, "Climate", {"hvac", "rear"}}});
+        snap.stop();
+
+        std::vector<SnapshotEntry> out;
+        if (!snap.load(out) || out.size() != 2 || out[1].name != "climate" ||
+            out[1].host != "10.0.0.2" || out[1].port != 5003 || out[1].instance_id != 22 ||
+            out[1].type != "Climate" || out[1].tags.size() != 2 || out[1].tags[1] != "rear") {
+            log_error("Snapshot round trip test FAILED");
+            return 1;
+        }
+        log_info("Snapshot round trip test PASSED");
+    }
+
+    // Test 2: Corrupt snapshots are rejected
+    {
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(20);
+            f.put('X');
+        }
+        RegistrySnapshot snap(path);
+        std::vector<SnapshotEntry> out;
+        if (snap.load(out)) {
+            log_error("Snapshot corruption test FAILED");
+            return 1;
+        }
+        log_info("Snapshot corruption test PASSED");
+    }
+
+    // Test 3: Entries too large for the u16 lengths are skipped, the rest still load
+    {
+        RegistrySnapshot snap(path);
+        snap.start();
+        snap.publish({{"media", "127.0.0.1", 5001, 11, "", {}},
+                      {std::string(70000, 'n'), "127.0.0.1", 5002, 12, "", {}},
+                      {"climate", "10.0.0.2", 5003, 22, "", {std::string(70000, 't')}},
+                      {"navigation", "127.0.0.1", 5004, 33, "", std::vector<std::string>(70000, "x")},
+                      {"phone", "127.0.0.1", 5005, 44, "Phone", {"bt"}}});
+        snap.stop();
+
+        std::vector<SnapshotEntry> out;
+        if (!snap.load(out) || out.size() != 2 || out[0].name != "media" || out[1].name != "phone" ||
+            out[1].tags.size() != 1 || out[1].tags[0] != "bt") {
+            log_error("Oversized entry test FAILED");
+            return 1;
+        }
+        log_info("Oversized entry test PASSED");
+    }
+
+    std::remove(path.c_str());
+    log_info("All registry snapshot tests completed successfully");
+    return 0;
+}
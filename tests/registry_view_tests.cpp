@@ -0,0 +1,118 @@
+#include "registry_view.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <map>
+
+using json = nlohmann::json;
+
+// The registry side of the Service Manager: entries stamped by the change log
+struct Registry {
+    RegistryChangeLog log{42, 1024};
+    std::map<std::string, uint64_t> services; // name -> version
+
+    void put(const std::string& name) { services[name] = log.next(); }
+    void erase(const std::string& name) {
+        services.erase(name);
+        log.remove(name);
+    }
+
+    // As ServiceManager::publishView builds it
+    RegistryView view() const {
+        RegistryView v;
+        for (const auto& [name, version] : services) {
+            v.services.emplace(name, RegistryView::Entry{name, "127.0.0.1", 5000, "Media", {}, "alive", true, true,
+                                                         version});
+            v.by_version.emplace_back(version, name);
+        }
+        std::sort(v.by_version.begin(), v.by_version.end());
+        log.stamp(v);
+        return v;
+    }
+};
+
+static std::vector<std::string> names(const json& list, const char* key = nullptr) {
+    std::vector<std::string> out;
+    for (const auto& e : list) out.push_back(key ? e.at(key).get<std::string>() : e.get<std::string>());
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static json since(const Registry& r, uint64_t version, uint64_t epoch = 42) {
+    return r.view().changesSince(json{{"cmd", "changes_since"}, {"version", version}, {"epoch", epoch}});
+}
+
+int main() {
+    log_info("Starting Registry View Tests");
+    Registry registry;
+    for (const char* s : {"media", "navigation", "climate"}) registry.put(s);
+
+    // Test 1: A client without a cache, or from another run, gets everything
+    {
+        json first = since(registry, 0, 0);
+        json other_run = since(registry, 3, 7);
+        if (!first.at("full") || names(first["changed"], "service").size() != 3 || first["epoch"] != 42 ||
+            first["version"] != 3 || !other_run.at("full") || other_run["changed"].size() != 3) {
+            log_error("Full sync test FAILED: " + first.dump());
+            return 1;
+        }
+        log_info("Full sync test PASSED");
+    }
+
+    // Test 2: Deltas carry changed entries and removals since the client's version
+    {
+        registry.put("navigation");
+        registry.erase("climate");
+        json delta = since(registry, 3);
+        if (delta.at("full") || names(delta["changed"], "service") != std::vector<std::string>{"navigation"} ||
+            names(delta["removed"]) != std::vector<std::string>{"climate"} || delta["version"] != 5) {
+            log_error("Delta test FAILED: " + delta.dump());
+            return 1;
+        }
+        // A service registered again after its removal is changed, not removed
+        registry.put("climate");
+        json again = since(registry, 3);
+        if (again.at("full") || names(again["changed"], "service") != std::vector<std::string>{"climate", "navigation"} ||
+            !again["removed"].empty()) {
+            log_error("Delta test FAILED: re-registration " + again.dump());
+            return 1;
+        }
+        json current = since(registry, 6);
+        if (current.at("full") || !current["changed"].empty() || !current["removed"].empty()) {
+            log_error("Delta test FAILED: up-to-date client " + current.dump());
+            return 1;
+        }
+        log_info("Delta test PASSED");
+    }
+
+    // Test 3: Once removals the client missed were truncated, it resyncs fully
+    {
+        uint64_t client = registry.log.version();
+        for (int i = 0; i < 1024; ++i) registry.put("tmp" + std::to_string(i));
+        for (int i = 0; i < 1024; ++i) registry.erase("tmp" + std::to_string(i));
+        json kept = since(registry, client);
+        registry.put("tmp");
+        registry.erase("tmp");
+        json truncated = since(registry, client);
+        if (kept.at("full") || kept["removed"].size() != 1024 || !kept["changed"].empty() ||
+            !truncated.at("full") || !truncated["removed"].empty() ||
+            names(truncated["changed"], "service") != std::vector<std::string>{"climate", "media", "navigation"}) {
+            log_error("Tombstone truncation test FAILED: " + std::to_string(kept["removed"].size()) + " kept");
+            return 1;
+        }
+        log_info("Tombstone truncation test PASSED");
+    }
+
+    // Test 4: A version this registry never issued forces a full resync
+    {
+        json future = since(registry, registry.log.version() + 1);
+        if (!future.at("full") || future["changed"].size() != 3 || !future["removed"].empty() ||
+            future["version"] != registry.log.version()) {
+            log_error("Future version test FAILED: " + future.dump());
+            return 1;
+        }
+        log_info("Future version test PASSED");
+    }
+
+    log_info("All Registry View Tests PASSED");
+    return 0;
+}
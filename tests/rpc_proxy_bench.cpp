@@ -0,0 +1,113 @@
+// Benchmark: direct RPC round trips vs. round trips proxied by the Service
+// Manager's splice-based RpcProxy. Not part of ctest; run manually:
+//   ./tests/rpc_proxy_bench [iterations]
+#include "rpc_proxy.hpp"
+#include "rpc_frame.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace rpc = common::rpc;
+using Clock = std::chrono::steady_clock;
+
+// Echo service: replies with the request payload
+static int startEchoServer(int& port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 16) < 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) < 0) {
+        return -1;
+    }
+    port = ntohs(addr.sin_port);
+    std::thread([fd]() {
+        while (true) {
+            int c = ::accept(fd, nullptr, nullptr);
+            if (c < 0) return;
+            std::thread([c]() {
+                rpc::FrameHeader h;
+                std::string name, payload;
+                while (rpc::recvFrame(c, h, name, payload)) {
+                    if (!rpc::sendFrame(c, "", payload.data(), payload.size())) break;
+                }
+                ::close(c);
+            }).detach();
+        }
+    }).detach();
+    return fd;
+}
+
+// Median round trip in microseconds
+static double measure(int fd, const std::string& service, size_t size, int iterations) {
+    std::string request(size, 'x'), reply;
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    for (int i = 0; i < iterations + iterations / 10; ++i) {
+        auto t0 = Clock::now();
+        if (!rpc::call(fd, service, request, reply) || reply.size() != size) return -1.0;
+        if (i >= iterations / 10) { // skip warm-up
+            samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    int echo_port = 0;
+    if (startEchoServer(echo_port) < 0) {
+        std::cerr << "Failed to start echo service" << std::endl;
+        return 1;
+    }
+    RpcProxy proxy(0, [echo_port](const std::string& name, std::string& host, int& port) {
+        if (name != "echo") return false;
+        host = "127.0.0.1";
+        port = echo_port;
+        return true;
+    });
+    if (!proxy.start()) {
+        std::cerr << "Failed to start RPC proxy" << std::endl;
+        return 1;
+    }
+
+    int direct = rpc::connectTcp("127.0.0.1", echo_port);
+    int proxied = rpc::connectTcp("127.0.0.1", proxy.boundPort());
+    if (direct < 0 || proxied < 0) {
+        std::cerr << "Failed to connect" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(10) << "payload" << std::setw(14) << "direct us" << std::setw(14) << "proxied us"
+              << std::setw(10) << "ratio" << std::endl;
+    for (size_t size : {64ul, 1024ul, 16ul * 1024, 256ul * 1024, 1024ul * 1024, 4ul * 1024 * 1024}) {
+        int n = size >= 1024 * 1024 ? std::max(1, iterations / 20) : iterations;
+        double d = measure(direct, "", size, n);
+        double p = measure(proxied, "echo", size, n);
+        if (d < 0 || p < 0) {
+            std::cerr << "Round trip failed at " << size << " bytes" << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(10) << size << std::setw(14) << std::fixed << std::setprecision(1) << d
+                  << std::setw(14) << p << std::setw(10) << std::setprecision(2) << p / d << std::endl;
+    }
+
+    auto stats = proxy.stats();
+    std::cout << "Proxy: " << stats.calls << " calls, " << stats.bytes << " bytes, " << stats.errors
+              << " errors" << std::endl;
+    ::close(direct);
+    ::close(proxied);
+    proxy.stop();
+    return 0;
+}
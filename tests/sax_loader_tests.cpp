@@ -0,0 +1,132 @@
+#include "sax_loader.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sys/resource.h>
+
+struct Track {
+    std::string title;
+    double length_s = 0;
+    int64_t added_s = 0;
+};
+
+struct Library {
+    std::string name;
+    uint32_t version = 0;
+    bool shuffle = false;
+    std::vector<Track> tracks;
+    std::vector<std::pair<std::string, int>> ratings;
+    nlohmann::json extra;
+};
+
+template <>
+struct common::sax::Schema<Track> {
+    static void describe(Fields<Track>& f) {
+        f.required("title", &Track::title);
+        f.field("length_s", &Track::length_s);
+        f.convert<int64_t>("added_ms", [](Track& t, int64_t&& ms) { t.added_s = ms / 1000; });
+    }
+};
+
+template <>
+struct common::sax::Schema<Library> {
+    static void describe(Fields<Library>& f) {
+        f.required("name", &Library::name);
+        f.field("version", &Library::version);
+        f.field("shuffle", &Library::shuffle);
+        f.field("tracks", &Library::tracks);
+        f.field("ratings", &Library::ratings);
+        f.field("extra", &Library::extra);
+    }
+};
+
+static long maxRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main() {
+    log_info("Starting SAX Loader Tests");
+
+    // Test 1: Declared keys map into the struct, unknown subtrees are skipped
+    {
+        const char* doc = R"({
+            "cache": {"blobs": [[1, 2, {"deep": [true, null]}], "x"], "n": 3},
+            "name": "car", "version": 7, "shuffle": true,
+            "tracks": [{"title": "A", "length_s": 3.5, "added_ms": 61000, "art": {"w": 1}},
+                       {"title": "B", "length_s": 200}],
+            "ratings": {"A": 5, "B": 3},
+            "extra": {"eq": [1, 2, {"bass": -2}]},
+            "trailing": [[], {}]
+        })";
+        Library lib;
+        std::string error;
+        if (!common::sax::loadString(doc, lib, &error)) {
+            log_error("Mapping test FAILED: " + error);
+            return 1;
+        }
+        bool ok = lib.name == "car" && lib.version == 7 && lib.shuffle && lib.tracks.size() == 2 &&
+                  lib.tracks[0].title == "A" && lib.tracks[0].length_s == 3.5 && lib.tracks[0].added_s == 61 &&
+                  lib.tracks[1].length_s == 200 && lib.ratings.size() == 2 && lib.ratings[0].first == "A" &&
+                  lib.ratings[0].second == 5 && lib.extra == nlohmann::json::parse(R"({"eq": [1, 2, {"bass": -2}]})");
+        if (!ok) {
+            log_error("Mapping test FAILED");
+            return 1;
+        }
+        log_info("Mapping test PASSED");
+    }
+
+    // Test 2: Type mismatches, missing keys and syntax errors are reported
+    {
+        struct Case {
+            const char* doc;
+            const char* expect;
+        };
+        const Case cases[] = {
+            {R"({"name": "x", "version": -1})", "at /version"},
+            {R"({"name": "x", "tracks": [{"title": 3}]})", "at /tracks/title"},
+            {R"({"name": "x", "tracks": [{"length_s": 1}]})", "missing required key 'title'"},
+            {R"({"version": 1})", "missing required key 'name'"},
+            {R"([1, 2])", "unexpected value type at /"},
+            {R"({"name": "x", )", "syntax error"},
+        };
+        for (const auto& c : cases) {
+            Library lib;
+            std::string error;
+            if (common::sax::loadString(c.doc, lib, &error) || error.find(c.expect) == std::string::npos) {
+                log_error(std::string("Error reporting test FAILED for ") + c.doc + ": " + error);
+                return 1;
+            }
+        }
+        log_info("Error reporting test PASSED");
+    }
+
+    // Test 3: Memory is bounded by the target, not by the file
+    {
+        const std::string file = "sax_loader_test_big.json";
+        {
+            std::ofstream out(file);
+            out << R"({"name": "big", "library_cache": [)";
+            for (int i = 0; i < 200000; ++i) {
+                out << (i ? "," : "") << R"({"id": )" << i
+                    << R"(, "path": "/media/usb0/music/some/long/directory/name/track.flac", "tags": ["a", "b", "c"]})";
+            }
+            out << R"(], "tracks": [{"title": "kept"}]})";
+        }
+        long before = maxRssKb();
+        Library lib;
+        std::string error;
+        bool ok = common::sax::loadFile(file, lib, &error);
+        long grown = maxRssKb() - before;
+        std::remove(file.c_str());
+        if (!ok || lib.tracks.size() != 1 || lib.tracks[0].title != "kept" || grown > 4 * 1024) {
+            log_error("Bounded memory test FAILED: " + error + ", grew " + std::to_string(grown) + " KB");
+            return 1;
+        }
+        log_info("Bounded memory test PASSED (grew " + std::to_string(grown) + " KB)");
+    }
+
+    log_info("All SAX Loader Tests PASSED");
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include "state_image.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using json = nlohmann::json;
+
+int main() {
+    log_info("Starting State Image Tests");
+    const std::string path = "state_image_test.img";
+    json state = {{"playing", true}, {"volume", 42}, {"gain", -3.5}, {"track", "Highway Star"},
+                  {"presets", {88.5, 101.1}}, {"eq", {{"bass", 2}}}, {"artist", nullptr}};
+
+    // Test 1: Typed values are read in place from the mapping
+    {
+        if (!common::StateImage::write(path, state, 17)) {
+            log_error("Image write test FAILED");
+            return 1;
+        }
+        auto image = common::StateImage::open(path);
+        if (!image || image->size() != 7 || image->sequence() != 17 || image->getBool("playing") != true ||
+            image->getInt("volume") != 42 || image->getDouble("gain") != -3.5 ||
+            image->getString("track") != std::string_view("Highway Star") || image->getInt("track") ||
+            image->contains("missing") || !image->contains("artist") || image->get("eq") != state["eq"]) {
+            log_error("Typed read test FAILED");
+            return 1;
+        }
+        if (image->toJson() != state) {
+            log_error("Round trip test FAILED: " + image->toJson().dump());
+            return 1;
+        }
+        log_info("Typed read and round trip test PASSED");
+    }
+
+    // Test 2: Corrupt, truncated and missing images are rejected
+    {
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(-3, std::ios::end);
+            f.put('X');
+        }
+        bool corrupt_rejected = !common::StateImage::open(path);
+        {
+            std::ofstream f(path, std::ios::binary | std::ios::trunc);
+            f.write("IVSI", 4);
+        }
+        bool truncated_rejected = !common::StateImage::open(path);
+        std::remove(path.c_str());
+        if (!corrupt_rejected || !truncated_rejected || common::StateImage::open(path)) {
+            log_error("Invalid image test FAILED");
+            return 1;
+        }
+        log_info("Invalid image test PASSED");
+    }
+
+    // Test 3: Keys too long for the entry table are rejected, not truncated
+    {
+        json bad = state;
+        bad[std::string(70000, 'k')] = 1;
+        if (common::StateImage::write(path, bad, 18) || common::StateImage::open(path)) {
+            log_error("Long key test FAILED");
+            return 1;
+        }
+        log_info("Long key test PASSED");
+    }
+
+    log_info("All state image tests PASSED");
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "state_journal.hpp"
+#include "persistence.hpp"
+#include "logging.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <csignal>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+static void cleanup(const std::string& path) {
+    for (const char* ext : {"", ".journal", ".journal.old", ".img", ".img.tmp"}) {
+        std::remove((path + ext).c_str());
+    }
+}
+
+int main() {
+    log_info("Starting State Journal Tests");
+    const std::string path = "state_journal_test.json";
+    cleanup(path);
+
+    // Test 1: The plain document seeds the journal; changes replay after restart
+    {
+        Persistence::saveState(path, json{{"volume", 50}, {"track", "Unknown"}});
+        {
+            common::StateJournal journal(path);
+            json state = journal.recover();
+            if (state.value("volume", 0) != 50) {
+                log_error("Document seeding test FAILED");
+                return 1;
+            }
+            state["volume"] = 55;
+            state["playing"] = true;
+            size_t written = journal.save(state);
+            state.erase("track");
+            written += journal.save(state);
+            // One changed key, one added key, one removed key
+            if (written != 3 || journal.sequence() != 3 || journal.journalBytes() > 100) {
+                log_error("Change record test FAILED: " + std::to_string(written) + " records, " +
+                          std::to_string(journal.journalBytes()) + " bytes");
+                return 1;
+            }
+        }
+        common::StateJournal journal(path);
+        json state = journal.recover();
+        if (state != json{{"volume", 55}, {"playing", true}} || journal.sequence() != 3) {
+            log_error("Replay test FAILED: " + state.dump());
+            return 1;
+        }
+        log_info("Seeding and replay test PASSED");
+    }
+
+    // Test 2: A torn tail is dropped and appends continue after it
+    {
+        {
+            std::ofstream out(path + ".journal", std::ios::binary | std::ios::app);
+            out.write("\x12\x34\x56\x78garbage", 11);
+        }
+        {
+            common::StateJournal journal(path);
+            journal.recover();
+            journal.put("volume", 60);
+        }
+        common::StateJournal journal(path);
+        json state = journal.recover();
+        if (state.value("volume", 0) != 60 || journal.sequence() != 4) {
+            log_error("Torn tail test FAILED: " + state.dump());
+            return 1;
+        }
+        log_info("Torn tail test PASSED");
+    }
+
+    // Test 3: The journal is compacted into a snapshot in the background
+    {
+        int volume = 0;
+        uint64_t last_seq = 0;
+        {
+            common::StateJournal journal(path, {1024});
+            journal.recover();
+            for (; volume < 500; ++volume) journal.put("volume", volume);
+            // The journal may outgrow the threshold while a compaction is pending;
+            // the next rotation after a completed one brings it back below
+            uint64_t compacted = journal.compactions();
+            bool shrank = false;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!shrank && std::chrono::steady_clock::now() < deadline) {
+                journal.put("volume", volume++);
+                shrank = journal.compactions() > compacted && journal.journalBytes() < 1024;
+                if (!shrank) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (!shrank || !std::filesystem::exists(path + ".img")) {
+                log_error("Compaction test FAILED: journal at " + std::to_string(journal.journalBytes()) +
+                          " bytes after " + std::to_string(journal.compactions()) + " compactions");
+                return 1;
+            }
+            last_seq = journal.sequence();
+        }
+        common::StateJournal journal(path);
+        json state = journal.recover();
+        if (state.value("volume", 0) != volume - 1 || !state.value("playing", false) ||
+            journal.sequence() != last_seq) {
+            log_error("Recovery after compaction test FAILED: " + state.dump());
+            return 1;
+        }
+        log_info("Compaction test PASSED");
+    }
+
+    // Test 4: A batch that cannot be written entirely is rolled back
+    {
+        cleanup(path);
+        {
+            common::StateJournal journal(path);
+            journal.recover();
+            journal.apply(json{{"volume", 10}, {"track", "A"}}, {});
+        }
+        // The file size cap that makes the second record fail with EFBIG is
+        // process-wide, so the batch runs in a child
+        pid_t child = ::fork();
+        if (child == 0) {
+            common::StateJournal journal(path);
+            journal.recover();
+            uint64_t seq = journal.sequence();
+            size_t bytes = journal.journalBytes();
+            std::signal(SIGXFSZ, SIG_IGN);
+            rlimit cap{};
+            ::getrlimit(RLIMIT_FSIZE, &cap);
+            cap.rlim_cur = bytes + 40;
+            ::setrlimit(RLIMIT_FSIZE, &cap);
+            size_t written = 99;
+            bool ok = journal.apply(json{{"track", "B"}, {"volume", std::string(200, '1')}}, {"missing"}, &written);
+            bool rolled_back = !ok && written == 0 && journal.sequence() == seq && journal.journalBytes() == bytes;
+            cap.rlim_cur = RLIM_INFINITY;
+            ::setrlimit(RLIMIT_FSIZE, &cap);
+            // Neither the mirror nor the file keeps a part of the batch
+            rolled_back = rolled_back && journal.put("playing", true);
+            ::_exit(rolled_back ? 0 : 1);
+        }
+        int status = -1;
+        ::waitpid(child, &status, 0);
+        common::StateJournal journal(path);
+        json state = journal.recover();
+        if (child < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+            state != json({{"volume", 10}, {"track", "A"}, {"playing", true}}) || journal.sequence() != 3) {
+            log_error("Failed batch test FAILED: " + state.dump());
+            return 1;
+        }
+        log_info("Failed batch test PASSED");
+    }
+
+    cleanup(path);
+    log_info("All state journal tests PASSED");
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "topic_trie.hpp"
+#include "logging.hpp"
+#include <algorithm>
+#include <iostream>
+
+static std::vector<uint32_t> matchSorted(const TopicTrie& trie, const std::string& topic) {
+    std::vector<uint32_t> ids;
+    trie.match(topic, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+int main() {
+    log_info("Starting Topic Trie Tests");
+
+    TopicTrie trie;
+    trie.insert("climate/temperature_update", 1);
+    trie.insert("climate/#", 2);
+    trie.insert("+/track_update", 3);
+    trie.insert("#", 4);
+    trie.insert("media/+/metadata", 5);
+
+    // Test 1: Literal, single-level and multi-level wildcards
+    {
+        if (matchSorted(trie, "climate/temperature_update") != std::vector<uint32_t>{1, 2, 4} ||
+            matchSorted(trie, "media/track_update") != std::vector<uint32_t>{3, 4} ||
+            matchSorted(trie, "media/rear/metadata") != std::vector<uint32_t>{4, 5} ||
+            matchSorted(trie, "climate") != std::vector<uint32_t>{2, 4} ||
+            matchSorted(trie, "media/rear/track_update") != std::vector<uint32_t>{4}) {
+            log_error("Topic matching test FAILED");
+            return 1;
+        }
+        log_info("Topic matching test PASSED");
+    }
+
+    // Test 2: Invalid patterns are rejected, erase removes subscriptions
+    {
+        bool rejected = !trie.insert("climate/#/x", 9) && !trie.insert("cli+mate", 9) && !trie.insert("", 9);
+        trie.erase("#", 4);
+        trie.erase("climate/#", 2);
+        if (!rejected || trie.size() != 3 ||
+            matchSorted(trie, "climate/temperature_update") != std::vector<uint32_t>{1}) {
+            log_error("Topic subscription maintenance test FAILED");
+            return 1;
+        }
+        log_info("Topic subscription maintenance test PASSED");
+    }
+
+    // Test 3: Single-pattern matching agrees with the trie
+    {
+        if (!TopicTrie::matches("climate/#", "climate/temperature_update") ||
+            !TopicTrie::matches("+/track_update", "media/track_update") ||
+            !TopicTrie::matches("#", "media") ||
+            TopicTrie::matches("climate/+", "climate/a/b") ||
+            TopicTrie::matches("media/+/metadata", "media/metadata")) {
+            log_error("Single pattern match test FAILED");
+            return 1;
+        }
+        log_info("Single pattern match test PASSED");
+    }
+
+    log_info("All topic trie tests completed successfully");
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include "versioned_state.hpp"
+#include "logging.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+
+// Counts live instances to check that every version is reclaimed
+struct Counted {
+    static std::atomic<int> live;
+    int a = 0;
+    int b = 0;
+    Counted() { live++; }
+    Counted(const Counted& o) : a(o.a), b(o.b) { live++; }
+    ~Counted() { live--; }
+};
+std::atomic<int> Counted::live{0};
+
+int main() {
+    log_info("Starting Versioned State Tests");
+
+    // Test 1: Updates publish new versions; false keeps the current one
+    {
+        common::VersionedState<Counted> state;
+        uint64_t v = state.update([](Counted& c) { c.a = c.b = 1; });
+        uint64_t same = state.update([](Counted& c) {
+            c.a = 5;
+            return false;
+        });
+        if (v != 2 || same != 2 || state.read()->a != 1 || state.version() != 2) {
+            log_error("Update test FAILED");
+            return 1;
+        }
+        log_info("Update test PASSED");
+    }
+
+    // Test 2: A pinned snapshot keeps its version alive until released
+    {
+        common::VersionedState<Counted> state;
+        {
+            auto snap = state.read();
+            for (int i = 1; i <= 3; ++i) state.update([i](Counted& c) { c.a = c.b = i; });
+            if (snap->a != 0 || snap.number() != 1 || state.retiredCount() != 3) {
+                log_error("Pinned snapshot test FAILED: " + std::to_string(state.retiredCount()) + " retired");
+                return 1;
+            }
+        }
+        state.update([](Counted& c) { c.a = c.b = 4; });
+        if (state.retiredCount() != 0) {
+            log_error("Pinned snapshot test FAILED: versions not reclaimed");
+            return 1;
+        }
+        log_info("Pinned snapshot test PASSED");
+    }
+    if (Counted::live != 0) {
+        log_error("Reclamation test FAILED: " + std::to_string(Counted::live.load()) + " versions leaked");
+        return 1;
+    }
+
+    // Test 3: Readers always see consistent versions under concurrent writers
+    {
+        common::VersionedState<Counted> state;
+        std::atomic_bool stop{false};
+        std::atomic<int> torn{0};
+        std::atomic<uint64_t> reads{0};
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 4; ++r) {
+            readers.emplace_back([&]() {
+                while (!stop) {
+                    auto snap = state.read();
+                    if (snap->a != snap->b) torn++;
+                    reads++;
+                }
+            });
+        }
+        std::vector<std::thread> writers;
+        for (int w = 0; w < 2; ++w) {
+            writers.emplace_back([&]() {
+                for (int i = 0; i < 5000; ++i) state.update([](Counted& c) { c.a = c.b = c.a + 1; });
+            });
+        }
+        for (auto& t : writers) t.join();
+        stop = true;
+        for (auto& t : readers) t.join();
+        if (torn != 0 || state.read()->a != 10000 || state.version() != 10001) {
+            log_error("Concurrent access test FAILED: " + std::to_string(torn.load()) + " torn reads");
+            return 1;
+        }
+        log_info("Concurrent access test PASSED (" + std::to_string(reads.load()) + " reads)");
+    }
+    if (Counted::live != 0) {
+        log_error("Reclamation test FAILED: " + std::to_string(Counted::live.load()) + " versions leaked");
+        return 1;
+    }
+    log_info("Reclamation test PASSED");
+
+    // Test 4: A slow writer does not delay readers
+    {
+        common::VersionedState<Counted> state;
+        std::thread writer([&]() {
+            state.update([](Counted& c) {
+                std::this_thread::sleep_for(300ms); // e.g. I/O done while building the version
+                c.a = c.b = 1;
+            });
+        });
+        std::this_thread::sleep_for(50ms);
+        auto t0 = Clock::now();
+        int seen = state.read()->a;
+        auto waited = Clock::now() - t0;
+        writer.join();
+        if (seen != 0 || waited > 100ms) {
+            log_error("Writer independence test FAILED");
+            return 1;
+        }
+        log_info("Writer independence test PASSED");
+    }
+
+    // Test 5: Threads that have finished reading do not keep reader slots, so
+    // more live threads than slots can still read
+    {
+        common::VersionedState<Counted> state;
+        std::atomic<int> done{0};
+        std::atomic_bool release{false};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 300; ++i) {
+            threads.emplace_back([&]() {
+                if (state.read()->a == 0) done++;
+                while (!release) std::this_thread::sleep_for(1ms);
+            });
+        }
+        auto deadline = Clock::now() + 5s;
+        while (done < 300 && Clock::now() < deadline) std::this_thread::sleep_for(1ms);
+        bool all_read = done == 300;
+        release = true;
+        for (auto& t : threads) t.join();
+        if (!all_read) {
+            log_error("Reader slot test FAILED: " + std::to_string(done.load()) + " of 300 threads read");
+            return 1;
+        }
+        log_info("Reader slot test PASSED");
+    }
+
+    log_info("All Versioned State Tests PASSED");
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "write_behind.hpp"
+#include "persistence.hpp"
+#include "logging.hpp"
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using json = nlohmann::json;
+using namespace std::chrono_literals;
+
+static common::WriteBehind::Options timing(std::chrono::milliseconds window, std::chrono::milliseconds max_delay) {
+    common::WriteBehind::Options opts;
+    opts.window = window;
+    opts.max_delay = max_delay;
+    return opts;
+}
+
+int main() {
+    log_info("Starting Write-Behind Tests");
+    const std::string file = "write_behind_test_state.json";
+    std::remove(file.c_str());
+
+    std::mutex state_mtx;
+    json state{{"volume", 0}};
+    auto snapshot = [&]() {
+        std::lock_guard<std::mutex> lk(state_mtx);
+        return state;
+    };
+
+    // Test 1: A burst of updates is coalesced into one write of the latest state
+    {
+        common::WriteBehind persist(file, snapshot, timing(50ms, 2000ms));
+        for (int v = 1; v <= 200; ++v) {
+            std::lock_guard<std::mutex> lk(state_mtx);
+            state["volume"] = v;
+            persist.markDirty();
+        }
+        std::this_thread::sleep_for(200ms);
+        if (persist.writes() != 1 || persist.updates() != 200 ||
+            Persistence::loadState(file).value("volume", 0) != 200) {
+            log_error("Write coalescing test FAILED: " + std::to_string(persist.writes()) + " writes");
+            return 1;
+        }
+        log_info("Write coalescing test PASSED");
+    }
+
+    // Test 2: Continuous updates are still written every max_delay
+    {
+        common::WriteBehind persist(file, snapshot, timing(50ms, 150ms));
+        auto end = std::chrono::steady_clock::now() + 600ms;
+        while (std::chrono::steady_clock::now() < end) {
+            {
+                std::lock_guard<std::mutex> lk(state_mtx);
+                state["volume"] = state["volume"].get<int>() + 1;
+                persist.markDirty();
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        uint64_t writes = persist.writes();
+        if (writes < 2 || writes > 6) {
+            log_error("Bounded delay test FAILED: " + std::to_string(writes) + " writes");
+            return 1;
+        }
+        log_info("Bounded delay test PASSED");
+    }
+
+    // Test 3: flush() and destruction write pending changes immediately
+    {
+        {
+            common::WriteBehind persist(file, snapshot, timing(10000ms, 10000ms));
+            {
+                std::lock_guard<std::mutex> lk(state_mtx);
+                state["volume"] = 7;
+            }
+            persist.markDirty();
+            persist.flush();
+            if (persist.writes() != 1 || Persistence::loadState(file).value("volume", 0) != 7) {
+                log_error("Flush test FAILED");
+                return 1;
+            }
+            {
+                std::lock_guard<std::mutex> lk(state_mtx);
+                state["volume"] = 9;
+            }
+            persist.markDirty();
+        }
+        if (Persistence::loadState(file).value("volume", 0) != 9) {
+            log_error("Write on shutdown test FAILED");
+            return 1;
+        }
+        log_info("Flush and shutdown test PASSED");
+    }
+
+    std::remove(file.c_str());
+    log_info("All write-behind tests PASSED");
+    return 0;
+}